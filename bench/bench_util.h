@@ -0,0 +1,77 @@
+// 各微基准共用的数据生成、计时与临时目录工具（仅供 bench/ 使用）
+#ifndef S3_BENCH_UTIL_H
+#define S3_BENCH_UTIL_H
+
+#include "meta/meta.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace bench {
+
+const int kOwners = 100;
+const int kBuckets = 1000;
+
+inline std::string owner_name(int i) { return "AKIAOWNER" + std::to_string(i % kOwners); }
+inline std::string bucket_name(int i) { return "bucket-" + std::to_string(i); }
+inline std::string object_key(long i) { return "photos/2024/" + std::to_string(i % 97) + "/img-" + std::to_string(i) + ".jpg"; }
+
+// 执行 f(0..iters-1)，返回每次的平均耗时（纳秒）
+template <class F>
+double ns_per_op(long iters, F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < iters; ++i) f(i);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(iters);
+}
+
+// 建 kBuckets 个桶，第 i 个名为 bucket_name(i)、属主为 owner(i)；返回按 i 排列的桶 id
+template <class OwnerFn>
+std::vector<int64_t> create_buckets(meta::MetaStore& store, OwnerFn&& owner) {
+    std::vector<int64_t> ids(kBuckets);
+    for (int i = 0; i < kBuckets; ++i) ids[i] = store.create_bucket(bucket_name(i), owner(i));
+    return ids;
+}
+
+// 写入第 i 个对象：object_key(i)，放在第 i % kBuckets 个桶，其余字段固定
+inline void put_object(meta::MetaStore& store, const std::vector<int64_t>& bucket_ids, long i) {
+    store.put_object(bucket_ids[i % kBuckets], object_key(i), 4096, "2024-10-01T00:00:00Z",
+                     "d41d8cd98f00b204e9800998ecf8427e", "/data/s3/objects/" + std::to_string(i), "private");
+}
+
+inline void put_objects(meta::MetaStore& store, const std::vector<int64_t>& bucket_ids, long from, long to) {
+    for (long i = from; i < to; ++i) put_object(store, bucket_ids, i);
+}
+
+// 在 /tmp 下新建 <name>.XXXXXX 目录，失败返回空串
+inline std::string make_temp_dir(const char* name) {
+    std::string tmpl = std::string("/tmp/") + name + ".XXXXXX";
+    if (!::mkdtemp(&tmpl[0])) {
+        std::perror("mkdtemp");
+        return std::string();
+    }
+    return tmpl;
+}
+
+// 删除目录下的文件（快照、日志等，不递归）及目录本身
+inline void remove_dir(const std::string& dir) {
+    if (DIR* d = ::opendir(dir.c_str())) {
+        while (struct dirent* e = ::readdir(d)) {
+            std::string name = e->d_name;
+            if (name != "." && name != "..") ::unlink((dir + "/" + name).c_str());
+        }
+        ::closedir(d);
+    }
+    ::rmdir(dir.c_str());
+}
+
+}
+
+#endif
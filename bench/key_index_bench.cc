@@ -0,0 +1,72 @@
+// 有序 key 索引（meta::KeyIndex）微基准：按不同叶子容量建索引，报告每 key 内存、随机 seek、
+// 顺序扫描与前缀计数的耗时，用于选择节点大小。
+// 用法：bench_key_index [key 数，默认 1000000] [每项查询次数，默认 200000]
+#include "bench_util.h"
+#include "meta/key_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// 形如 logs/2024/10/07/host-17/000123.gz 的 key：目录层级多、相邻 key 共享长前缀
+static std::string make_key(long i) {
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "logs/2024/%02ld/%02ld/host-%ld/%06ld.gz",
+                  1 + i % 12, 1 + (i / 12) % 28, (i / 336) % 64, i);
+    return buf;
+}
+
+using bench::ns_per_op;
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? std::atol(argv[1]) : 1000000L;
+    long iters = argc > 2 ? std::atol(argv[2]) : 200000L;
+    if (n <= 0 || iters <= 0) {
+        std::fprintf(stderr, "usage: %s [keys] [iters]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> keys(n);
+    size_t key_bytes = 0;
+    for (long i = 0; i < n; ++i) {
+        keys[i] = make_key(i);
+        key_bytes += keys[i].size();
+    }
+    std::mt19937_64 rng(7);
+    const long kSample = 4096;
+    std::vector<std::string> probes(kSample), prefixes(kSample);
+    for (long i = 0; i < kSample; ++i) {
+        const std::string& k = keys[rng() % static_cast<uint64_t>(n)];
+        probes[i] = k;
+        prefixes[i] = k.substr(0, k.find('/', 13) + 1);  // 到 day 一级目录
+    }
+
+    std::printf("keys=%ld avg_key_bytes=%.1f\n", n, static_cast<double>(key_bytes) / static_cast<double>(n));
+    std::printf("%6s %12s %12s %12s %14s %14s\n", "leaf", "bytes/key", "insert_ns", "seek_ns", "scan_ns/key", "count_pfx_ns");
+    volatile size_t sink = 0;
+    for (uint32_t leaf : {16u, 32u, 64u, 128u, 256u}) {
+        meta::KeyIndex index(leaf, 64);
+        std::vector<long> order(n);
+        for (long i = 0; i < n; ++i) order[i] = i;
+        std::shuffle(order.begin(), order.end(), rng);
+        double insert = ns_per_op(n, [&](long i) { index.insert(keys[order[i]], static_cast<uint32_t>(order[i])); });
+        double bytes = static_cast<double>(index.memory_usage()) / static_cast<double>(n);
+        double seek = ns_per_op(iters, [&](long i) { sink = sink + index.lower_bound(probes[i % kSample]).value(); });
+        auto t0 = std::chrono::steady_clock::now();
+        std::string k;
+        for (meta::KeyIndex::Iterator it = index.begin(); it.valid(); it.next()) {
+            it.key(k);
+            sink = sink + k.size();
+        }
+        double scan = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() /
+                      static_cast<double>(n);
+        double count = ns_per_op(iters, [&](long i) { sink = sink + index.count_prefix(prefixes[i % kSample]); });
+        std::printf("%6u %12.1f %12.1f %12.1f %14.1f %14.1f\n", leaf, bytes, insert, seek, scan, count);
+        std::fflush(stdout);
+    }
+    return sink == 0;
+}
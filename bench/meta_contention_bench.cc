@@ -0,0 +1,121 @@
+// MetaStore 并发基准：T 个读线程模拟 GET 请求的元数据路径（验签取 secret → 查桶 → 查对象），
+// 可选 1 个写线程不断 put_object + save()（写日志文件）并定期 checkpoint，
+// 报告读吞吐与读延迟分位数，用于确认读之间不互斥、写只阻塞同一条带上的读、落盘不阻塞读。
+// 用法：bench_meta_contention [最大读线程数，默认 64] [每档毫秒数，默认 1000] [预置对象数，默认 100000]
+#include "bench_util.h"
+#include "meta/meta.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench::kBuckets;
+using bench::bucket_name;
+using bench::object_key;
+
+static const char kAccessKey[] = "AKIAROOT";
+
+struct Result {
+    double reads_per_sec{0};
+    double writes_per_sec{0};
+    uint64_t p50_ns{0}, p99_ns{0}, max_ns{0};
+};
+
+static Result run(meta::MetaStore& store, const std::vector<int64_t>& bucket_ids, int readers, bool writer, int ms,
+                  long objects) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0}, writes{0};
+    std::vector<std::vector<uint32_t>> samples(readers);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < readers; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 rng(static_cast<uint64_t>(t) + 1);
+            meta::Bucket b;
+            meta::Object o;
+            uint64_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                long id = static_cast<long>(rng() % static_cast<uint64_t>(objects));
+                auto t0 = std::chrono::steady_clock::now();
+                bool ok = !store.get_secret_by_access_key(kAccessKey).empty() &&
+                          store.get_bucket_by_name_and_owner(bucket_name(static_cast<int>(id % kBuckets)), kAccessKey, b) &&
+                          store.get_object(b.id, object_key(id), o);
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+                if (!ok) std::abort();
+                if ((++n & 15) == 0) samples[t].push_back(static_cast<uint32_t>(std::min<int64_t>(ns, UINT32_MAX)));
+            }
+            reads.fetch_add(n);
+        });
+    }
+    if (writer) {
+        threads.emplace_back([&]() {
+            uint64_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                long id = static_cast<long>(n % static_cast<uint64_t>(objects));
+                bench::put_object(store, bucket_ids, id);
+                store.save();
+                if (++n % 50000 == 0) store.checkpoint();
+            }
+            writes.fetch_add(n);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop.store(true);
+    for (std::thread& th : threads) th.join();
+
+    std::vector<uint32_t> all;
+    for (const auto& s : samples) all.insert(all.end(), s.begin(), s.end());
+    std::sort(all.begin(), all.end());
+    Result r;
+    r.reads_per_sec = static_cast<double>(reads.load()) * 1000.0 / ms;
+    r.writes_per_sec = static_cast<double>(writes.load()) * 1000.0 / ms;
+    if (!all.empty()) {
+        r.p50_ns = all[all.size() / 2];
+        r.p99_ns = all[all.size() * 99 / 100];
+        r.max_ns = all.back();
+    }
+    return r;
+}
+
+int main(int argc, char** argv) {
+    int max_readers = argc > 1 ? std::atoi(argv[1]) : 64;
+    int ms = argc > 2 ? std::atoi(argv[2]) : 1000;
+    long objects = argc > 3 ? std::atol(argv[3]) : 100000L;
+    if (max_readers <= 0 || ms <= 0 || objects < kBuckets) {
+        std::fprintf(stderr, "usage: %s [max_readers] [ms] [objects>=%d]\n", argv[0], kBuckets);
+        return 1;
+    }
+    std::string dir = bench::make_temp_dir("bench_meta_contention");
+    if (dir.empty()) return 1;
+
+    meta::MetaStore store;
+    if (!store.load(dir)) return 1;
+    store.ensure_root_user(kAccessKey, "secret");
+    std::vector<int64_t> bucket_ids = bench::create_buckets(store, [](int) { return std::string(kAccessKey); });
+    bench::put_objects(store, bucket_ids, 0, objects);
+    store.checkpoint();
+
+    std::printf("objects=%ld hardware_threads=%u\n", objects, std::thread::hardware_concurrency());
+    std::printf("%8s %7s %14s %10s %10s %10s %12s\n", "readers", "writer", "reads/s", "p50_ns", "p99_ns", "max_us", "writes/s");
+    std::vector<int> counts;
+    for (int t = 1; t < max_readers; t *= 4) counts.push_back(t);
+    counts.push_back(max_readers);
+    for (int t : counts) {
+        for (bool writer : {false, true}) {
+            Result r = run(store, bucket_ids, t, writer, ms, objects);
+            std::printf("%8d %7s %14.0f %10llu %10llu %10.1f %12.0f\n", t, writer ? "yes" : "no", r.reads_per_sec,
+                        static_cast<unsigned long long>(r.p50_ns), static_cast<unsigned long long>(r.p99_ns),
+                        static_cast<double>(r.max_ns) / 1000.0, r.writes_per_sec);
+            std::fflush(stdout);
+        }
+    }
+
+    store.checkpoint();
+    bench::remove_dir(dir);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// 元数据快照加载基准：建 N 个对象后分别 checkpoint 成文本快照（s3_meta.dat）与二进制快照（s3_meta.snap），
+// 各用新的 MetaStore 加载若干次，报告文件大小与加载耗时（取最小值）。
+// 用法：bench_meta_load [对象数，默认 1000000] [每种格式加载次数，默认 3] [目录，默认新建于 /tmp]
+#include "bench_util.h"
+#include "meta/meta.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+using bench::kBuckets;
+
+static long file_size(const std::string& path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+// 加载 rounds 次，返回最短耗时（毫秒）；失败返回负数
+static double load_ms(const std::string& dir, int rounds, size_t expect) {
+    double best = -1;
+    for (int r = 0; r < rounds; ++r) {
+        meta::MetaStore store;
+        auto t0 = std::chrono::steady_clock::now();
+        if (!store.load(dir)) return -1;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        // 计时之外核对对象数（桶 id 按创建顺序为 1..kBuckets）
+        size_t loaded = 0;
+        for (int64_t id = 1; id <= kBuckets; ++id) loaded += store.list_objects(id).size();
+        if (loaded != expect) {
+            std::fprintf(stderr, "loaded %zu objects, expected %zu\n", loaded, expect);
+            return -1;
+        }
+        if (best < 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? std::atol(argv[1]) : 1000000L;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+    std::string dir;
+    bool own_dir = argc <= 3;
+    if (!own_dir) {
+        dir = argv[3];
+    } else {
+        dir = bench::make_temp_dir("bench_meta_load");
+        if (dir.empty()) return 1;
+    }
+    if (n <= 0 || rounds <= 0) {
+        std::fprintf(stderr, "usage: %s [objects] [rounds] [dir]\n", argv[0]);
+        return 1;
+    }
+
+    {
+        meta::MetaStore store;
+        if (!store.load(dir)) return 1;
+        std::vector<int64_t> bucket_ids = bench::create_buckets(store, bench::owner_name);
+        bench::put_objects(store, bucket_ids, 0, n);
+        store.set_snapshot_format(meta::SnapshotFormat::text);
+        if (!store.checkpoint()) return 1;
+    }
+    long text_bytes = file_size(dir + "/s3_meta.dat");
+    double text_ms = load_ms(dir, rounds, static_cast<size_t>(n));
+
+    // 文本快照转为二进制（与换回 S3_META_SNAPSHOT_FORMAT=binary 后的首次 checkpoint 相同）
+    {
+        meta::MetaStore store;
+        if (!store.load(dir)) return 1;
+        store.set_snapshot_format(meta::SnapshotFormat::binary);
+        if (!store.checkpoint()) return 1;
+    }
+    long binary_bytes = file_size(dir + "/s3_meta.snap");
+    double binary_ms = load_ms(dir, rounds, static_cast<size_t>(n));
+
+    std::printf("objects=%ld dir=%s\n", n, dir.c_str());
+    std::printf("%8s %14s %12s\n", "format", "bytes", "load_ms");
+    std::printf("%8s %14ld %12.1f\n", "text", text_bytes, text_ms);
+    std::printf("%8s %14ld %12.1f\n", "binary", binary_bytes, binary_ms);
+    if (own_dir) bench::remove_dir(dir);
+    return text_ms < 0 || binary_ms < 0;
+}
@@ -0,0 +1,74 @@
+// MetaStore 点查微基准：对象数从 1k 增长到上限，每一档测 get_object（命中 / 未命中）与
+// get_bucket_by_name_and_owner 的单次耗时，用于确认点查耗时不随对象数增长。
+// 用法：bench_meta_lookup [最大对象数，默认 10000000] [每档查询次数，默认 1000000]
+#include "bench_util.h"
+#include "meta/meta.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using bench::kBuckets;
+using bench::bucket_name;
+using bench::ns_per_op;
+using bench::object_key;
+using bench::owner_name;
+
+int main(int argc, char** argv) {
+    long max_objects = argc > 1 ? std::atol(argv[1]) : 10000000L;
+    long iters = argc > 2 ? std::atol(argv[2]) : 1000000L;
+    if (max_objects < 1000 || iters <= 0) {
+        std::fprintf(stderr, "usage: %s [max_objects>=1000] [iters]\n", argv[0]);
+        return 1;
+    }
+
+    meta::MetaStore store;
+    std::vector<int64_t> bucket_ids = bench::create_buckets(store, owner_name);
+
+    std::printf("%12s %14s %14s %14s\n", "objects", "get_hit_ns", "get_miss_ns", "bucket_ns");
+    std::mt19937_64 rng(42);
+    long n = 0;
+    volatile long sink = 0;
+    // 每档对象数为上一档的 10 倍，最后一档为 max_objects
+    for (long target = 1000;; target = std::min(target * 10, max_objects)) {
+        bench::put_objects(store, bucket_ids, n, target);
+        n = target;
+
+        // 查询参数预先生成，计时只含查找本身
+        const long kSample = 4096;
+        std::vector<std::string> hit_keys(kSample), miss_keys(kSample);
+        std::vector<int64_t> hit_buckets(kSample);
+        std::vector<int> bucket_idx(kSample);
+        for (long i = 0; i < kSample; ++i) {
+            long id = static_cast<long>(rng() % static_cast<uint64_t>(n));
+            hit_keys[i] = object_key(id);
+            hit_buckets[i] = bucket_ids[id % kBuckets];
+            miss_keys[i] = object_key(id) + ".missing";
+            bucket_idx[i] = static_cast<int>(rng() % kBuckets);
+        }
+        std::vector<std::string> bucket_names(kBuckets), owners(kBuckets);
+        for (int i = 0; i < kBuckets; ++i) { bucket_names[i] = bucket_name(i); owners[i] = owner_name(i); }
+
+        meta::Object o;
+        meta::Bucket bk;
+        double hit = ns_per_op(iters, [&](long i) {
+            long j = i % kSample;
+            if (store.get_object(hit_buckets[j], hit_keys[j], o)) sink = sink + 1;
+        });
+        double miss = ns_per_op(iters, [&](long i) {
+            long j = i % kSample;
+            if (store.get_object(hit_buckets[j], miss_keys[j], o)) sink = sink + 1;
+        });
+        double bucket = ns_per_op(iters, [&](long i) {
+            int b = bucket_idx[i % kSample];
+            if (store.get_bucket_by_name_and_owner(bucket_names[b], owners[b], bk)) sink = sink + 1;
+        });
+        std::printf("%12ld %14.1f %14.1f %14.1f\n", n, hit, miss, bucket);
+        std::fflush(stdout);
+        if (n == max_objects) break;
+    }
+    return sink < 0;
+}
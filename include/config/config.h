@@ -14,6 +14,27 @@ struct Config {
     uint16_t    listen_port{8080};
     uint32_t    buffer_payload_size{65536};  //  缓冲区大小，单块 64KB
     uint32_t    buffer_count{1024}; // 缓冲区数量
+    std::string io_mode{"thread"};   // 网络模型："thread" 工作线程池，"uring" io_uring 事件循环
+    uint32_t    event_loops{2};      // io_mode=uring 时的事件循环线程数（不足 listeners 时按 listeners 启动）
+    uint32_t    recv_buffers{32};    // io_mode=uring 时每个事件循环借给内核收数据的 pool unit 数（向下取 2 的幂）
+    uint32_t    work_threads{4};     // io_mode=uring 时每个事件循环执行阻塞工作（请求处理、文件读写、等待落盘）的线程数，也是每个循环可同时加入组提交的请求数
+    uint32_t    worker_threads{32};  // io_mode=thread 时的工作线程数
+    uint32_t    accept_queue_depth{1024};  // 已 accept、等待工作线程的连接队列上限
+    uint32_t    listeners{1};        // SO_REUSEPORT 监听 socket 数；>1 时每个 socket 一组 accept 线程 + 工作线程
+    uint32_t    listen_backlog{1024};  // listen() backlog
+    uint32_t    tcp_defer_accept{0};   // TCP_DEFER_ACCEPT 秒数，0 关闭
+    uint32_t    keepalive_timeout_ms{5000};   // keep-alive 连接两次请求之间的最长空闲，0 关闭 keep-alive
+    uint32_t    request_timeout_ms{30000};    // 收请求头与 body 时单次等待数据的最长时间（含新连接上的第一个请求），超时关闭连接；0 不限
+    uint32_t    keepalive_max_requests{100};  // 单连接最多处理的请求数，之后回 Connection: close；0 关闭 keep-alive
+    uint32_t    upload_window{8};    // 流式上传时同时在途的 io_uring 写数（每个最多一个 buffer 大小）
+    uint32_t    download_window{4};  // GET 时预读（在途 io_uring read）的段数，每段一个 buffer
+    std::string etag_hash{"md5"};    // 上传时的 ETag："md5" 增量计算内容 MD5；"none" 不读数据，用版本标签（带 Content-MD5 的上传仍计算 MD5 校验）
+    std::string durability{"none"};  // 落盘保证："none" 不 fsync；"fdatasync" 回应前对象数据 fdatasync；"full" 另 fsync 所在目录与元数据日志
+    uint32_t    commit_window_us{0}; // durability 非 none 时组提交每批额外收集请求的微秒数，0 为只合并上一批在途期间到达的请求
+    uint32_t    meta_checkpoint_bytes{64u << 20};  // 元数据日志累计超过该字节数时后台 checkpoint 成新快照，0 只在退出时 checkpoint
+    std::string meta_snapshot_format{"binary"};  // checkpoint 写的快照格式："binary" 可 mmap 并行加载的 s3_meta.snap；"text" 为 s3_meta.dat
+    bool        zero_copy{true};     // GET 对象内容用 sendfile / io_uring splice 发送，不经用户态缓冲
+    bool        pin_cpus{false};     // 是否把每组 accept/工作线程绑到本组的核区间（uring 为每个事件循环绑一核）
 };
 
 // 从环境变量加载，缺省使用默认值
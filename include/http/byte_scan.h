@@ -0,0 +1,30 @@
+#ifndef S3_HTTP_BYTE_SCAN_H
+#define S3_HTTP_BYTE_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace http {
+
+// 在 [p, end) 中找第一个等于 c 的字节，没有返回 nullptr。SSE2 可用时每次比较 16 字节（头部扫描 CR/LF/冒号用）
+inline const char* find_byte(const char* p, const char* end, char c) {
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+        if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+        p += 16;
+    }
+#endif
+    if (p >= end) return nullptr;
+    return static_cast<const char*>(std::memchr(p, c, static_cast<size_t>(end - p)));
+}
+
+}
+
+#endif
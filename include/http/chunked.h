@@ -0,0 +1,42 @@
+#ifndef S3_HTTP_CHUNKED_H
+#define S3_HTTP_CHUNKED_H
+
+#include <cstdint>
+
+struct x_msg_t;
+class x_buf_pool_t;
+
+namespace http {
+
+// Transfer-Encoding: chunked 请求体的增量解码器。跨 recv 保留帧状态（块大小行、块尾 CRLF、trailer），
+// 块数据不拷贝，以视图方式追加到调用方的 body；分帧字节逐个看，数据字节整段跳过。
+// 块扩展与 trailer 字段被忽略。
+class ChunkedDecoder {
+public:
+    enum class Status { NeedMore, Done, Error };
+
+    // 从 in 的 offset 处继续解码，直到 in 用完或整个消息（含 trailer 与结尾空行）结束。
+    // 解出的数据以视图追加到 body；返回时 offset 前进到已解码的位置（Done 时即消息结尾，其后可能是流水线的下一个请求）。
+    Status decode(const x_msg_t& in, uint32_t& offset, x_msg_t& body);
+
+    uint64_t body_size() const { return body_size_; }   // 已解出的数据字节数
+    void reset();
+
+private:
+    enum class State { Size, Ext, SizeLF, Data, DataCR, DataLF, TrailerStart, TrailerLine, TrailerLF, Done };
+
+    State state_{State::Size};
+    uint64_t chunk_left_{0};   // Size 状态下为正在累积的块大小，Data 状态下为块内剩余字节
+    uint32_t digits_{0};       // 当前块大小行已读的十六进制位数
+    uint32_t line_len_{0};     // 当前块大小行 / trailer 的字节数（防止无界的行）
+    uint64_t body_size_{0};
+};
+
+// 编码：把 data 作为一个块（十六进制长度行 + 数据 + CRLF）拷贝追加到 out；len 为 0 时不追加。池耗尽返回 false。
+bool append_chunk(x_msg_t& out, x_buf_pool_t& pool, const char* data, uint32_t len);
+// 追加结束块 0\r\n\r\n（无 trailer）
+bool append_last_chunk(x_msg_t& out, x_buf_pool_t& pool);
+
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef S3_HTTP_HEADER_SCANNER_H
+#define S3_HTTP_HEADER_SCANNER_H
+
+#include <cstdint>
+
+struct x_msg_t;
+
+namespace http {
+
+// 增量查找请求头结尾 \r\n\r\n：跨 recv 保留扫描位置和最近 3 个字节，每次只看新到达的字节，
+// 按 segment 直接扫描 unit 内存（不线性化，SSE2 找 \n）。总代价 O(头部长度)，与 recv 次数无关。
+// 找到后给出头部长度（含 \r\n\r\n），即 body 在 msg 中的起始偏移，后续解析与取 body 不再查找。
+class HeaderScanner {
+public:
+    // 继续扫描 msg 的前 limit 字节中尚未看过的部分。找到结尾返回头部长度，否则返回 0。
+    // 两次调用之间 msg 只能在尾部追加（头部出队后须 reset）。
+    uint32_t scan(const x_msg_t& msg, uint32_t limit);
+
+    uint32_t header_length() const { return header_len_; }  // 0 表示尚未找到
+    uint32_t scanned() const { return scanned_; }           // 已扫描的字节数
+    void reset();
+
+private:
+    uint32_t scanned_{0};
+    uint32_t header_len_{0};
+    uint32_t recent_{0};   // 已扫描的最后 3 个字节，最低字节为最后一个（判定跨 segment 的结尾）
+};
+
+}
+
+#endif
@@ -2,14 +2,18 @@
 #define S3_HTTP_PARSER_H
 
 #include "http/http_request.h"
+#include <cstdint>
 
 struct x_msg_t;
 class x_buf_pool_t;
 
 namespace http {
 
-// 从 x_msg_t 中解析 HTTP 请求，填充 req。返回 true 表示解析成功（含完整请求头）。
-bool parse_request(const x_msg_t& msg, HttpRequest& req);
+// 解析 msg 前 header_len 字节（完整请求头，含结尾空行，由 HeaderScanner 给出）中的 HTTP 请求，填充 req。
+// 不拷贝、不分配：req 的字段与头表是指向 unit 的视图（req 持有 unit 引用，msg 随后可出队）；
+// 仅当请求头跨 unit 或路径需规范化时写入 req 自带的缓冲。之后的 body 不会被读取。返回 true 表示解析成功。
+// Content-Length 为空、含非数字、溢出或多个值互相矛盾时返回 false（调用方回 400 并关闭连接）。
+bool parse_request(const x_msg_t& msg, uint32_t header_len, HttpRequest& req);
 
 // 规范化路径：去掉多余 /，禁止 ..
 void normalize_path(std::string& path);
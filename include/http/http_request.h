@@ -1,28 +1,71 @@
 #ifndef S3_HTTP_REQUEST_H
 #define S3_HTTP_REQUEST_H
 
+#include <cstdint>
 #include <string>
-#include <vector>
-#include <map>
+#include <string_view>
+
+#include "msg/msg_buffer4.h"
 
 namespace http {
 
+// 一个请求头（名与值均为视图，值已去掉首尾空白）
+struct HeaderField {
+    std::string_view name;
+    std::string_view value;
+};
+
+// 解析结果。字符串字段都是视图：指向请求头所在的 pool unit（由 hold_ 持有引用），
+// 头部跨 unit 时指向 linear_，路径需规范化时指向 path_buf_。视图在下一次 parse_request 或析构前有效。
+// 缓冲在 keep-alive 连接上的多次请求间复用容量，稳态下解析不分配内存。
 struct HttpRequest {
-    std::string method;              // GET, PUT, DELETE
-    std::string path;                // URI 路径（不含 query），已规范化，如 /bucket 或 /bucket/obj
-    std::string query;               // 原始 query 字符串（含 ? 后的部分，不含 ?）
-    std::string host;
-    std::string content_type;
-    std::string content_md5;
+    static const uint32_t kMaxHeaders = 64;
+
+    std::string_view method;         // GET, PUT, DELETE
+    std::string_view path;           // URI 路径（不含 query），已规范化，如 /bucket 或 /bucket/obj
+    std::string_view query;          // 原始 query 字符串（含 ? 后的部分，不含 ?）
+    std::string_view version;        // 如 HTTP/1.1
+    std::string_view host;
+    std::string_view content_type;
+    std::string_view content_md5;
+    std::string_view connection;     // Connection 头原值，如 keep-alive / close
+    std::string_view transfer_encoding;  // Transfer-Encoding 头原值
     int64_t     content_length{-1};  // 请求体长度，-1 表示未给出
 
+    HeaderField headers[kMaxHeaders];  // 完整请求头表（按出现顺序）
+    uint32_t    header_count{0};
+
+    HttpRequest() = default;
+    HttpRequest(const HttpRequest&) = delete;
+    HttpRequest& operator=(const HttpRequest&) = delete;
+
+    // 按名（不区分大小写）取第一个同名头的值，没有返回空
+    std::string_view header(std::string_view name) const;
+
     // 从 query 字符串中按 key 取值（用于 AWSAccessKeyId, Signature, Expires 等）
-    std::string get_query_param(const std::string& key) const;
+    std::string get_query_param(std::string_view key) const;
+
+    // 是否要求保持连接：HTTP/1.1 默认保持（除非 Connection: close），HTTP/1.0 需显式 Connection: keep-alive
+    bool wants_keep_alive() const;
+
+    // 是否带 Expect: 100-continue（HTTP/1.0 请求忽略）
+    bool expects_continue() const;
+
+    // body 是否为 chunked 编码（Transfer-Encoding 的最后一个编码为 chunked）。此时忽略 content_length
+    bool is_chunked() const;
 
     // 路径是否视为桶：路径以 / 结束或只有一层（废弃：使用新规则）
     bool is_bucket_path() const;
+
+    // 以下由 parse_request 管理
+    x_msg_t     hold_;       // 请求头所在 unit 的引用，保证视图有效
+    std::string linear_;     // 请求头跨 unit 时的线性副本
+    std::string path_buf_;   // 规范化后的路径（原路径已规范时不用）
 };
 
+// 不区分大小写比较 ASCII 串
+bool iequals(std::string_view a, std::string_view b);
+
 }
 
 #endif
@@ -0,0 +1,30 @@
+#ifndef S3_HTTP_RANGE_H
+#define S3_HTTP_RANGE_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace http {
+
+// 对象内的一个字节区间 [first, first+length)
+struct ByteRange {
+    uint64_t first{0};
+    uint64_t length{0};
+};
+
+enum class RangeResult {
+    None,            // 无 Range 头或语法无法识别：按整个对象响应（RFC 7233 要求忽略）
+    Satisfiable,     // out 中至少一个区间落在对象内
+    Unsatisfiable,   // 语法正确但所有区间都在对象之外：416
+};
+
+// 单个请求最多接受的区间数，超过则忽略 Range（避免大量小区间放大响应）
+const size_t kMaxRanges = 32;
+
+// 解析 Range 头（bytes=a-b, c-, -n）。区间按对象大小 size 截断，越界的区间被丢弃，保持请求中的顺序。
+RangeResult parse_range(std::string_view header, uint64_t size, std::vector<ByteRange>& out);
+
+}
+
+#endif
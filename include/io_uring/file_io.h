@@ -2,20 +2,139 @@
 #define S3_IO_URING_FILE_IO_H
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
-#include <sys/types.h>  
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "msg/msg_buffer4.h"
 
 namespace uring {
 
-// 使用 io_uring 读整个文件到 buf（最多 capacity 字节）。
-// 成功返回读到的字节数，失败返回 -1。
-ssize_t read_file(const std::string& path, void* buf, size_t capacity);
+// 使用 io_uring 从 offset 起读 path 到 buf（最多 capacity 字节，只读这么多）。
+// 成功返回读到的字节数（到文件尾时可能少于 capacity），失败返回 -1。
+ssize_t read_file(const std::string& path, void* buf, size_t capacity, uint64_t offset = 0);
 
-// 使用 io_uring 将 buf 的 size 字节写入 path（创建或截断）。
+// 使用 io_uring 将 buf 的 size 字节写入 path（创建或截断）；sync 为 true 时关闭前经组提交 fdatasync。
 // 成功返回写入的字节数（应为 size），失败返回 -1。
-ssize_t write_file(const std::string& path, const void* buf, size_t size);
+ssize_t write_file(const std::string& path, const void* buf, size_t size, bool sync = false);
+
+// 并发删除一批文件：最多 window 个 IORING_OP_UNLINKAT 同时在途（内核不支持该操作时退回 unlink）。
+// results[i] 为 paths[i] 的结果：0 或 -errno
+void unlink_files(const std::vector<std::string>& paths, std::vector<int>& results, uint32_t window = 32);
+
+// 组提交：启动后台提交线程（独占一个 io_uring）。各线程的同步请求先排队，提交线程每次取走队列中的全部请求，
+// 同一 fd 只同步一次，各 fd 的 IORING_OP_FSYNC 一次提交、全部完成后统一唤醒这一批的等待者；
+// 一批在途时新到的请求积累成下一批。window_us > 0 时每批开始前再多等这么久收集请求。
+// 批次大小与 fsync 耗时计入 commit.* 计数器。
+void start_group_commit(uint32_t window_us = 0);
+// 处理完已排队的请求后停止提交线程；之后 sync_files 退回在调用线程上直接 fsync
+void stop_group_commit();
+
+// 阻塞到 fds 中每个 fd 在本次调用之后都同步过。datasync 为 true 时为 fdatasync 语义（数据与文件长度），
+// 否则为 fsync（含全部 inode 元数据）。调用方须保证 fd 在返回前有效。全部成功返回 true，否则 errno 有效
+bool sync_files(const std::vector<int>& fds, bool datasync);
+// 逐个以只读方式打开 paths（文件或目录）后经 sync_files 同步，用于 rename 后同步文件及其所在目录
+bool sync_paths(const std::vector<std::string>& paths, bool datasync);
+
+// 一次异步文件操作的完成状态（内部使用，sqe 的 user_data 指向它）
+struct FileOp {
+    int  res{0};
+    bool done{true};
+};
+
+// 流式写文件：按递增偏移提交 io_uring writev，最多 window 个写在途。
+// 写入的数据以视图方式持有（x_msg_t 共享 unit 引用），写完成后才释放，因此调用方可立即丢弃自己的那份。
+// 使用本线程的文件 ring（与 read_file/write_file 共用），同一线程上可同时存在多个 FileWriter。
+class FileWriter {
+public:
+    explicit FileWriter(uint32_t window = 8);
+    ~FileWriter();  // 未 finish 时等待在途写完成后关闭（不删除文件）
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    // 创建或截断 path。失败返回 false（errno 有效）。
+    bool open(const std::string& path);
+
+    // 把 data 的全部字节追加到文件末尾（不拷贝）。窗口满时阻塞等待最早的写完成。
+    // 之前的写出错时返回 false。
+    bool append(const x_msg_t& data);
+
+    // 等待全部写完成并关闭文件，全部成功返回 true
+    bool finish();
+
+    uint64_t size() const { return offset_; }       // 已提交的字节数
+    uint32_t max_inflight() const { return max_inflight_; }  // 本次写入过程中同时在途的写数峰值
+
+private:
+    static const size_t kMaxIov = 64;
+
+    struct Slot {
+        FileOp op;
+        x_msg_t data;            // 持有在途写的数据
+        uint32_t expected{0};
+        struct iovec iov[kMaxIov];
+    };
+
+    uint32_t window_;
+    std::unique_ptr<Slot[]> slots_;
+    int fd_{-1};
+    bool failed_{false};
+    uint64_t offset_{0};
+    uint32_t max_inflight_{0};
+
+    bool submit(const x_msg_t& data, uint32_t offset, uint32_t len);
+    Slot* free_slot();
+    bool reap(Slot& slot);       // 等待 slot 完成并检查结果
+    uint32_t inflight() const;
+};
+
+// 流式读文件：把 [offset, offset+length) 按 pool unit 大小分段读入，保持最多 window 个 io_uring read 在途（预读）。
+// 读完的段以 unit 的形式交给调用方（零拷贝追加到 x_msg_t），随后立即为后面的段补交读请求。
+class FileReader {
+public:
+    FileReader(x_buf_pool_t& pool, uint32_t window = 4);
+    ~FileReader();  // 等待在途读完成后关闭
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    // 打开 path 并开始预读。失败返回 false（errno 有效）。
+    bool open(const std::string& path, uint64_t offset, uint64_t length);
+    // 在调用方已打开的 fd 上开始预读（不接管 fd，调用方须保证其在 FileReader 析构前有效）
+    bool open(int fd, uint64_t offset, uint64_t length);
+
+    // 把下一段（必要时等待）及其后已经读完的段追加到 out，合计不超过 max_bytes（至少一段）。
+    // 返回追加的字节数；0 表示已全部读完；-1 表示读失败、文件比预期短或池耗尽。
+    int64_t next(x_msg_t& out, uint32_t max_bytes);
+
+    uint64_t remaining() const { return length_ - delivered_; }
+
+private:
+    struct Slot {
+        FileOp op;
+        x_buf_ptr unit;
+        uint32_t len{0};
+    };
+
+    x_buf_pool_t& pool_;
+    uint32_t window_;
+    std::unique_ptr<Slot[]> slots_;   // 环形：head_ 为下一段要交付的槽
+    uint32_t head_{0};
+    uint32_t queued_{0};              // 已提交（在途或已完成未交付）的段数
+    int fd_{-1};
+    bool owns_fd_{false};
+    uint64_t offset_{0};              // 下一个要提交的读的文件偏移
+    uint64_t end_{0};
+    uint64_t length_{0};
+    uint64_t delivered_{0};
+
+    void fill();                      // 补交读请求直到窗口满或读到末尾
+    void drain();
+};
 
-} 
+}
 
 #endif
@@ -0,0 +1,89 @@
+#ifndef S3_META_KEY_INDEX_H
+#define S3_META_KEY_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace meta {
+
+// 单个桶的有序 key 索引：B+ 树，key -> uint32_t（MetaStore 中为 objects_ 下标）。
+// 叶子做前缀压缩：叶内 key 的公共前缀只存一份，后缀首尾相接存于一块连续缓冲，叶子间以链表相连供顺序扫描；
+// 内部节点的分隔 key 取能区分左右子树的最短前缀，并记录各子树的 key 数，
+// 因此 seek、rank（小于某 key 的条目数）与前缀计数都是 O(log n)。
+// 节点容量可调（leaf_max / inner_max），memory_usage() 用于按 key 数评估节点大小。非线程安全，由调用方加锁。
+class KeyIndex {
+    struct Node;
+    struct Leaf;
+    struct Inner;
+
+public:
+    explicit KeyIndex(uint32_t leaf_max = 64, uint32_t inner_max = 64);
+    ~KeyIndex();
+    KeyIndex(KeyIndex&& other) noexcept;
+    KeyIndex& operator=(KeyIndex&& other) noexcept;
+    KeyIndex(const KeyIndex&) = delete;
+    KeyIndex& operator=(const KeyIndex&) = delete;
+
+    // 插入 key；已存在时不修改并返回 false
+    bool insert(std::string_view key, uint32_t value);
+    // 修改已存在 key 的值；不存在返回 false
+    bool assign(std::string_view key, uint32_t value);
+    bool erase(std::string_view key);
+    bool find(std::string_view key, uint32_t& value) const;
+    // 用严格递增的 keys（与 values 一一对应）整体重建，自底向上把节点填满、不逐个插入分裂，用于加载快照。
+    // keys 不是严格递增时返回 false，索引不变
+    bool build_sorted(const std::vector<std::string_view>& keys, const std::vector<uint32_t>& values);
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // 小于 key 的条目数
+    size_t rank(std::string_view key) const;
+    // 以 prefix 开头的条目数
+    size_t count_prefix(std::string_view prefix) const;
+
+    // 节点与缓冲按容量计的堆内存（字节）
+    size_t memory_usage() const;
+
+    // 顺序迭代器：默认构造即末尾；索引被修改后失效
+    class Iterator {
+    public:
+        Iterator() = default;
+        bool valid() const { return leaf_ != nullptr; }
+        std::string key() const;
+        void key(std::string& out) const;  // 复用 out 的容量
+        uint32_t value() const;
+        bool has_prefix(std::string_view prefix) const;  // 不拼出完整 key
+        void next();
+
+    private:
+        friend class KeyIndex;
+        Iterator(const Leaf* leaf, uint32_t pos);
+        const Leaf* leaf_{nullptr};
+        uint32_t pos_{0};
+    };
+
+    Iterator begin() const;
+    Iterator lower_bound(std::string_view key) const;  // 第一个 >= key
+    Iterator upper_bound(std::string_view key) const;  // 第一个 > key
+
+private:
+    uint32_t leaf_max_;
+    uint32_t inner_max_;
+    size_t size_{0};
+    std::unique_ptr<Node> root_;
+
+    static size_t count_of(const Node* n);  // 子树的 key 数
+    const Leaf* find_leaf(std::string_view key, size_t* rank) const;
+    bool insert_rec(Node* n, std::string_view key, uint32_t value, std::unique_ptr<Node>& split, std::string& sep);
+    bool erase_rec(Node* n, std::string_view key);
+    void rebalance(Inner* parent, uint32_t i);
+    bool underflow(const Node* n) const;
+};
+
+}
+
+#endif
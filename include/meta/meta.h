@@ -4,8 +4,21 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <functional>
+#include <memory>
 #include <cstdint>
 #include <mutex>
+#include <shared_mutex>
+#include <pthread.h>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#include "meta/key_index.h"
+#include "meta/object_table.h"
 
 namespace meta {
 
@@ -28,6 +41,15 @@ struct Object {
     std::string acl;
 };
 
+// 分页列表的一页：objects 与 common_prefixes 各自按字典序，合计不超过 max_keys；
+// truncated 时 next_marker 为本页最后一项（对象 key 或公共前缀），作为下一页的 start_after
+struct ListPage {
+    std::vector<Object> objects;
+    std::vector<std::string> common_prefixes;
+    bool truncated{false};
+    std::string next_marker;
+};
+
 // 用户：access_key 唯一；secret 仅存于服务端 user.dat，不发给客户端
 struct User {
     int64_t id{0};
@@ -36,39 +58,73 @@ struct User {
     std::string created_at;
 };
 
+// 快照格式：binary 为 <data_root>/s3_meta.snap（定长记录 + 字符串堆，mmap 后直接建索引）；
+// text 为 <data_root>/s3_meta.dat（行式文本），作为导入 / 导出格式保留
+enum class SnapshotFormat { binary, text };
+
 // 元数据存储
-// 文件路径：<data_root>/s3_meta.dat；首行 N\t<bucket_next_id>\t<object_next_id>；
+// 文本快照：<data_root>/s3_meta.dat；首行 N\t<bucket_next_id>\t<object_next_id>；
 // 桶行 B\t<id>\t<name>\t<created_at>\t<owner_id>；对象行 O\t<id>\t<bucket_id>\t<key>\t<size>\t<last_modified>\t<etag>\t<storage_path>\t<acl>；字段禁止 \t \n；写回先写临时文件再 rename。
+// 二进制快照：<data_root>/s3_meta.snap，布局见 元数据.md；两种都在时读二进制的。
+// 变更日志：<data_root>/s3_meta.journal.<gen>，每次变更追加一行，save() 只写日志；checkpoint 把日志折叠进新快照。
 class MetaStore {
 public:
     MetaStore() = default;
-    ~MetaStore() = default;
+    ~MetaStore();  // 停止后台 checkpoint 线程（不做最后一次 checkpoint）
     MetaStore(const MetaStore&) = delete;
     MetaStore& operator=(const MetaStore&) = delete;
 
-    // 初始化：设置 data_root，并从 <data_root>/s3_meta.dat 加载桶与对象（不读 user.dat）
+    // 初始化：设置 data_root，从快照（s3_meta.snap，没有时 s3_meta.dat）加载桶与对象，再按 gen 升序重放各代日志（不读 user.dat）
     bool load(const std::string& data_root);
+    // checkpoint 写哪种快照（默认 binary），应在 load 之前设置。磁盘上的快照是另一种格式时，下次 checkpoint 即使没有变更也会
+    // 转写一次并删除旧格式的文件，因此切到 text 再 checkpoint 即导出文本，切回 binary 即导入
+    void set_snapshot_format(SnapshotFormat format) { snapshot_format_ = format; }
     // 从 <data_root>/user.dat 加载用户列表与 secret；应在 ensure_root_user() 之后调用
     bool load_user_dat();
 
-    // 持久化：将内存数据按行式格式写回 <data_root>/s3_meta.dat（经临时文件 s3_meta.dat.tmp 再 rename）
+    // 持久化：把自上次 save() 以来各变更的日志记录追加到当前一代日志（代价与变更数成正比，与库大小无关）
     bool save();
+    // 把当前状态写成新快照（s3_meta.snap 或 s3_meta.dat，以及 user.dat，fdatasync 后 rename），成功后删除已折叠的日志。
+    // 先换到新一代日志，再按桶、按 key 分批持锁读取对象，写快照期间不阻塞其他请求
+    bool checkpoint();
+    // 后台线程：日志累计超过 journal_bytes 时做 checkpoint（0 不启动）；stop 时停线程并做最后一次 checkpoint
+    void start_checkpointer(uint64_t journal_bytes);
+    void stop_checkpointer();
+    // 设置后 save() 在写入日志后不持锁调用 fn 同步日志文件（当前一代及已封存、尚未折叠进快照的各代），
+    // fn 成功后才返回 true；并发的 save() 由 fn 合并成组提交。不设置时 save() 不 fsync。应在开始服务前设置
+    void set_journal_sync(std::function<bool(const std::vector<int>& fds)> fn) { journal_sync_ = std::move(fn); }
     // save() 失败时原因（供日志），调用 save() 后立即读
     const std::string& last_save_error() const { return last_save_error_; }
 
     // 桶：按 (name, owner_id) 查，同一用户同名桶在 s3_meta.dat 只记一条；创建返回 id，已存在返回 0
-    const Bucket* get_bucket_by_name_and_owner(const std::string& name, const std::string& owner_id) const;
+    // 查询均返回拷贝：锁释放后 buckets_ 与条带对象表中的元素可能被移动
+    bool get_bucket_by_name_and_owner(const std::string& name, const std::string& owner_id, Bucket& out) const;
     std::vector<Bucket> list_buckets_by_owner(const std::string& owner_id) const;
     int64_t create_bucket(const std::string& name, const std::string& owner_id);
     bool delete_bucket(int64_t bucket_id);
 
     // 对象：按 bucket_id+key 查；按 bucket_id 列表；插入或覆盖（同一 bucket_id+key）；删除
+    // list_objects 按 key 字典序返回桶内全部对象
     bool get_object(int64_t bucket_id, const std::string& key, Object& out) const;
     std::vector<Object> list_objects(int64_t bucket_id) const;
+    bool has_objects(int64_t bucket_id) const;
+    // 分页列表：只返回以 prefix 开头、字典序大于 start_after 的条目，最多 max_keys 项。
+    // delimiter 非空时，prefix 之后含 delimiter 的 key 折叠为公共前缀（到 delimiter 为止，含 delimiter），每个只计一项。
+    // 在有序 key 索引上 seek，代价与页大小成正比，与桶内对象数无关（每个公共前缀多一次 O(log n) seek）
+    void list_objects_page(int64_t bucket_id, const std::string& prefix, const std::string& delimiter,
+                           const std::string& start_after, size_t max_keys, ListPage& out) const;
     bool put_object(int64_t bucket_id, const std::string& key, int64_t size,
                     const std::string& last_modified, const std::string& etag,
                     const std::string& storage_path, const std::string& acl);
     bool delete_object(int64_t bucket_id, const std::string& key);
+    // 占位（不可覆盖的上传用）：对象不存在且未被占位时记下 bucket_id+key 并返回 true，否则 false；检查与记录在同一把锁内。
+    // 上传在写临时文件、rename 到 storage_path 之前占位，put_object 写入该 key 时解除，失败时调 release_object。只在内存中，不写日志
+    bool reserve_object(int64_t bucket_id, const std::string& key);
+    void release_object(int64_t bucket_id, const std::string& key);
+    // 批量（批量删除用）：一次加锁、一次遍历。get_objects 的 out 与 keys 一一对应，不存在的 id 为 0；
+    // delete_objects 返回实际删除的条数
+    void get_objects(int64_t bucket_id, const std::vector<std::string>& keys, std::vector<Object>& out) const;
+    size_t delete_objects(int64_t bucket_id, const std::vector<std::string>& keys);
 
     // 用户与密钥：secret 仅存于 user.dat，按 access_key 查 secret（用于验签）
     std::string get_secret_by_access_key(const std::string& access_key) const;
@@ -84,18 +140,128 @@ public:
 private:
     std::string data_root_;
     int64_t next_bucket_id_{1};
-    int64_t next_object_id_{1};
+    std::atomic<int64_t> next_object_id_{1};  // 各条带的 put_object 并发取号
     int64_t next_user_id_{1};
-    std::vector<Bucket> buckets_;
-    std::vector<Object> objects_;
+    std::vector<Bucket> buckets_;   // 不保证顺序，删除时与末尾交换
     std::vector<User> users_;
+
+    // 索引：值均为对应 vector 的下标。所有增删路径与 load 都须同步维护；vector 中元素移动时改写下标
+    struct PairHash {
+        template <class A, class B>
+        size_t operator()(const std::pair<A, B>& p) const {
+            size_t h = std::hash<A>()(p.first);
+            return h ^ (std::hash<B>()(p.second) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+        }
+    };
+    std::unordered_map<std::pair<std::string, std::string>, size_t, PairHash> bucket_by_owner_name_;  // (owner_id, name)
+    std::unordered_map<int64_t, size_t> bucket_by_id_;
+    std::unordered_map<std::string, size_t> user_by_access_key_;
+    std::unordered_map<std::string, size_t> user_by_username_;
     std::map<std::string, std::string> secret_by_access_key_;  // 从 user.dat 加载，仅服务端保存
-    mutable std::mutex mutex_;
+    // 写优先的读写锁（满足 SharedMutex，可配 std::shared_lock）。glibc 的 pthread_rwlock 与 std::shared_mutex 默认读优先，
+    // 读请求持续不断时写者会一直等不到锁；这里有写者等待时新的读者先排队
+    class RwLock {
+    public:
+        RwLock() {
+            pthread_rwlockattr_t attr;
+            pthread_rwlockattr_init(&attr);
+            pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+            pthread_rwlock_init(&lock_, &attr);
+            pthread_rwlockattr_destroy(&attr);
+        }
+        ~RwLock() { pthread_rwlock_destroy(&lock_); }
+        RwLock(const RwLock&) = delete;
+        RwLock& operator=(const RwLock&) = delete;
+        void lock() { pthread_rwlock_wrlock(&lock_); }
+        void unlock() { pthread_rwlock_unlock(&lock_); }
+        void lock_shared() { pthread_rwlock_rdlock(&lock_); }
+        void unlock_shared() { pthread_rwlock_unlock(&lock_); }
+
+    private:
+        pthread_rwlock_t lock_;
+    };
+    // 桶、用户与 next_bucket_id_ / next_user_id_ 的锁：查询持共享锁，建删桶与用户持独占锁。对象读写不取这把锁
+    mutable RwLock mutex_;
+
+    // 对象按桶分到固定数量的条带，每个条带有自己的读写锁与对象表：一个桶的写只阻塞同一条带上的读，
+    // 其他桶的读写与验签不受影响。查询持条带共享锁，变更持条带独占锁，只做内存修改与追加日志缓冲，不在锁内做文件 I/O
+    struct Stripe {
+        mutable RwLock mutex;
+        ObjectTable objects;  // 本条带各桶的对象（紧凑记录，取出时还原为 Object），自带 (bucket_id, key) 哈希索引
+        // bucket_id -> 该桶的有序 key 索引（key -> objects 下标），供列表与分页；桶内无对象时不建
+        std::unordered_map<int64_t, KeyIndex> keys_by_bucket;
+        // bucket_id -> 对象目录 data_root/s3/<owner_id>_<name>/（与 handler 的 object_storage_path 相同规则），
+        // 建桶时写入、删桶时移除，对象的 storage_path 等于它加 key 时不单独存储
+        std::unordered_map<int64_t, std::string> dir_by_bucket;
+        std::unordered_set<std::pair<int64_t, std::string>, PairHash> reserved;  // reserve_object 占位、尚未 put 的 key
+    };
+    static const size_t kStripes = 16;
+    Stripe stripes_[kStripes];
+    Stripe& stripe_of(int64_t bucket_id) { return stripes_[static_cast<uint64_t>(bucket_id) % kStripes]; }
+    const Stripe& stripe_of(int64_t bucket_id) const { return stripes_[static_cast<uint64_t>(bucket_id) % kStripes]; }
+
+    // 日志：变更方法把记录追加到 journal_buf_（持 journal_buf_mutex_，与各自的数据锁一起持有，同一桶的记录保持变更顺序）；
+    // save() 持 journal_mutex_ 把它换出到 journal_pending_，再在数据锁之外写入当前一代 s3_meta.journal.<journal_gen_>。
+    // 加锁顺序：journal_mutex_ → mutex_ → 条带锁（多个时按下标升序）→ journal_buf_mutex_
+    std::mutex journal_buf_mutex_;
+    std::string journal_buf_;
+    // 以下到 disk_format_ 由 journal_mutex_ 保护
+    std::mutex journal_mutex_;
+    std::string journal_pending_;    // 已换出、尚未写入文件的记录（写失败时留到下次）
     std::string last_save_error_;
+    // 日志文件：save() 在锁外同步时持有引用，封存换代后 fd 仍有效，最后一个引用释放时关闭
+    struct JournalFile {
+        int fd;
+        explicit JournalFile(int f) : fd(f) {}
+        ~JournalFile();
+    };
+    std::shared_ptr<JournalFile> journal_file_;  // 当前一代日志，第一次写入时才创建
+    std::vector<std::shared_ptr<JournalFile>> sealed_journals_;  // 设置 journal_sync_ 时：已封存、尚未被快照覆盖的各代
+    std::function<bool(const std::vector<int>&)> journal_sync_;
+    uint64_t journal_gen_{1};
+    uint64_t journal_file_bytes_{0}; // 当前一代日志的长度
+    uint64_t journal_bytes_{0};      // 尚未折叠进快照的各代日志总字节数
+    std::condition_variable checkpoint_cv_;  // 配合 journal_mutex_
+    bool checkpointer_stop_{false};
+    uint64_t checkpoint_bytes_{0};
+    SnapshotFormat snapshot_format_{SnapshotFormat::binary};
+    SnapshotFormat disk_format_{SnapshotFormat::binary};  // 磁盘上现有快照的格式（没有快照时同 snapshot_format_）
+    std::mutex checkpoint_mutex_;    // 同一时刻只做一个 checkpoint
+    std::thread checkpointer_;
+
+    // 以下均不写日志，供变更方法与重放共用
+    // 须持 mutex_：按 buckets_ 算出桶的对象目录，桶不存在时为空
+    std::string object_dir(int64_t bucket_id) const;
+    // 须持 mutex_ 独占锁与该桶（替换时还有被替换的桶）所在条带的独占锁
+    void insert_bucket(Bucket b);
+    bool remove_bucket(int64_t bucket_id);
+    void add_user(User u);  // 须持 mutex_ 独占锁
+    // 须持 s 的锁（读共享、写独占）
+    static std::string stripe_dir(const Stripe& s, int64_t bucket_id);
+    void upsert_object(Stripe& s, const Object& o);
+    bool erase_object(Stripe& s, int64_t bucket_id, const std::string& key);
+    // 追加日志记录（自取 journal_buf_mutex_），须在变更所持的数据锁内调用
+    void journal_append(const std::string& record);
+    void journal_object_delete(int64_t bucket_id, const std::string& key);
+    size_t object_count() const;  // 各条带对象数之和，逐个持共享锁
+    bool flush_journal();  // 须持 journal_mutex_、不持数据锁
+    bool replay_journal(const std::string& path);
+    bool load_text_snapshot(const std::string& path);
+    bool load_binary_snapshot(const std::string& path);
+    // 取 bucket_id 中 key 大于 cursor（started 为 false 时从头）的至多 max 个对象，持条带共享锁、时间只含拷贝；返回是否已取完
+    bool copy_object_batch(int64_t bucket_id, bool started, const std::string& cursor, size_t max,
+                           std::vector<Object>& out) const;
+    // checkpoint 写快照（不持锁，对象经 copy_object_batch 分批读取）
+    bool write_text_snapshot(int fd, int64_t next_bucket_id, int64_t next_object_id,
+                             const std::vector<Bucket>& buckets) const;
+    bool write_binary_snapshot(int fd, int64_t next_bucket_id, int64_t next_object_id,
+                               const std::vector<Bucket>& buckets) const;
 
-    std::string meta_file_path() const;
-    std::string meta_file_path_tmp() const;
+    std::string meta_file_path() const;       // <data_root>/s3_meta.dat
+    std::string snapshot_path() const;        // <data_root>/s3_meta.snap
     std::string user_dat_path() const;  // <data_root>/user.dat
+    std::string journal_path(uint64_t gen) const;  // <data_root>/s3_meta.journal.<gen>
+    std::vector<uint64_t> journal_gens() const;
 };
 
 }
@@ -0,0 +1,118 @@
+#ifndef S3_META_OBJECT_TABLE_H
+#define S3_META_OBJECT_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace meta {
+
+struct Object;
+
+// 对象元数据的紧凑存储（MetaStore 内部使用）：每个对象一条 64 字节定长记录，对外仍以 meta::Object 的字符串字段进出。
+// - bucket_id 换成桶槽位（同一桶的对象共用一个 int64）；
+// - last_modified 存 UTC 秒数，etag 存 16 字节 md5（分片上传的 -N 另存），acl 存枚举；
+// - storage_path 等于「该桶对象目录 + key」时不存，读取时拼出；
+// - key 与上面无法紧凑表示的字段（非标准时间格式、非 md5 etag、其他路径或 acl）存在分块 arena 中，记录只存位置；
+// - (bucket_id, key) 点查用开放寻址哈希表，槽位只存 32 位哈希与记录下标，key 取自 arena。
+// 删除与末尾交换（swap-pop），下标会变；arena 中的空洞超过存活字节数时整体压缩一次。非线程安全，由调用方加锁
+class ObjectTable {
+public:
+    // 批量加载时各字段的视图（可直接指向 mmap 的快照）
+    struct Fields {
+        int64_t id{0};
+        int64_t bucket_id{0};
+        int64_t size{0};
+        std::string_view key, last_modified, etag, storage_path, acl;
+    };
+
+    ObjectTable();
+    ~ObjectTable();
+    ObjectTable(const ObjectTable&) = delete;
+    ObjectTable& operator=(const ObjectTable&) = delete;
+
+    size_t size() const { return recs_.size(); }
+    bool empty() const { return recs_.empty(); }
+    void clear();
+
+    bool find(int64_t bucket_id, std::string_view key, uint32_t& idx) const;
+    // 插入或覆盖同一 (bucket_id, key) 的记录，返回下标，inserted 为是否新增。
+    // path_prefix 为该桶的对象目录（以 / 结尾）；非空且 storage_path == path_prefix + key 时不存路径
+    uint32_t upsert(const Fields& f, std::string_view path_prefix, bool& inserted);
+    // 删除 idx，末尾记录移到 idx；返回是否有记录被移动（此时 idx 处为原末尾记录）
+    bool erase(uint32_t idx);
+
+    int64_t id(uint32_t idx) const { return recs_[idx].id; }
+    int64_t bucket_id(uint32_t idx) const { return bucket_ids_[recs_[idx].bucket]; }
+    std::string_view key(uint32_t idx) const;
+    // 还原为完整的 Object；path_prefix 须与写入时相同
+    void get(uint32_t idx, std::string_view path_prefix, Object& out) const;
+    // 桶删除或被替换前调用：把 idx 的推导路径改为显式存储，此后不再依赖桶的 path_prefix
+    void pin_storage_path(uint32_t idx, std::string_view path_prefix);
+
+    // 批量加载（表须为空）：resize(n) 后各线程对互不相同的下标并发调用 pack，单线程 place_blobs 分配 arena，
+    // 再并发 write_blob 写入 key 与额外字段，最后单线程 build_index 建哈希索引。
+    // 调用 pack 前须对各桶 id 调用 intern_bucket（槽位表在批量阶段不能增长）
+    void resize(size_t n);
+    void intern_bucket(int64_t bucket_id) { bucket_slot(bucket_id); }
+    bool pack(uint32_t idx, const Fields& f, std::string_view path_prefix);  // 桶未登记时返回 false
+    void place_blobs();
+    void write_blob(uint32_t idx, const Fields& f);
+    void build_index();
+
+    // 记录、arena 与哈希表按容量计的堆内存（字节）
+    size_t memory_usage() const;
+
+private:
+    struct Rec {
+        int64_t id;
+        int64_t size;
+        int64_t mtime;        // last_modified 的 UTC 秒数
+        uint64_t blob;        // arena 位置（块号 << 32 | 块内偏移）：key，其后按 flags 依次为各额外字段（u32 长度 + 字节）
+        uint32_t key_len;
+        uint32_t bucket;      // bucket_ids_ 下标
+        uint32_t hash;        // (bucket_id, key) 的哈希，哈希表定位与扩容用
+        uint8_t etag[16];     // md5
+        uint16_t etag_parts;  // 分片上传 etag 的 -N，0 为普通 md5
+        uint8_t acl;
+        uint8_t flags;
+    };
+    static_assert(sizeof(Rec) == 64, "one cache line per object");
+
+    std::vector<Rec> recs_;
+    std::vector<int64_t> bucket_ids_;
+    std::unordered_map<int64_t, uint32_t> slot_of_bucket_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    std::vector<uint32_t> chunk_sizes_;
+    uint64_t chunk_bytes_{0};      // 各块大小之和
+    uint32_t chunk_used_{0};       // 最后一块已用字节数
+    uint64_t live_bytes_{0};
+    uint64_t garbage_bytes_{0};
+    std::vector<uint64_t> slots_;  // 0 为空，否则 hash << 32 | (下标 + 1)；容量为 2 的幂
+
+    uint32_t bucket_slot(int64_t bucket_id);
+    static uint32_t hash_of(int64_t bucket_id, std::string_view key);
+    // 除 bucket 与 blob 外的字段由 f 编码进 r
+    static void encode(Rec& r, const Fields& f, std::string_view path_prefix);
+    static size_t encoded_size(const Rec& r, const Fields& f);   // blob 字节数
+    static void write_encoded(char* p, const Rec& r, const Fields& f);
+    static size_t blob_size(const Rec& r, const char* p);        // 从已写入的 blob 算长度
+    const char* blob_ptr(uint64_t blob) const;
+    char* blob_ptr(uint64_t blob);
+    uint64_t alloc(size_t len);
+    void store(Rec& r, const Fields& f);    // 分配并写入 r 的 blob
+    void release(const Rec& r);             // r 的 blob 记为空洞
+    void maybe_compact();
+    size_t slot_of(uint32_t hash, uint32_t idx) const;
+    void index_insert(uint32_t hash, uint32_t idx);
+    void index_erase(size_t pos);
+    bool reserve_index(size_t n);           // 容量不足以放 n 条时扩容并重建，返回是否重建
+};
+
+}
+
+#endif
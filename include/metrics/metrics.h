@@ -0,0 +1,42 @@
+#ifndef S3_METRICS_METRICS_H
+#define S3_METRICS_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace metrics {
+
+// 进程级计数器/水位：按名字注册一次，返回的引用在进程生命周期内有效，更新无锁。
+class Counter {
+public:
+    void add(int64_t n = 1) { v_.fetch_add(n, std::memory_order_relaxed); }
+    void sub(int64_t n = 1) { v_.fetch_sub(n, std::memory_order_relaxed); }
+    void set(int64_t n) { v_.store(n, std::memory_order_relaxed); }
+    // 仅当 n 更大时更新（记录峰值）
+    void update_max(int64_t n) {
+        int64_t cur = v_.load(std::memory_order_relaxed);
+        while (n > cur && !v_.compare_exchange_weak(cur, n, std::memory_order_relaxed)) {}
+    }
+    int64_t get() const { return v_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> v_{0};
+};
+
+// 取得（不存在则创建）名为 name 的计数器，如 "pool.queue_depth"
+Counter& counter(const std::string& name);
+
+// 注册派生指标：导出时调用 fn 计算（如利用率），同名重复注册以最后一次为准
+void gauge(const std::string& name, std::function<int64_t()> fn);
+
+// 进程启动以来的毫秒数
+int64_t uptime_ms();
+
+// 全部指标按名字排序导出为 JSON 对象：{"uptime_ms":..,"pool.enqueued":..,...}
+std::string to_json();
+
+}
+
+#endif
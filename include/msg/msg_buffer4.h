@@ -146,6 +146,25 @@ public:
 
     uint32_t total_length() const { return total_len_; }
     size_t get_iovec(struct iovec* iov, size_t max_iov) const;
+    // 跳过前 skip 字节后填充 iovec（用于部分发送后续传）
+    size_t get_iovec(struct iovec* iov, size_t max_iov, uint32_t skip) const;
+
+    // 把 src 中 [offset, offset+len) 以视图方式追加到本 msg（共享 unit，只加引用不拷贝）。
+    // 之后不要再对本 msg 调 copy_in：尾部 unit 可能仍被 src 写入。
+    void append_view(const x_msg_t& src, uint32_t offset, uint32_t len);
+
+    // 丢弃头部 len 字节（超过总长则清空），整段消费完的 unit 释放引用（用于流水线请求逐个出队）
+    void consume(uint32_t len);
+
+    // 在逻辑位置 pos 处插入 len 字节（如向已组装好的响应头插入一行）。
+    // unit 独占且尾部有余量时原地挪移，否则拆分 segment 并为插入的数据申请新 unit。池耗尽返回 false。
+    bool insert(x_buf_pool_t& pool, uint32_t pos, const void* src, uint32_t len);
+
+    // 就地写入（如 recv/readv 直接收进 unit）：把尾部 unit 尚未使用的物理空间填入 iov，返回其字节数。
+    // 写入后用 commit 计入 msg；没有尾部 unit 或已写满时返回 0（可另取新 unit 以 append_unit 追加）。
+    uint32_t tail_space(struct iovec& iov) const;
+    // 把已就地写入尾部空间的 len 字节计入 msg（len 不超过 tail_space 的返回值）
+    void commit(uint32_t len);
 
 private:
     std::vector<segment> segments_;
@@ -0,0 +1,57 @@
+#ifndef S3_NET_CONN_HANDLER_H
+#define S3_NET_CONN_HANDLER_H
+
+#include <cstdint>
+
+struct x_msg_t;
+
+namespace net {
+
+// 连接处理器希望驱动方执行的下一步 I/O
+enum class IoAction {
+    Recv,   // 继续从 socket 读，读到的数据追加到 input() 后调用 on_input()
+    Send,      // 将 output() 全部发送后调用 on_sent()
+    SendFile,  // 先发送 output()（响应头），再把 file_segment() 描述的文件区间零拷贝发出，之后调用 on_sent()
+    Work,      // 调用 work()（可能阻塞于磁盘 I/O、fsync 等待），其返回值为下一步
+    Close      // 关闭连接
+};
+
+// 待零拷贝发送的文件区间；fd 归 handler 所有，驱动方只读不关
+struct FileSegment {
+    int fd{-1};
+    uint64_t offset{0};
+    uint64_t length{0};
+};
+
+// 单连接上的协议状态机（与 I/O 方式无关）。
+// 由阻塞线程（serve_connection）或 io_uring 事件循环（Reactor）驱动，同一连接同一时刻只在一个线程上。
+// on_input / on_sent 不做阻塞操作，需要读写文件或等待落盘时返回 Work：阻塞线程直接调用 work()，
+// 事件循环把 work() 交给其工作线程执行，期间不调用该连接的其他方法。
+// 同一连接的 work() 总在同一个线程上调用（文件读写用线程本地的 io_uring），调用过 work() 的 handler 也在该线程上析构。
+class ConnHandler {
+public:
+    virtual ~ConnHandler() = default;
+
+    // 接收缓冲：驱动方把 socket 读到的数据追加到这里
+    virtual x_msg_t& input() = 0;
+    // 有新数据追加到 input() 后调用
+    virtual IoAction on_input() = 0;
+
+    // 待发送的数据；返回 Send 后驱动方保证整体发送完毕才调用 on_sent()
+    virtual const x_msg_t& output() const = 0;
+    virtual IoAction on_sent() = 0;
+    // 返回 Work 后调用：执行阻塞工作并继续推进状态机
+    virtual IoAction work() { return IoAction::Close; }
+    // 返回 SendFile 时有效
+    virtual const FileSegment& file_segment() const {
+        static const FileSegment kNone;
+        return kNone;
+    }
+
+    // 是否处于两次请求之间（没有未处理的输入）：驱动方据此施加 keep-alive 空闲超时
+    virtual bool idle() const { return false; }
+};
+
+}
+
+#endif
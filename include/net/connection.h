@@ -2,18 +2,31 @@
 #define S3_NET_CONNECTION_H
 
 #include <cstdint>
+#include <functional>
 
 struct x_msg_t;
 class x_buf_pool_t;
 
 namespace net {
 
-// 从 fd 读取 HTTP 请求（到头部结束 \r\n\r\n），写入 msg。返回读取字节数，0 表示对端关闭，-1 表示错误。
-// 若 content_length >= 0 且已读满头部，会继续读 body 直到 content_length 字节，全部放入 msg。
-int read_request(int fd, x_msg_t& msg, x_buf_pool_t& pool, int64_t& content_length_out);
+class ConnHandler;
 
-// 将 msg 通过 get_iovec + writev 发送到 fd。返回写入字节数，-1 表示错误。
-int write_response(int fd, const x_msg_t& msg);
+// 从 fd 读一次（阻塞），数据直接收进 msg 尾部 unit（不足时追加新 unit）。返回读取字节数，0 表示对端关闭，-1 表示错误（含池耗尽）。
+int recv_into(int fd, x_msg_t& msg, x_buf_pool_t& pool);
+
+// 将 msg 通过 get_iovec + sendmsg 全部发送到 fd（处理部分写与超过单次 iovec 上限的分段）。
+// flags 附加到 sendmsg（如后面紧跟文件内容时用 MSG_MORE 让头与 body 合包）。返回写入字节数，-1 表示错误。
+int write_response(int fd, const x_msg_t& msg, int flags = 0);
+
+// 用 sendfile 把 file_fd 的 [offset, offset+length) 全部发送到 fd。成功返回 true。
+bool send_file(int fd, int file_fd, uint64_t offset, uint64_t length);
+
+// 阻塞方式驱动一个连接：按 handler 的要求 recv/send，直到其返回 Close 或出错，最后关闭 fd。
+// 已发完至少一个响应且 handler.idle() 时最多等待 idle_timeout_ms（<0 不限）；等待期间 yield_idle() 返回 true
+// （如工作线程池里有连接在排队）则提前关闭该空闲连接，把线程让给新连接。第一个请求到达前不施加空闲超时。
+// 其余读取（第一个请求、收了一半的请求头或 body）每次最多等待 request_timeout_ms（<0 不限），超时即关闭。
+void serve_connection(int fd, ConnHandler& handler, x_buf_pool_t& pool, int idle_timeout_ms = -1,
+                      int request_timeout_ms = -1, const std::function<bool()>& yield_idle = nullptr);
 
 void close_fd(int fd);
 
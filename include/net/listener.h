@@ -6,12 +6,21 @@
 
 namespace net {
 
+struct ListenOptions {
+    int  backlog{1024};          // listen() 队列长度
+    bool reuse_port{false};      // SO_REUSEPORT：多个 socket 绑同一端口，由内核按连接分流
+    int  defer_accept_secs{0};   // TCP_DEFER_ACCEPT：>0 时直到客户端发来数据（或超时）才唤醒 accept
+};
+
 // TCP 监听：bind + listen。返回监听 fd，失败返回 -1。
-int listen_tcp(const std::string& addr, uint16_t port);
+int listen_tcp(const std::string& addr, uint16_t port, const ListenOptions& opts = ListenOptions());
 
 // accept，返回客户端 fd，失败返回 -1。
 int accept_one(int listen_fd);
 
+// 将当前线程绑定到 cpu（按在线核数取模）。失败返回 false。
+bool pin_current_thread(int cpu);
+
 } 
 
 #endif
@@ -0,0 +1,32 @@
+#ifndef S3_NET_REACTOR_H
+#define S3_NET_REACTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+class x_buf_pool_t;
+
+namespace net {
+
+class ConnHandler;
+
+// 为每个新连接创建协议状态机
+using HandlerFactory = std::function<std::unique_ptr<ConnHandler>()>;
+
+// 在当前线程上运行一个 io_uring 事件循环：multishot accept 接收 listen_fd 上的新连接，
+// multishot recv（provided buffer ring，由 recv_buffers 个 pool unit 组成，收到的 unit 直接挂到连接的输入 msg）收数据，
+// sendmsg 发响应，按 ConnHandler 的状态推进每个连接。handler 返回 Work 时交给本循环的 work_threads 个工作线程之一执行
+// （同一连接固定在同一线程），完成后经 eventfd 通知回事件循环，期间连接不收数据（multishot recv 被取消），
+// 因此慢速磁盘操作与等待落盘不阻塞同一循环上的其他连接。
+// 多个线程可对同一 listen_fd 各自运行一个事件循环。已发完至少一个响应、handler.idle() 超过 idle_timeout_ms（<0 不限）的连接被关闭；
+// 其余等待数据的连接（第一个请求、收了一半的请求头或 body）超过 request_timeout_ms（<0 不限）没有新数据也被关闭。
+// 阻塞直到 stop 为 true；ring 初始化失败返回 false。
+bool run_event_loop(int listen_fd, x_buf_pool_t& pool, const HandlerFactory& factory, int idle_timeout_ms,
+                    int request_timeout_ms, uint32_t recv_buffers, uint32_t work_threads,
+                    const std::atomic<bool>& stop);
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef S3_NET_WORKER_POOL_H
+#define S3_NET_WORKER_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace net {
+
+// 固定数量的工作线程 + 有界连接队列（多生产者/多消费者）。
+// 工作线程常驻，线程内的 io_uring（file_io 的 thread_local ring）与 x_buf_pool_t 的 TLC 在请求间复用。
+// 指标（metrics）：pool.queue_depth / pool.queue_wait_ns_* / pool.workers_busy / pool.utilization_pct 等。
+class WorkerPool {
+public:
+    // serve 在工作线程上处理一个已 accept 的连接，负责关闭 fd
+    using ServeFn = std::function<void(int fd)>;
+
+    // first_cpu >= 0 时第 i 个工作线程绑定到核 first_cpu + i % cpu_count（本组独占的核区间，见 S3_PIN_CPUS）
+    WorkerPool(uint32_t workers, uint32_t queue_depth, ServeFn serve, int first_cpu = -1, int cpu_count = 1);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // 入队：队列满时阻塞直到有空位。已 stop() 时返回 false，fd 由调用方关闭。
+    bool submit(int fd);
+
+    // 队列中有等待工作线程的连接或正在停止时为 true：空闲的 keep-alive 连接应关闭以让出工作线程
+    bool reclaim_idle() const;
+
+    // 停止接收新连接，队列中与在途的连接继续处理；超过 grace 仍未完成则 shutdown 其 fd 并丢弃队列，最后 join。
+    void stop(std::chrono::milliseconds grace);
+
+private:
+    struct Item {
+        int fd;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    ServeFn serve_;
+    int first_cpu_;
+    int cpu_count_;
+    std::vector<std::thread> threads_;
+    std::vector<int> active_fds_;     // 各工作线程当前处理的 fd，-1 表示空闲；受 mutex_ 保护
+
+    // 环形队列，受 mutex_ 保护
+    std::vector<Item> queue_;
+    size_t head_{0};
+    size_t count_{0};
+    uint32_t busy_{0};
+    bool stopping_{false};
+    bool aborting_{false};
+    bool joined_{false};
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable idle_;
+
+    void worker_main(size_t index);
+};
+
+}
+
+#endif
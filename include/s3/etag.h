@@ -0,0 +1,49 @@
+#ifndef S3_ETAG_H
+#define S3_ETAG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct x_msg_t;
+struct evp_md_ctx_st;
+
+namespace s3 {
+
+const size_t kMd5Size = 16;
+
+// 增量 MD5：上传时随 body 到达逐段计算，收完即得到 ETag，不再回读文件
+class Md5Stream {
+public:
+    Md5Stream();
+    ~Md5Stream();
+    Md5Stream(const Md5Stream&) = delete;
+    Md5Stream& operator=(const Md5Stream&) = delete;
+
+    void update(const void* data, size_t len);
+    void update(const x_msg_t& data);          // 按 segment 直接读 unit，不线性化
+    void final(unsigned char digest[kMd5Size]);  // 之后不可再 update
+
+private:
+    evp_md_ctx_st* ctx_;
+};
+
+// 小写十六进制
+std::string hex_digest(const unsigned char* digest, size_t len);
+
+// Content-MD5 头（base64 的 16 字节 MD5）解码，格式不对返回 false
+bool decode_content_md5(std::string_view b64, unsigned char digest[kMd5Size]);
+
+// 分片上传拼成的对象的 ETag：各分片 MD5 的二进制拼接再取 MD5，后缀 -分片数（与 S3 相同）。
+// 任一分片 ETag 不是 32 位十六进制时返回空
+std::string multipart_etag(const std::vector<std::string>& part_etags);
+
+// etag_hash=none 时的 ETag：由大小与完成时间（纳秒）组成的版本标签，不读数据。
+// 对象不可覆盖，版本标签足以让客户端重验证，但不能用来校验内容
+std::string version_etag(int64_t size);
+
+}
+
+#endif
@@ -1,19 +1,90 @@
 #ifndef S3_HANDLER_H
 #define S3_HANDLER_H
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 struct x_msg_t;
 class x_buf_pool_t;
 
 namespace http { struct HttpRequest; }
 namespace s3config { struct Config; }
 namespace meta { class MetaStore; }
+namespace uring { class FileWriter; }
+namespace s3 { class Md5Stream; }
 
 namespace s3 {
 
+// 流式响应体：handle_request 只把响应头（含完整 Content-Length）写入 out，body 由连接层在每次发送完成后分段拉取
+class BodySource {
+public:
+    virtual ~BodySource() = default;
+    // 把下一段 body 追加到 out（不超过 max_bytes，至少一段）。返回追加字节数；0 表示已结束；
+    // -1 表示出错（响应头已发出，连接层只能关闭连接）。
+    virtual int64_t next(x_msg_t& out, uint32_t max_bytes) = 0;
+    // body 是否原样等于某个文件区间（可用 sendfile/splice 零拷贝发送）。需要在用户态变换的 body 返回 false。
+    virtual bool file_range(int& fd, uint64_t& offset, uint64_t& length) {
+        (void)fd; (void)offset; (void)length;
+        return false;
+    }
+};
+
 // 根据 req、config、meta 处理请求，将响应写入 out。使用 pool 分配缓冲。
+// 对象内容等大 body 不进 out，而是通过 body 交给连接层流式发送。
 // 返回 true 表示已写入响应，false 表示池耗尽等错误（调用方可返回 503）。
 bool handle_request(const http::HttpRequest& req, const s3config::Config& config,
-    meta::MetaStore& store, x_msg_t& out, x_buf_pool_t& pool, const x_msg_t* body_msg);
+    meta::MetaStore& store, x_msg_t& out, x_buf_pool_t& pool, const x_msg_t* body_msg,
+    std::unique_ptr<BodySource>& body);
+
+// 在读 body 之前做不依赖 body 的廉价检查（管理员权限、路径、桶与分片上传是否存在），
+// 用于非流式请求的 Expect: 100-continue 与提前拒绝。会被拒绝时向 out 写入错误响应并返回 false。
+// 签名由调用方先行校验；流式上传的同类检查在 ObjectUpload::begin 中。
+bool accept_request_body(const http::HttpRequest& req, const s3config::Config& config,
+    meta::MetaStore& store, x_msg_t& out, x_buf_pool_t& pool);
+
+// 该请求的 body 是否应流式写盘（PUT /createObject/... 或 /uploadPart/... 且带 body 或为 chunked），而不是收齐后交给 handle_request
+bool is_streaming_upload(const http::HttpRequest& req);
+
+// 流式上传 createObject：收 body 前校验桶与对象并打开临时文件，body 到达后即以 io_uring 流水写盘
+// （最多 config.upload_window 个写在途），收齐后改名为正式文件并写元数据。
+// 内存占用与对象大小无关；未 finish 即析构时删除临时文件。
+// 写盘的同时增量计算 MD5 作为 ETag（config.etag_hash=md5 或请求带 Content-MD5 时），带 Content-MD5 时收完即校验。
+// uploadPart 同样经此流式写盘，只是落到分片上传的暂存区（part-<N>），不写元数据。
+class ObjectUpload {
+public:
+    ObjectUpload(const s3config::Config& config, meta::MetaStore& store, x_buf_pool_t& pool);
+    ~ObjectUpload();
+    ObjectUpload(const ObjectUpload&) = delete;
+    ObjectUpload& operator=(const ObjectUpload&) = delete;
+
+    // 校验请求并打开临时文件。失败时已向 out 写入错误响应，返回 false。
+    bool begin(const http::HttpRequest& req, x_msg_t& out);
+    // 追加一段 body（chunked 时为已解码的数据；不拷贝，数据 unit 引用保持到写盘完成）。写盘失败返回 false。
+    bool append(const x_msg_t& data);
+    // body 已全部 append：等待写盘完成、落到正式路径、写元数据，并向 out 写入响应
+    void finish(x_msg_t& out);
+
+private:
+    const s3config::Config& config_;
+    meta::MetaStore& store_;
+    x_buf_pool_t& pool_;
+    int64_t bucket_id_{0};
+    int64_t expected_{0};       // Content-Length；chunked 时为 -1（长度收完才知道）
+    std::string object_key_;
+    std::string storage_path_;
+    std::vector<std::string> new_dirs_;  // begin() 为 storage_path_ 新建的目录（durability=full 时需同步其上级目录）
+    std::string tmp_path_;
+    std::string upload_id_;
+    uint32_t part_number_{0};   // 非 0 表示 uploadPart
+    bool reserved_{false};      // 已在 store_ 中占位 object_key_（PUT Object），put_object 前失败时由 discard() 解除
+    std::string content_md5_;   // 解码后的 Content-MD5（16 字节），空表示不校验
+    std::unique_ptr<uring::FileWriter> writer_;
+    std::unique_ptr<Md5Stream> md5_;
+
+    void discard();
+};
 
 }
 
@@ -0,0 +1,57 @@
+#ifndef S3_MULTIPART_H
+#define S3_MULTIPART_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace s3 {
+
+// 分片上传的暂存区：data_root/.multipart/<upload_id>/。
+// info 记录所属 bucket_id 与 key；每个分片是一个文件 part-<N>（N 为 1..kMaxPartNumber），各连接并发写各自的分片，
+// 重传同一分片原子替换。状态全部在文件系统上，服务重启后未完成的上传可以继续。
+
+const uint32_t kMaxPartNumber = 10000;
+
+struct MultipartInfo {
+    int64_t bucket_id{0};
+    std::string key;
+};
+
+struct MultipartPart {
+    uint32_t number{0};
+    uint64_t size{0};
+};
+
+// 为 (bucket_id, key) 新建一次分片上传，返回随机的 upload_id（32 位十六进制）。失败返回 false。
+// sync 为 true 时 info 文件及暂存目录落盘后才返回
+bool multipart_create(const std::string& data_root, int64_t bucket_id, const std::string& key, std::string& upload_id,
+                      bool sync = false);
+
+// 读取 upload_id 的信息。upload_id 格式非法或不存在返回 false。
+bool multipart_lookup(const std::string& data_root, const std::string& upload_id, MultipartInfo& info);
+
+// 分片文件路径与该分片写入时使用的临时文件目录（与分片同目录，完成后 rename 到分片路径）
+std::string multipart_dir(const std::string& data_root, const std::string& upload_id);
+std::string multipart_part_path(const std::string& data_root, const std::string& upload_id, uint32_t part);
+
+// 分片的 ETag（MD5 十六进制）存在分片旁的 part-<N>.etag，complete 时据此得出整体 ETag，不回读分片。
+// 读不到时返回空。sync 为 true 时写入后 fdatasync
+bool multipart_write_part_etag(const std::string& data_root, const std::string& upload_id, uint32_t part,
+                               const std::string& etag, bool sync = false);
+std::string multipart_read_part_etag(const std::string& data_root, const std::string& upload_id, uint32_t part);
+
+// 已上传的分片（按分片号升序）
+bool multipart_list_parts(const std::string& data_root, const std::string& upload_id, std::vector<MultipartPart>& parts);
+
+// 把 parts 依次拼接到新建的 dst：copy_file_range 在内核中复制（支持的文件系统上为 reflink，不读进用户态）。
+// 成功时 total 为拼接后的大小；失败时删除 dst。
+bool multipart_assemble(const std::string& data_root, const std::string& upload_id,
+                        const std::vector<MultipartPart>& parts, const std::string& dst, uint64_t& total);
+
+// 删除暂存区（完成或放弃后）
+void multipart_remove(const std::string& data_root, const std::string& upload_id);
+
+}
+
+#endif
@@ -8,13 +8,22 @@ class x_buf_pool_t;
 
 namespace s3 {
 
-// 组装 HTTP 响应到 out（清空后写入）。status_code 如 200, 204, 403, 404, 409, 503。
-void write_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
+// 组装 HTTP 响应到 out（清空后写入）。status_code 如 200, 204, 206, 403, 404, 409, 416, 503。
+// extra_headers 为附加的完整头部行（每行以 \r\n 结尾，如 Content-Range），可为空。
+// 池耗尽写不全时清空 out 并返回 false，避免只发出半个响应头。
+bool write_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
     const char* status_phrase, const char* body, size_t body_len,
-    const char* content_type = "application/xml");
+    const char* content_type = "application/xml", const char* extra_headers = nullptr);
 
-// 错误体：JSON，含 code:0
-void write_error_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
+// 只写响应头，以 Transfer-Encoding: chunked 代替 Content-Length；body 由调用方用 http::append_chunk 分块追加。
+bool write_chunked_response_head(x_msg_t& out, x_buf_pool_t& pool, int status_code,
+    const char* content_type = "application/xml", const char* extra_headers = nullptr);
+
+// 304 Not Modified：只有状态行与 extra_headers（ETag、Last-Modified 等），无 body、无 Content-Length
+bool write_not_modified(x_msg_t& out, x_buf_pool_t& pool, const char* extra_headers);
+
+// 错误体：JSON，含 code:0。返回值同 write_response
+bool write_error_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
     const char* code, const char* message);
 
 // 成功体：HTTP 200 + JSON（若 json_body 为空则写 {"code":1}）
@@ -0,0 +1,106 @@
+#ifndef S3_SESSION_H
+#define S3_SESSION_H
+
+#include "net/conn_handler.h"
+#include "http/chunked.h"
+#include "http/header_scanner.h"
+#include "http/http_request.h"
+#include "msg/msg_buffer4.h"
+#include "s3/handler.h"
+#include <cstdint>
+#include <memory>
+
+namespace s3config { struct Config; }
+namespace meta { class MetaStore; }
+
+namespace s3 {
+
+// 单连接上的 S3 请求状态机：收齐请求头 → 解析 → 收齐 body → 验签 → handler → 发送响应。
+// HTTP/1.1 keep-alive：响应发完后从 in_ 中出队本请求，已缓冲的后续（流水线）请求直接继续处理；
+// 达到 keepalive_max_requests、客户端要求 close 或出错时在响应中带 Connection: close 并关闭。
+// 对象内容等大响应体由 BodySource 分段提供，发完一段再取下一段（on_sent 返回 Send），磁盘预读与网络发送重叠；
+// config.zero_copy 且 body 原样来自文件时改为 SendFile，由驱动方 sendfile（线程模式）或 splice（io_uring 模式）发送。
+// createObject 的 body 不在内存中收齐：验签、校验通过后边收边交给 ObjectUpload 写盘，in_ 中只保留不足一个 buffer 的尾部。
+// 带 body 的请求在收 body 前先验签并做 meta 检查（流式上传为 ObjectUpload::begin，其余为 accept_request_body），
+// 不通过时直接回最终错误；通过且带 Expect: 100-continue 时先发 100 Continue 再收 body。
+// Transfer-Encoding: chunked 的 body 经 ChunkedDecoder 增量解码（数据为 in_ 的视图），流式上传时边解码边写盘。
+// 不做任何网络 I/O，由 net::serve_connection（阻塞线程）或 net::Reactor（io_uring 事件循环）驱动。
+// 打开/写入/读取对象文件、handler 处理与等待落盘都放在 work() 中（返回 IoAction::Work），on_input / on_sent 只做解析与缓冲。
+class Session : public net::ConnHandler {
+public:
+    Session(const s3config::Config& config, meta::MetaStore& store, x_buf_pool_t& pool);
+
+    x_msg_t& input() override { return in_; }
+    net::IoAction on_input() override;
+    const x_msg_t& output() const override { return out_; }
+    net::IoAction on_sent() override;
+    net::IoAction work() override;
+    const net::FileSegment& file_segment() const override { return file_; }
+    bool idle() const override { return header_len_ == 0 && in_.total_length() == 0; }
+
+private:
+    // 返回 Work 后 work() 要做的事
+    enum class Step { None, BeginUpload, WriteBody, WriteChunked, Process, NextBody };
+
+    const s3config::Config& config_;
+    meta::MetaStore& store_;
+    x_buf_pool_t& pool_;
+
+    x_msg_t in_;
+    x_msg_t out_;
+    http::HttpRequest req_;
+    http::HeaderScanner scanner_;   // 跨 recv 增量查找请求头结尾
+    uint32_t header_len_{0};      // 含结尾 \r\n\r\n；0 表示请求头尚未收齐
+    int64_t content_length_{0};
+    uint32_t requests_{0};        // 本连接已开始处理的请求数
+    bool keep_alive_{false};      // 当前响应发完后是否保持连接
+    bool streaming_{false};       // 当前请求的 body 走流式上传（头与 body 随接收出队）
+    bool verified_{false};        // 已在收 body 前验签
+    bool interim_{false};         // out_ 中是 100 Continue，发完后继续收 body
+    int64_t body_left_{0};        // 流式上传尚未收到的 body 字节数
+    bool chunked_{false};         // 当前请求的 body 为 chunked 编码
+    uint32_t chunk_offset_{0};    // 非流式 chunked：已解码到 in_ 的位置
+    int chunk_error_{0};          // 流式 chunked body 解码出错时的响应状态码（400/413）
+    bool chunk_done_{false};      // 流式 chunked body 已解码到结尾
+    http::ChunkedDecoder decoder_;
+    x_msg_t chunk_body_;          // 已解码、尚未交出的 body 数据（视图）
+    std::unique_ptr<ObjectUpload> upload_;
+    std::unique_ptr<BodySource> body_;   // 流式响应体（GetObject）：每次发送完成后拉取下一段
+    bool sending_file_{false};           // body_ 以零拷贝方式整体发送（IoAction::SendFile）
+    net::FileSegment file_;
+    Step step_{Step::None};
+
+    net::IoAction start_work(Step step);
+    // 请求头之后的输入：收 body、凑够一段后交给 work() 写盘，或在请求收齐后交给 work() 处理
+    net::IoAction continue_input();
+    // 以下在 work() 中执行
+    net::IoAction begin_upload();
+    net::IoAction write_body();
+    net::IoAction write_chunked_body();
+    net::IoAction next_body();
+    // 响应发完：出队本请求，继续处理已缓冲的下一个请求或等待新请求
+    net::IoAction next_request();
+
+    // ObjectUpload 已 begin：出队请求头，之后的 body 边收边写
+    void start_upload();
+    net::IoAction send_continue();
+    net::IoAction stream_body();
+    net::IoAction stream_chunked_body();
+    // 请求在 body 到达前被拒绝（out_ 已写错误）：body 未收齐则关闭连接。已到达的 body 字节计入指标
+    net::IoAction reject_body();
+
+    // 在 out_ 的状态行后补 Connection 头，返回 Send
+    net::IoAction respond();
+    // 无法确定请求边界时（头部非法/过大、body 超限）回错误并关闭
+    net::IoAction fail(int status, const char* code, const char* message);
+
+    // HEAD 响应：只保留 out_ 中的响应头（Content-Length 仍为 GET 时的值）
+    void strip_body();
+
+    // 请求头与 body 均已收齐后执行验签与业务处理，响应写入 out_
+    void process();
+};
+
+}
+
+#endif
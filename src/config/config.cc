@@ -54,6 +54,56 @@ void load(Config& out) {
     out.buffer_payload_size = parse_uint(buf_size.c_str(), 65536);
     const std::string buf_count = getenv_default("S3_BUFFER_COUNT", "1024");
     out.buffer_count = parse_uint(buf_count.c_str(), 1024);
+    out.io_mode = getenv_default("S3_IO_MODE", "thread");
+    const std::string loops = getenv_default("S3_EVENT_LOOPS", "2");
+    out.event_loops = parse_uint(loops.c_str(), 2);
+    if (out.event_loops == 0) out.event_loops = 1;
+    const std::string recv_bufs = getenv_default("S3_RECV_BUFFERS", "32");
+    out.recv_buffers = parse_uint(recv_bufs.c_str(), 32);
+    if (out.recv_buffers == 0) out.recv_buffers = 1;
+    const std::string work_threads = getenv_default("S3_WORK_THREADS", "4");
+    out.work_threads = parse_uint(work_threads.c_str(), 4);
+    if (out.work_threads == 0) out.work_threads = 1;
+    const std::string workers = getenv_default("S3_WORKER_THREADS", "32");
+    out.worker_threads = parse_uint(workers.c_str(), 32);
+    if (out.worker_threads == 0) out.worker_threads = 1;
+    const std::string queue_depth = getenv_default("S3_ACCEPT_QUEUE_DEPTH", "1024");
+    out.accept_queue_depth = parse_uint(queue_depth.c_str(), 1024);
+    if (out.accept_queue_depth == 0) out.accept_queue_depth = 1;
+    const std::string listeners = getenv_default("S3_LISTENERS", "1");
+    out.listeners = parse_uint(listeners.c_str(), 1);
+    if (out.listeners == 0) out.listeners = 1;
+    const std::string backlog = getenv_default("S3_LISTEN_BACKLOG", "1024");
+    out.listen_backlog = parse_uint(backlog.c_str(), 1024);
+    if (out.listen_backlog == 0) out.listen_backlog = 1;
+    const std::string defer = getenv_default("S3_TCP_DEFER_ACCEPT", "0");
+    out.tcp_defer_accept = parse_uint(defer.c_str(), 0);
+    const std::string ka_timeout = getenv_default("S3_KEEPALIVE_TIMEOUT_MS", "5000");
+    out.keepalive_timeout_ms = parse_uint(ka_timeout.c_str(), 5000);
+    const std::string req_timeout = getenv_default("S3_REQUEST_TIMEOUT_MS", "30000");
+    out.request_timeout_ms = parse_uint(req_timeout.c_str(), 30000);
+    const std::string ka_max = getenv_default("S3_KEEPALIVE_MAX_REQUESTS", "100");
+    out.keepalive_max_requests = parse_uint(ka_max.c_str(), 100);
+    const std::string window = getenv_default("S3_UPLOAD_WINDOW", "8");
+    out.upload_window = parse_uint(window.c_str(), 8);
+    if (out.upload_window == 0) out.upload_window = 1;
+    const std::string dl_window = getenv_default("S3_DOWNLOAD_WINDOW", "4");
+    out.download_window = parse_uint(dl_window.c_str(), 4);
+    if (out.download_window == 0) out.download_window = 1;
+    out.etag_hash = getenv_default("S3_ETAG_HASH", "md5");
+    if (out.etag_hash != "none") out.etag_hash = "md5";
+    out.durability = getenv_default("S3_DURABILITY", "none");
+    if (out.durability != "fdatasync" && out.durability != "full") out.durability = "none";
+    const std::string commit_window = getenv_default("S3_COMMIT_WINDOW_US", "0");
+    out.commit_window_us = parse_uint(commit_window.c_str(), 0);
+    const std::string checkpoint = getenv_default("S3_META_CHECKPOINT_BYTES", "67108864");
+    out.meta_checkpoint_bytes = parse_uint(checkpoint.c_str(), 64u << 20);
+    out.meta_snapshot_format = getenv_default("S3_META_SNAPSHOT_FORMAT", "binary");
+    if (out.meta_snapshot_format != "text") out.meta_snapshot_format = "binary";
+    const std::string zero_copy = getenv_default("S3_ZERO_COPY", "1");
+    out.zero_copy = parse_uint(zero_copy.c_str(), 1) != 0;
+    const std::string pin = getenv_default("S3_PIN_CPUS", "0");
+    out.pin_cpus = parse_uint(pin.c_str(), 0) != 0;
 }
 
 }
@@ -0,0 +1,122 @@
+#include "http/chunked.h"
+#include "msg/msg_buffer4.h"
+#include <sys/uio.h>
+#include <cstdio>
+
+namespace http {
+
+namespace {
+
+const size_t kDecodeIov = 16;
+const uint32_t kMaxSizeLine = 4096;   // 块大小行（含扩展）上限
+const uint32_t kMaxTrailer = 8192;    // trailer 总长上限
+const uint32_t kMaxSizeDigits = 15;   // 块大小最多 15 位十六进制（< 2^60）
+
+inline int hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+}
+
+ChunkedDecoder::Status ChunkedDecoder::decode(const x_msg_t& in, uint32_t& offset, x_msg_t& body) {
+    uint32_t total = in.total_length();
+    while (state_ != State::Done && offset < total) {
+        if (state_ == State::Data) {
+            uint32_t n = static_cast<uint32_t>(chunk_left_ < total - offset ? chunk_left_ : total - offset);
+            body.append_view(in, offset, n);
+            offset += n;
+            chunk_left_ -= n;
+            body_size_ += n;
+            if (chunk_left_ == 0) state_ = State::DataCR;
+            continue;
+        }
+        // 分帧字节：逐段逐字节推进状态，遇到块数据时回到上面整段处理
+        struct iovec iov[kDecodeIov];
+        size_t segs = in.get_iovec(iov, kDecodeIov, offset);
+        if (segs == 0) break;
+        for (size_t s = 0; s < segs && state_ != State::Data && state_ != State::Done; ++s) {
+            const uint8_t* p = static_cast<const uint8_t*>(iov[s].iov_base);
+            const uint8_t* end = p + iov[s].iov_len;
+            for (; p < end && state_ != State::Data && state_ != State::Done; ++p, ++offset) {
+                uint8_t c = *p;
+                switch (state_) {
+                case State::Size: {
+                    if (++line_len_ > kMaxSizeLine) return Status::Error;
+                    int v = hex_value(c);
+                    if (v >= 0) {
+                        if (++digits_ > kMaxSizeDigits) return Status::Error;
+                        chunk_left_ = (chunk_left_ << 4) | static_cast<uint64_t>(v);
+                    } else if (digits_ == 0) {
+                        return Status::Error;
+                    } else if (c == '\r') {
+                        state_ = State::SizeLF;
+                    } else if (c == ';' || c == ' ' || c == '\t') {
+                        state_ = State::Ext;
+                    } else {
+                        return Status::Error;
+                    }
+                    break;
+                }
+                case State::Ext:
+                    if (++line_len_ > kMaxSizeLine) return Status::Error;
+                    if (c == '\r') state_ = State::SizeLF;
+                    break;
+                case State::SizeLF:
+                    if (c != '\n') return Status::Error;
+                    digits_ = 0;
+                    line_len_ = 0;
+                    state_ = chunk_left_ == 0 ? State::TrailerStart : State::Data;
+                    break;
+                case State::DataCR:
+                    if (c != '\r') return Status::Error;
+                    state_ = State::DataLF;
+                    break;
+                case State::DataLF:
+                    if (c != '\n') return Status::Error;
+                    state_ = State::Size;
+                    break;
+                case State::TrailerStart:
+                    if (++line_len_ > kMaxTrailer) return Status::Error;
+                    state_ = c == '\r' ? State::TrailerLF : State::TrailerLine;
+                    break;
+                case State::TrailerLine:
+                    if (++line_len_ > kMaxTrailer) return Status::Error;
+                    if (c == '\n') state_ = State::TrailerStart;
+                    break;
+                case State::TrailerLF:
+                    if (c != '\n') return Status::Error;
+                    state_ = State::Done;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+    return state_ == State::Done ? Status::Done : Status::NeedMore;
+}
+
+void ChunkedDecoder::reset() {
+    state_ = State::Size;
+    chunk_left_ = 0;
+    digits_ = 0;
+    line_len_ = 0;
+    body_size_ = 0;
+}
+
+bool append_chunk(x_msg_t& out, x_buf_pool_t& pool, const char* data, uint32_t len) {
+    if (len == 0) return true;
+    char line[16];
+    int n = std::snprintf(line, sizeof(line), "%x\r\n", len);
+    return out.copy_in(pool, line, static_cast<uint32_t>(n)) && out.copy_in(pool, data, len) &&
+           out.copy_in(pool, "\r\n", 2);
+}
+
+bool append_last_chunk(x_msg_t& out, x_buf_pool_t& pool) {
+    return out.copy_in(pool, "0\r\n\r\n", 5);
+}
+
+}
@@ -0,0 +1,57 @@
+#include "http/header_scanner.h"
+#include "http/byte_scan.h"
+#include "msg/msg_buffer4.h"
+#include <sys/uio.h>
+
+namespace http {
+
+namespace {
+
+const size_t kScanIov = 16;
+
+// base[i] 为 '\n' 时，其前 k 个字节（k = 1..3）；不在本段内的取自 recent
+inline uint8_t back(const uint8_t* base, size_t i, size_t k, uint32_t recent) {
+    if (i >= k) return base[i - k];
+    return static_cast<uint8_t>(recent >> (8 * (k - i - 1)));
+}
+
+}
+
+uint32_t HeaderScanner::scan(const x_msg_t& msg, uint32_t limit) {
+    if (header_len_ != 0) return header_len_;
+    uint32_t total = msg.total_length();
+    if (total > limit) total = limit;
+    while (scanned_ < total) {
+        struct iovec iov[kScanIov];
+        size_t n = msg.get_iovec(iov, kScanIov, scanned_);
+        if (n == 0) break;
+        for (size_t s = 0; s < n && scanned_ < total; ++s) {
+            const uint8_t* base = static_cast<const uint8_t*>(iov[s].iov_base);
+            size_t len = iov[s].iov_len;
+            if (len > total - scanned_) len = total - scanned_;
+            const char* begin = reinterpret_cast<const char*>(base);
+            const char* end = begin + len;
+            for (const char* p = find_byte(begin, end, '\n'); p; p = find_byte(p + 1, end, '\n')) {
+                size_t i = static_cast<size_t>(p - begin);
+                if (back(base, i, 1, recent_) == '\r' && back(base, i, 2, recent_) == '\n' &&
+                    back(base, i, 3, recent_) == '\r') {
+                    header_len_ = scanned_ + static_cast<uint32_t>(i) + 1;
+                    scanned_ = header_len_;
+                    return header_len_;
+                }
+            }
+            for (size_t i = len > 3 ? len - 3 : 0; i < len; ++i)
+                recent_ = ((recent_ << 8) | base[i]) & 0xffffff;
+            scanned_ += static_cast<uint32_t>(len);
+        }
+    }
+    return 0;
+}
+
+void HeaderScanner::reset() {
+    scanned_ = 0;
+    header_len_ = 0;
+    recent_ = 0;
+}
+
+}
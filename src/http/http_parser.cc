@@ -1,10 +1,10 @@
 #include "http/http_parser.h"
+#include "http/byte_scan.h"
 #include "msg/msg_buffer4.h"
-#include <cstring>
+#include <sys/uio.h>
 #include <algorithm>
-#include <cctype>
+#include <charconv>
 #include <string>
-#include <vector>
 
 namespace http {
 
@@ -32,66 +32,136 @@ void normalize_path(std::string& path) {
     path = std::move(out);
 }
 
-bool parse_request(const x_msg_t& msg, HttpRequest& req) {
-    uint32_t len = msg.total_length();
+namespace {
+
+std::string_view view(const char* b, const char* e) {
+    return std::string_view(b, static_cast<size_t>(e - b));
+}
+
+std::string_view trim(const char* b, const char* e) {
+    while (b < e && (*b == ' ' || *b == '\t')) ++b;
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t')) --e;
+    return view(b, e);
+}
+
+// 路径是否已是 normalize_path 的输出形式（/ 开头，无空段、. 与 ..，非根不以 / 结尾），是则直接用视图
+bool is_normalized(std::string_view p) {
+    if (p.empty() || p[0] != '/') return false;
+    if (p.size() == 1) return true;
+    if (p.back() == '/') return false;
+    size_t i = 1;
+    while (i < p.size()) {
+        size_t slash = p.find('/', i);
+        if (slash == std::string_view::npos) slash = p.size();
+        std::string_view seg = p.substr(i, slash - i);
+        if (seg.empty() || seg == "." || seg == "..") return false;
+        i = slash + 1;
+    }
+    return true;
+}
+
+// 严格解析 Content-Length：整个值必须是十进制数字且不溢出；重复出现时必须与之前的值相同。
+// 连接会复用并流水线处理请求，宽松解析会让请求边界错位（请求走私），不合法时整个请求按 400 拒绝
+bool set_content_length(HttpRequest& req, std::string_view value) {
+    if (value.empty() || value[0] == '-') return false;  // from_chars 接受负号
+    int64_t cl = 0;
+    auto r = std::from_chars(value.data(), value.data() + value.size(), cl);
+    if (r.ec != std::errc() || r.ptr != value.data() + value.size()) return false;
+    if (req.content_length >= 0 && req.content_length != cl) return false;
+    req.content_length = cl;
+    return true;
+}
+
+// 返回 false 表示头值不合法，请求须拒绝
+bool set_known_header(HttpRequest& req, std::string_view name, std::string_view value) {
+    switch (name.size()) {
+    case 4:
+        if (iequals(name, "Host")) req.host = value;
+        break;
+    case 10:
+        if (iequals(name, "Connection")) req.connection = value;
+        break;
+    case 11:
+        if (iequals(name, "Content-MD5")) req.content_md5 = value;
+        break;
+    case 12:
+        if (iequals(name, "Content-Type")) req.content_type = value;
+        break;
+    case 14:
+        if (iequals(name, "Content-Length")) return set_content_length(req, value);
+        break;
+    case 17:
+        if (iequals(name, "Transfer-Encoding")) req.transfer_encoding = value;
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+}
+
+bool parse_request(const x_msg_t& msg, uint32_t header_len, HttpRequest& req) {
+    req.method = req.path = req.query = req.version = std::string_view();
+    req.host = req.content_type = req.content_md5 = req.connection = std::string_view();
+    req.transfer_encoding = std::string_view();
+    req.content_length = -1;
+    req.header_count = 0;
+    req.hold_.clear();
+
+    uint32_t len = std::min(msg.total_length(), header_len);
     if (len == 0) return false;
-    std::vector<char> buf(len + 1);
-    uint32_t n = msg.copy_out(buf.data(), len);
-    buf[n] = '\0';
-    char* p = buf.data();
-    char* end = p + n;
+    // 请求头整体在第一个 unit 内时直接在 unit 上解析并持有其引用，否则线性化到 linear_
+    const char* base;
+    struct iovec first;
+    if (msg.get_iovec(&first, 1) == 1 && first.iov_len >= len) {
+        base = static_cast<const char*>(first.iov_base);
+        req.hold_.append_view(msg, 0, len);
+    } else {
+        req.linear_.resize(len);
+        msg.copy_out(&req.linear_[0], len);
+        base = req.linear_.data();
+    }
+    const char* p = base;
+    const char* end = base + len;
 
     // 请求行: METHOD SP URI SP HTTP/1.x
-    char* line_end = static_cast<char*>(std::memchr(p, '\r', end - p));
-    if (!line_end || line_end + 1 >= end || line_end[1] != '\n') return false;
-    *line_end = '\0';
-    std::string first_line(p);
-    p = line_end + 2;
-
-    size_t sp1 = first_line.find(' ');
-    if (sp1 == std::string::npos) return false;
-    req.method = first_line.substr(0, sp1);
-    size_t sp2 = first_line.find(' ', sp1 + 1);
-    if (sp2 == std::string::npos) return false;
-    std::string uri = first_line.substr(sp1 + 1, sp2 - sp1 - 1);
+    const char* cr = find_byte(p, end, '\r');
+    if (!cr || cr + 1 >= end || cr[1] != '\n') return false;
+    const char* sp1 = find_byte(p, cr, ' ');
+    if (!sp1) return false;
+    const char* sp2 = find_byte(sp1 + 1, cr, ' ');
+    if (!sp2) return false;
+    req.method = view(p, sp1);
+    std::string_view uri = view(sp1 + 1, sp2);
+    req.version = view(sp2 + 1, cr);
 
     size_t qm = uri.find('?');
-    if (qm != std::string::npos) {
-        req.path = uri.substr(0, qm);
-        req.query = uri.substr(qm + 1);
+    std::string_view raw_path = uri.substr(0, qm);
+    if (qm != std::string_view::npos) req.query = uri.substr(qm + 1);
+    if (is_normalized(raw_path)) {
+        req.path = raw_path;
     } else {
-        req.path = uri;
-        req.query.clear();
+        req.path_buf_.assign(raw_path.data(), raw_path.size());
+        normalize_path(req.path_buf_);
+        req.path = req.path_buf_;
     }
-    normalize_path(req.path);
 
     // 请求头
+    p = cr + 2;
     while (p < end) {
-        line_end = static_cast<char*>(std::memchr(p, '\r', end - p));
-        if (!line_end || line_end + 1 >= end) return false;
-        if (line_end[1] != '\n') return false;
-        *line_end = '\0';
-        if (p[0] == '\0') { p = line_end + 2; break; }  // 空行，头结束
-        char* colon = static_cast<char*>(std::memchr(p, ':', end - p));
+        cr = find_byte(p, end, '\r');
+        if (!cr || cr + 1 >= end || cr[1] != '\n') return false;
+        if (cr == p) break;  // 空行，头结束
+        const char* colon = find_byte(p, cr, ':');
         if (colon) {
-            std::string key(p, colon - p);
-            char* val_start = colon + 1;
-            while (val_start < line_end && (*val_start == ' ' || *val_start == '\t')) ++val_start;
-            std::string val(val_start, line_end - val_start);
-            while (!val.empty() && (val.back() == ' ' || val.back() == '\t')) val.pop_back();
-            if (key.size() == 4 && (key[0] == 'H' || key[0] == 'h') && (key[1] == 'o' || key[1] == 'O') && (key[2] == 's' || key[2] == 'S') && (key[3] == 't' || key[3] == 'T'))
-                req.host = val;
-            else if (key.size() == 12 && std::equal(key.begin(), key.end(), "Content-Type", [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); }))
-                req.content_type = val;
-            else if (key.size() == 14 && std::equal(key.begin(), key.end(), "Content-MD5", [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); }))
-                req.content_md5 = val;
-            else if (key.size() == 14 && std::equal(key.begin(), key.end(), "Content-Length", [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); })) {
-                int64_t cl = 0;
-                for (char c : val) { if (c >= '0' && c <= '9') cl = cl * 10 + (c - '0'); }
-                req.content_length = cl;
-            }
+            if (req.header_count == HttpRequest::kMaxHeaders) return false;
+            HeaderField& f = req.headers[req.header_count++];
+            f.name = view(p, colon);
+            f.value = trim(colon + 1, cr);
+            if (!set_known_header(req, f.name, f.value)) return false;
         }
-        p = line_end + 2;
+        p = cr + 2;
     }
     return true;
 }
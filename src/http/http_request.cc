@@ -8,7 +8,7 @@ namespace http {
 static bool is_path_sep(char c) { return c == '/'; }
 
 // 对 query 参数值做 URL 解码
-static std::string urldecode_param_value(const std::string& v) {
+static std::string urldecode_param_value(std::string_view v) {
     std::string out;
     out.reserve(v.size());
     for (size_t i = 0; i < v.size(); ++i) {
@@ -31,9 +31,66 @@ static std::string urldecode_param_value(const std::string& v) {
     return out;
 }
 
+// Connection 头按逗号分隔的 token 中是否含 token（不区分大小写）
+static bool has_connection_token(std::string_view header, const char* token) {
+    size_t tlen = std::char_traits<char>::length(token);
+    size_t pos = 0;
+    while (pos <= header.size()) {
+        size_t comma = header.find(',', pos);
+        size_t end = (comma == std::string_view::npos) ? header.size() : comma;
+        size_t b = pos, e = end;
+        while (b < e && (header[b] == ' ' || header[b] == '\t')) ++b;
+        while (e > b && (header[e - 1] == ' ' || header[e - 1] == '\t')) --e;
+        if (e - b == tlen && std::equal(header.begin() + b, header.begin() + e, token,
+                [](char a, char c) { return std::tolower(static_cast<unsigned char>(a)) == c; }))
+            return true;
+        if (comma == std::string_view::npos) break;
+        pos = comma + 1;
+    }
+    return false;
+}
+
+static inline char ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (ascii_lower(a[i]) != ascii_lower(b[i])) return false;
+    }
+    return true;
+}
+
+std::string_view HttpRequest::header(std::string_view name) const {
+    for (uint32_t i = 0; i < header_count; ++i) {
+        if (iequals(headers[i].name, name)) return headers[i].value;
+    }
+    return {};
+}
+
+bool HttpRequest::wants_keep_alive() const {
+    if (has_connection_token(connection, "close")) return false;
+    if (version == "HTTP/1.0") return has_connection_token(connection, "keep-alive");
+    return true;
+}
+
+bool HttpRequest::expects_continue() const {
+    return version != "HTTP/1.0" && iequals(header("Expect"), "100-continue");
+}
+
+bool HttpRequest::is_chunked() const {
+    std::string_view te = transfer_encoding;
+    size_t comma = te.rfind(',');
+    if (comma != std::string_view::npos) te.remove_prefix(comma + 1);
+    while (!te.empty() && (te.front() == ' ' || te.front() == '\t')) te.remove_prefix(1);
+    while (!te.empty() && (te.back() == ' ' || te.back() == '\t')) te.remove_suffix(1);
+    return iequals(te, "chunked");
+}
+
 // 废弃
 bool HttpRequest::is_bucket_path() const {
-    std::string p = path;
+    std::string p(path);
     while (!p.empty() && is_path_sep(p.back())) p.pop_back();
     if (p.empty()) return true;
     size_t first = 0;
@@ -43,18 +100,17 @@ bool HttpRequest::is_bucket_path() const {
     return slash == std::string::npos;  // 只有一层
 }
 
-std::string HttpRequest::get_query_param(const std::string& key) const {
+std::string HttpRequest::get_query_param(std::string_view key) const {
     if (query.empty()) return {};
-    std::string q = query;
+    std::string_view q = query;
     size_t pos = 0;
     while (pos < q.size()) {
         size_t amp = q.find('&', pos);
-        size_t end = (amp == std::string::npos) ? q.size() : amp;
+        size_t end = (amp == std::string_view::npos) ? q.size() : amp;
         size_t eq = q.find('=', pos);
-        if (eq != std::string::npos && eq < end) {
+        if (eq != std::string_view::npos && eq < end) {
             std::string k = urldecode_param_value(q.substr(pos, eq - pos));  // key 也仅 %XX 解码，与 value 一致
-            std::string v = q.substr(eq + 1, end - eq - 1);
-            if (k == key) return urldecode_param_value(v);
+            if (k == key) return urldecode_param_value(q.substr(eq + 1, end - eq - 1));
         }
         pos = end + (end < q.size() ? 1 : 0);
     }
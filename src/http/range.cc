@@ -0,0 +1,70 @@
+#include "http/range.h"
+
+namespace http {
+
+static std::string_view trim_ws(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// 十进制无符号数，空串、非数字或溢出返回 false
+static bool parse_u64(std::string_view s, uint64_t& v) {
+    if (s.empty() || s.size() > 19) return false;
+    v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+RangeResult parse_range(std::string_view header, uint64_t size, std::vector<ByteRange>& out) {
+    out.clear();
+    header = trim_ws(header);
+    static const char kUnit[] = "bytes=";
+    if (header.compare(0, sizeof(kUnit) - 1, kUnit) != 0) return RangeResult::None;
+    header.remove_prefix(sizeof(kUnit) - 1);
+
+    size_t specs = 0;
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        std::string_view spec = trim_ws(header.substr(0, comma));
+        header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+        if (spec.empty()) continue;  // 允许 "a-b, , c-d" 中的空元素
+        if (++specs > kMaxRanges) {
+            out.clear();
+            return RangeResult::None;
+        }
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos) {
+            out.clear();
+            return RangeResult::None;
+        }
+        std::string_view a = trim_ws(spec.substr(0, dash));
+        std::string_view b = trim_ws(spec.substr(dash + 1));
+        uint64_t first = 0, last = 0;
+        if (a.empty()) {
+            // 后缀区间：最后 n 字节
+            if (!parse_u64(b, last)) {
+                out.clear();
+                return RangeResult::None;
+            }
+            if (last == 0 || size == 0) continue;
+            uint64_t n = last < size ? last : size;
+            out.push_back(ByteRange{size - n, n});
+            continue;
+        }
+        if (!parse_u64(a, first) || (!b.empty() && (!parse_u64(b, last) || last < first))) {
+            out.clear();
+            return RangeResult::None;
+        }
+        if (first >= size) continue;  // 越界，丢弃
+        if (b.empty() || last >= size) last = size - 1;
+        out.push_back(ByteRange{first, last - first + 1});
+    }
+    if (specs == 0) return RangeResult::None;
+    return out.empty() ? RangeResult::Unsatisfiable : RangeResult::Satisfiable;
+}
+
+}
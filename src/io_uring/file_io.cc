@@ -1,18 +1,28 @@
 #include "io_uring/file_io.h"
+#include "metrics/metrics.h"
 
 #include <fcntl.h>
 #include <liburing.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
 
 namespace uring {
 
 namespace {
 
-constexpr unsigned RING_ENTRIES = 4;
+constexpr unsigned RING_ENTRIES = 64;
 
+// 本线程的文件 I/O ring。多个调用方（read_file/write_file、多个 FileWriter）共用：
+// user_data 指向各自的 FileOp，任何一方收割 CQE 时都把结果写回对应的 FileOp。
 struct RingHolder {
     struct io_uring ring;
     bool inited{false};
@@ -26,6 +36,45 @@ struct RingHolder {
         return &ring;
     }
 
+    // 取 sqe，SQ 满时先提交再取
+    struct io_uring_sqe* get_sqe() {
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        if (!sqe) {
+            io_uring_submit(&ring);
+            sqe = io_uring_get_sqe(&ring);
+        }
+        return sqe;
+    }
+
+    void complete(struct io_uring_cqe* cqe) {
+        FileOp* op = static_cast<FileOp*>(io_uring_cqe_get_data(cqe));
+        if (op) {
+            op->res = cqe->res;
+            op->done = true;
+        }
+        io_uring_cqe_seen(&ring, cqe);
+    }
+
+    // 收割已完成的 CQE，不等待
+    void poll() {
+        struct io_uring_cqe* cqe = nullptr;
+        while (io_uring_peek_cqe(&ring, &cqe) == 0 && cqe)
+            complete(cqe);
+    }
+
+    // 等待 op 完成（期间顺带收割其他操作的 CQE）。返回 0 或 -errno（等待本身失败）
+    int wait(FileOp& op) {
+        io_uring_submit(&ring);
+        while (!op.done) {
+            struct io_uring_cqe* cqe = nullptr;
+            int ret = io_uring_wait_cqe(&ring, &cqe);
+            if (ret == -EINTR) continue;
+            if (ret != 0) return ret;
+            complete(cqe);
+        }
+        return 0;
+    }
+
     ~RingHolder() {
         if (inited)
             io_uring_queue_exit(&ring);
@@ -34,14 +83,121 @@ struct RingHolder {
 
 static thread_local RingHolder t_ring;
 
+metrics::Counter& m_commit_batches = metrics::counter("commit.batches");
+metrics::Counter& m_commit_requests = metrics::counter("commit.requests");
+metrics::Counter& m_commit_fsyncs = metrics::counter("commit.fsyncs");
+metrics::Counter& m_commit_batch_max = metrics::counter("commit.batch_max");
+metrics::Counter& m_commit_fsync_us_total = metrics::counter("commit.fsync_us_total");
+metrics::Counter& m_commit_fsync_us_max = metrics::counter("commit.fsync_us_max");
+metrics::Counter& m_commit_errors = metrics::counter("commit.errors");
+
+// 一次 sync_files 调用：在栈上，由提交线程填结果后唤醒
+struct CommitWaiter {
+    const std::vector<int>* fds;
+    bool datasync;
+    int res{0};
+    bool done{false};
+};
+
+struct GroupCommit {
+    std::mutex mutex;
+    std::condition_variable pending_cv;  // 提交线程等请求
+    std::condition_variable done_cv;     // 等待者等所在批次完成
+    std::vector<CommitWaiter*> pending;
+    std::thread thread;
+    bool running{false};
+    bool stopping{false};
+    uint32_t window_us{0};
+};
+
+GroupCommit g_commit;
+
+int sync_fd_direct(int fd, bool datasync) {
+    int ret = datasync ? ::fdatasync(fd) : ::fsync(fd);
+    return ret == 0 ? 0 : -errno;
+}
+
+// 同步一批请求涉及的 fd：同一 fd 只同步一次，只要有一个请求要求 fsync 就用 fsync。
+// 每轮最多 RING_ENTRIES 个 IORING_OP_FSYNC 同时在途
+void commit_batch(std::vector<CommitWaiter*>& batch) {
+    std::vector<std::pair<int, bool>> fds;  // (fd, datasync)
+    for (CommitWaiter* w : batch)
+        for (int fd : *w->fds) fds.emplace_back(fd, w->datasync);
+    std::sort(fds.begin(), fds.end());      // 同一 fd 的 fsync（datasync=false）排在前面
+    fds.erase(std::unique(fds.begin(), fds.end(),
+                          [](const std::pair<int, bool>& a, const std::pair<int, bool>& b) { return a.first == b.first; }),
+              fds.end());
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<FileOp> ops(fds.size());
+    bool ring = t_ring.get() != nullptr;
+    for (size_t begin = 0; begin < fds.size(); begin += RING_ENTRIES) {
+        size_t end = std::min<size_t>(begin + RING_ENTRIES, fds.size());
+        for (size_t i = begin; i < end; ++i) {
+            struct io_uring_sqe* sqe = ring ? t_ring.get_sqe() : nullptr;
+            if (!sqe) {
+                ops[i].res = sync_fd_direct(fds[i].first, fds[i].second);
+                continue;
+            }
+            io_uring_prep_fsync(sqe, fds[i].first, fds[i].second ? IORING_FSYNC_DATASYNC : 0);
+            io_uring_sqe_set_data(sqe, &ops[i]);
+            ops[i].done = false;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            if (!ops[i].done && t_ring.wait(ops[i]) != 0) ops[i].res = -EIO;
+        }
+    }
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+
+    int64_t requests = static_cast<int64_t>(batch.size());
+    for (CommitWaiter* w : batch) {
+        for (int fd : *w->fds) {
+            auto it = std::lower_bound(fds.begin(), fds.end(), std::make_pair(fd, false));
+            int res = ops[static_cast<size_t>(it - fds.begin())].res;
+            if (res < 0) {
+                w->res = res;
+                break;
+            }
+        }
+        if (w->res < 0) m_commit_errors.add();
+    }
+    m_commit_batches.add();
+    m_commit_requests.add(requests);
+    m_commit_fsyncs.add(static_cast<int64_t>(fds.size()));
+    m_commit_batch_max.update_max(requests);
+    m_commit_fsync_us_total.add(us);
+    m_commit_fsync_us_max.update_max(us);
+}
+
+void commit_loop() {
+    std::vector<CommitWaiter*> batch;
+    std::unique_lock<std::mutex> lock(g_commit.mutex);
+    while (true) {
+        g_commit.pending_cv.wait(lock, [] { return g_commit.stopping || !g_commit.pending.empty(); });
+        if (g_commit.pending.empty()) break;  // stopping 且队列已空
+        if (g_commit.window_us > 0 && !g_commit.stopping) {
+            // 第一个请求到达后再等一个窗口，让更多请求进入这一批
+            g_commit.pending_cv.wait_for(lock, std::chrono::microseconds(g_commit.window_us),
+                                         [] { return g_commit.stopping; });
+        }
+        batch.swap(g_commit.pending);
+        lock.unlock();
+        commit_batch(batch);
+        lock.lock();
+        for (CommitWaiter* w : batch) w->done = true;
+        batch.clear();
+        g_commit.done_cv.notify_all();
+    }
+    g_commit.running = false;
+}
+
 } 
 
-ssize_t read_file(const std::string& path, void* buf, size_t capacity) {
+ssize_t read_file(const std::string& path, void* buf, size_t capacity, uint64_t offset) {
     if (buf == nullptr || capacity == 0)
         return -1;
 
-    struct io_uring* ring = t_ring.get();
-    if (!ring) {
+    if (!t_ring.get()) {
         errno = ENOMEM;
         return -1;
     }
@@ -50,42 +206,36 @@ ssize_t read_file(const std::string& path, void* buf, size_t capacity) {
     if (fd < 0)
         return -1;
 
-    struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    struct io_uring_sqe* sqe = t_ring.get_sqe();
     if (!sqe) {
         ::close(fd);
         errno = ENOMEM;
         return -1;
     }
 
-    io_uring_prep_read(sqe, fd, buf, capacity, 0);
-    io_uring_sqe_set_data(sqe, nullptr);
-    io_uring_submit(ring);
-
-    struct io_uring_cqe* cqe = nullptr;
-    int ret = io_uring_wait_cqe(ring, &cqe);
+    FileOp op;
+    op.done = false;
+    io_uring_prep_read(sqe, fd, buf, capacity, offset);
+    io_uring_sqe_set_data(sqe, &op);
+    int ret = t_ring.wait(op);
+    ::close(fd);
     if (ret != 0) {
-        ::close(fd);
         errno = -ret;
         return -1;
     }
 
-    ssize_t res = static_cast<ssize_t>(cqe->res);
-    io_uring_cqe_seen(ring, cqe);
-    ::close(fd);
-
-    if (res < 0) {
-        errno = -static_cast<int>(res);
+    if (op.res < 0) {
+        errno = -op.res;
         return -1;
     }
-    return res;
+    return op.res;
 }
 
-ssize_t write_file(const std::string& path, const void* buf, size_t size) {
+ssize_t write_file(const std::string& path, const void* buf, size_t size, bool sync) {
     if (buf == nullptr && size > 0)
         return -1;
 
-    struct io_uring* ring = t_ring.get();
-    if (!ring) {
+    if (!t_ring.get()) {
         errno = ENOMEM;
         return -1;
     }
@@ -99,34 +249,352 @@ ssize_t write_file(const std::string& path, const void* buf, size_t size) {
         return 0;
     }
 
-    struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    struct io_uring_sqe* sqe = t_ring.get_sqe();
     if (!sqe) {
         ::close(fd);
         errno = ENOMEM;
         return -1;
     }
 
+    FileOp op;
+    op.done = false;
     io_uring_prep_write(sqe, fd, buf, size, 0);
-    io_uring_sqe_set_data(sqe, nullptr);
-    io_uring_submit(ring);
-
-    struct io_uring_cqe* cqe = nullptr;
-    int ret = io_uring_wait_cqe(ring, &cqe);
+    io_uring_sqe_set_data(sqe, &op);
+    int ret = t_ring.wait(op);
+    if (ret == 0 && op.res >= 0 && sync && !sync_files({fd}, true)) ret = -errno;
+    ::close(fd);
     if (ret != 0) {
-        ::close(fd);
         errno = -ret;
         return -1;
     }
 
-    ssize_t res = static_cast<ssize_t>(cqe->res);
-    io_uring_cqe_seen(ring, cqe);
-    ::close(fd);
-
-    if (res < 0) {
-        errno = -static_cast<int>(res);
+    if (op.res < 0) {
+        errno = -op.res;
         return -1;
     }
-    return res;
+    return op.res;
 }
 
-} 
+void unlink_files(const std::vector<std::string>& paths, std::vector<int>& results, uint32_t window) {
+    results.assign(paths.size(), 0);
+    window = std::min<uint32_t>(std::max<uint32_t>(window, 1), RING_ENTRIES);
+    size_t next = 0;
+    if (t_ring.get()) {
+        struct Slot {
+            FileOp op;
+            size_t index{0};
+            bool busy{false};
+        };
+        std::vector<Slot> slots(window);
+        uint32_t busy = 0;
+        while (next < paths.size() || busy > 0) {
+            // 空闲槽全部补上，下面 wait 时一次提交
+            for (Slot& s : slots) {
+                if (s.busy || next >= paths.size()) continue;
+                struct io_uring_sqe* sqe = t_ring.get_sqe();
+                if (!sqe) break;
+                s.op = FileOp();
+                s.op.done = false;
+                s.index = next++;
+                s.busy = true;
+                ++busy;
+                io_uring_prep_unlinkat(sqe, AT_FDCWD, paths[s.index].c_str(), 0);
+                io_uring_sqe_set_data(sqe, &s.op);
+            }
+            if (busy == 0) break;  // 取不到 sqe：剩下的同步删除
+            // 等任一在途的删除完成（期间顺带收割其他槽的 CQE）
+            for (Slot& s : slots) {
+                if (!s.busy) continue;
+                if (t_ring.wait(s.op) != 0) s.op.res = -EIO;
+                s.op.done = true;
+                break;
+            }
+            for (Slot& s : slots) {
+                if (!s.busy || !s.op.done) continue;
+                int res = s.op.res;
+                if (res == -EINVAL || res == -EOPNOTSUPP)  // 内核不支持 IORING_OP_UNLINKAT
+                    res = ::unlink(paths[s.index].c_str()) == 0 ? 0 : -errno;
+                results[s.index] = res;
+                s.busy = false;
+                --busy;
+            }
+        }
+    }
+    for (; next < paths.size(); ++next)
+        results[next] = ::unlink(paths[next].c_str()) == 0 ? 0 : -errno;
+}
+
+// ---------------------------------------------------------------------------
+// 组提交
+// ---------------------------------------------------------------------------
+
+void start_group_commit(uint32_t window_us) {
+    std::lock_guard<std::mutex> lock(g_commit.mutex);
+    if (g_commit.running) return;
+    g_commit.running = true;
+    g_commit.stopping = false;
+    g_commit.window_us = window_us;
+    g_commit.thread = std::thread(commit_loop);
+    metrics::gauge("commit.batch_avg", []() -> int64_t {
+        int64_t n = m_commit_batches.get();
+        return n > 0 ? m_commit_requests.get() / n : 0;
+    });
+    metrics::gauge("commit.fsync_us_avg", []() -> int64_t {
+        int64_t n = m_commit_batches.get();
+        return n > 0 ? m_commit_fsync_us_total.get() / n : 0;
+    });
+}
+
+void stop_group_commit() {
+    std::thread t;
+    {
+        std::lock_guard<std::mutex> lock(g_commit.mutex);
+        if (!g_commit.thread.joinable()) return;
+        g_commit.stopping = true;
+        t.swap(g_commit.thread);
+    }
+    g_commit.pending_cv.notify_one();
+    t.join();
+}
+
+bool sync_files(const std::vector<int>& fds, bool datasync) {
+    if (fds.empty()) return true;
+    std::unique_lock<std::mutex> lock(g_commit.mutex);
+    if (!g_commit.running) {
+        lock.unlock();
+        for (int fd : fds) {
+            int res = sync_fd_direct(fd, datasync);
+            if (res < 0) {
+                errno = -res;
+                return false;
+            }
+        }
+        return true;
+    }
+    CommitWaiter w;
+    w.fds = &fds;
+    w.datasync = datasync;
+    g_commit.pending.push_back(&w);
+    g_commit.pending_cv.notify_one();
+    g_commit.done_cv.wait(lock, [&w] { return w.done; });
+    if (w.res < 0) {
+        errno = -w.res;
+        return false;
+    }
+    return true;
+}
+
+bool sync_paths(const std::vector<std::string>& paths, bool datasync) {
+    std::vector<int> fds;
+    fds.reserve(paths.size());
+    bool ok = true;
+    for (const std::string& path : paths) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            ok = false;
+            break;
+        }
+        fds.push_back(fd);
+    }
+    int saved = errno;
+    if (ok && !sync_files(fds, datasync)) {
+        ok = false;
+        saved = errno;
+    }
+    for (int fd : fds) ::close(fd);
+    errno = saved;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// FileWriter
+// ---------------------------------------------------------------------------
+
+FileWriter::FileWriter(uint32_t window)
+    : window_(window > 0 ? window : 1), slots_(new Slot[window > 0 ? window : 1]) {}
+
+FileWriter::~FileWriter() {
+    finish();
+}
+
+bool FileWriter::open(const std::string& path) {
+    if (!t_ring.get()) {
+        errno = ENOMEM;
+        return false;
+    }
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return fd_ >= 0;
+}
+
+uint32_t FileWriter::inflight() const {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < window_; ++i)
+        if (!slots_[i].op.done) ++n;
+    return n;
+}
+
+bool FileWriter::reap(Slot& slot) {
+    int ret = t_ring.wait(slot.op);
+    if (ret != 0 || slot.op.res < 0 || static_cast<uint32_t>(slot.op.res) != slot.expected)
+        failed_ = true;  // 普通文件上的短写只在空间不足等异常时出现，按失败处理
+    slot.data.clear();
+    slot.expected = 0;
+    return !failed_;
+}
+
+FileWriter::Slot* FileWriter::free_slot() {
+    t_ring.poll();
+    Slot* oldest = nullptr;
+    for (uint32_t i = 0; i < window_; ++i) {
+        Slot& s = slots_[i];
+        if (s.op.done) {
+            if (s.expected > 0 && !reap(s)) return nullptr;  // 已完成未检查：检查结果并释放数据
+            return &s;
+        }
+        if (!oldest) oldest = &s;
+    }
+    // 窗口已满：等待其中一个在途写完成
+    if (!oldest || !reap(*oldest)) return nullptr;
+    return oldest;
+}
+
+bool FileWriter::submit(const x_msg_t& data, uint32_t offset, uint32_t len) {
+    while (len > 0) {
+        Slot* slot = free_slot();
+        if (!slot) return false;
+        slot->data.append_view(data, offset, len);
+        size_t n = slot->data.get_iovec(slot->iov, kMaxIov);
+        uint32_t covered = 0;
+        for (size_t i = 0; i < n; ++i) covered += static_cast<uint32_t>(slot->iov[i].iov_len);
+        if (covered < len) {
+            // 段数超过单次 writev 上限：本次只写前 kMaxIov 段
+            slot->data.clear();
+            slot->data.append_view(data, offset, covered);
+        }
+        struct io_uring_sqe* sqe = t_ring.get_sqe();
+        if (!sqe) {
+            slot->data.clear();
+            failed_ = true;
+            return false;
+        }
+        io_uring_prep_writev(sqe, fd_, slot->iov, static_cast<unsigned>(n), offset_);
+        io_uring_sqe_set_data(sqe, &slot->op);
+        slot->op.done = false;
+        slot->expected = covered;
+        offset_ += covered;
+        offset += covered;
+        len -= covered;
+        io_uring_submit(&t_ring.ring);
+        max_inflight_ = std::max(max_inflight_, inflight());
+    }
+    return true;
+}
+
+bool FileWriter::append(const x_msg_t& data) {
+    if (fd_ < 0 || failed_) return false;
+    return submit(data, 0, data.total_length());
+}
+
+bool FileWriter::finish() {
+    for (uint32_t i = 0; i < window_; ++i) {
+        Slot& s = slots_[i];
+        if (!s.op.done || s.expected > 0) reap(s);
+    }
+    if (fd_ >= 0) {
+        if (::close(fd_) != 0) failed_ = true;
+        fd_ = -1;
+    }
+    return !failed_;
+}
+
+// ---------------------------------------------------------------------------
+// FileReader
+// ---------------------------------------------------------------------------
+
+FileReader::FileReader(x_buf_pool_t& pool, uint32_t window)
+    : pool_(pool), window_(window > 0 ? window : 1), slots_(new Slot[window > 0 ? window : 1]) {}
+
+FileReader::~FileReader() {
+    drain();
+    if (owns_fd_) ::close(fd_);
+}
+
+bool FileReader::open(const std::string& path, uint64_t offset, uint64_t length) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    if (!open(fd, offset, length)) {
+        ::close(fd);
+        return false;
+    }
+    owns_fd_ = true;
+    return true;
+}
+
+bool FileReader::open(int fd, uint64_t offset, uint64_t length) {
+    if (!t_ring.get()) {
+        errno = ENOMEM;
+        return false;
+    }
+    fd_ = fd;
+    offset_ = offset;
+    end_ = offset + length;
+    length_ = length;
+    fill();
+    return true;
+}
+
+void FileReader::fill() {
+    bool submitted = false;
+    while (queued_ < window_ && offset_ < end_) {
+        Slot& s = slots_[(head_ + queued_) % window_];
+        s.unit = pool_.get();
+        if (!s.unit) break;  // 池暂时耗尽：少预读，下次 next 再补
+        struct io_uring_sqe* sqe = t_ring.get_sqe();
+        if (!sqe) {
+            s.unit = x_buf_ptr();
+            break;
+        }
+        s.len = static_cast<uint32_t>(std::min<uint64_t>(s.unit->capacity, end_ - offset_));
+        io_uring_prep_read(sqe, fd_, s.unit->data_ptr, s.len, offset_);
+        io_uring_sqe_set_data(sqe, &s.op);
+        s.op.done = false;
+        offset_ += s.len;
+        ++queued_;
+        submitted = true;
+    }
+    if (submitted) io_uring_submit(&t_ring.ring);
+}
+
+int64_t FileReader::next(x_msg_t& out, uint32_t max_bytes) {
+    if (delivered_ >= length_) return 0;
+    fill();
+    if (queued_ == 0) return -1;  // 没有可等待的读：池耗尽
+    int64_t appended = 0;
+    bool first = true;
+    t_ring.poll();
+    while (queued_ > 0) {
+        Slot& s = slots_[head_];
+        if (!first && (!s.op.done || appended + s.len > max_bytes)) break;
+        if (t_ring.wait(s.op) != 0 || s.op.res != static_cast<int>(s.len)) return -1;  // 短读：文件被截断
+        out.append_unit(s.unit.get(), 0, s.len);
+        s.unit = x_buf_ptr();
+        appended += s.len;
+        delivered_ += s.len;
+        head_ = (head_ + 1) % window_;
+        --queued_;
+        first = false;
+    }
+    fill();
+    return appended;
+}
+
+void FileReader::drain() {
+    for (uint32_t i = 0; i < queued_; ++i) {
+        Slot& s = slots_[(head_ + i) % window_];
+        t_ring.wait(s.op);  // 内核可能仍在写 unit，等完成后才能归还
+        s.unit = x_buf_ptr();
+    }
+    queued_ = 0;
+}
+
+}
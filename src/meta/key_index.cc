@@ -0,0 +1,498 @@
+#include "meta/key_index.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace meta {
+
+struct KeyIndex::Node {
+    explicit Node(bool is_leaf) : leaf(is_leaf) {}
+    virtual ~Node() = default;
+    bool leaf;
+};
+
+// 叶子：key i = prefix + suffixes[ends[i-1], ends[i])
+struct KeyIndex::Leaf : KeyIndex::Node {
+    Leaf() : Node(true) {}
+    std::string prefix;
+    std::string suffixes;
+    std::vector<uint32_t> ends;
+    std::vector<uint32_t> values;
+    Leaf* next{nullptr};
+
+    uint32_t count() const { return static_cast<uint32_t>(ends.size()); }
+
+    std::string_view suffix(uint32_t i) const {
+        uint32_t b = i ? ends[i - 1] : 0;
+        return std::string_view(suffixes.data() + b, ends[i] - b);
+    }
+
+    void key(uint32_t i, std::string& out) const {
+        std::string_view s = suffix(i);
+        out.assign(prefix);
+        out.append(s.data(), s.size());
+    }
+
+    // 第一个 >= key 的位置，exact 表示该位置的 key 与之相等
+    uint32_t lower_bound(std::string_view key, bool& exact) const {
+        exact = false;
+        int c = key.substr(0, prefix.size()).compare(prefix);
+        if (c < 0) return 0;                // key 小于（或是 prefix 的真前缀）：小于叶内所有 key
+        if (c > 0) return count();
+        std::string_view rest = key.substr(prefix.size());
+        uint32_t lo = 0, hi = count();
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (suffix(mid) < rest) lo = mid + 1;
+            else hi = mid;
+        }
+        exact = lo < count() && suffix(lo) == rest;
+        return lo;
+    }
+
+    // 追加解码后的全部条目
+    void decode(std::vector<std::string>& keys, std::vector<uint32_t>& vals) const {
+        for (uint32_t i = 0; i < count(); ++i) {
+            keys.emplace_back();
+            key(i, keys.back());
+        }
+        vals.insert(vals.end(), values.begin(), values.end());
+    }
+
+    // 用有序的 keys[from, to) 重建，公共前缀取首尾两个 key 的公共前缀（Keys 为 string 或 string_view 的 vector）
+    template <class Keys>
+    void assign(const Keys& keys, const std::vector<uint32_t>& vals, size_t from, size_t to) {
+        prefix.clear();
+        suffixes.clear();
+        ends.clear();
+        values.assign(vals.begin() + from, vals.begin() + to);
+        if (from == to) return;
+        std::string_view a = keys[from];
+        std::string_view b = keys[to - 1];
+        size_t plen = std::mismatch(a.begin(), a.begin() + std::min(a.size(), b.size()), b.begin()).first - a.begin();
+        prefix.assign(a.data(), plen);
+        size_t bytes = 0;
+        for (size_t i = from; i < to; ++i) bytes += std::string_view(keys[i]).size() - plen;
+        suffixes.reserve(bytes);
+        ends.reserve(to - from);
+        for (size_t i = from; i < to; ++i) {
+            std::string_view k = keys[i];
+            suffixes.append(k.data() + plen, k.size() - plen);
+            ends.push_back(static_cast<uint32_t>(suffixes.size()));
+        }
+    }
+
+    void insert_at(uint32_t pos, std::string_view key, uint32_t value) {
+        if (key.substr(0, prefix.size()) != prefix) {
+            // 新 key 不以叶内公共前缀开头：缩短前缀后整叶重建（只在前缀变化时发生）
+            std::vector<std::string> keys;
+            std::vector<uint32_t> vals;
+            decode(keys, vals);
+            keys.insert(keys.begin() + pos, std::string(key));
+            vals.insert(vals.begin() + pos, value);
+            assign(keys, vals, 0, keys.size());
+            return;
+        }
+        std::string_view s = key.substr(prefix.size());
+        uint32_t off = pos ? ends[pos - 1] : 0;
+        uint32_t len = static_cast<uint32_t>(s.size());
+        suffixes.insert(off, s.data(), s.size());
+        ends.insert(ends.begin() + pos, off + len);
+        for (uint32_t j = pos + 1; j < count(); ++j) ends[j] += len;
+        values.insert(values.begin() + pos, value);
+    }
+
+    void erase_at(uint32_t pos) {
+        uint32_t b = pos ? ends[pos - 1] : 0;
+        uint32_t len = ends[pos] - b;
+        suffixes.erase(b, len);
+        ends.erase(ends.begin() + pos);
+        for (uint32_t j = pos; j < count(); ++j) ends[j] -= len;
+        values.erase(values.begin() + pos);
+    }
+};
+
+// 内部节点：children[i+1] 的所有 key >= seps[i]，children[i] 的所有 key < seps[i]
+struct KeyIndex::Inner : KeyIndex::Node {
+    Inner() : Node(false) {}
+    std::vector<std::string> seps;
+    std::vector<std::unique_ptr<Node>> children;
+    std::vector<size_t> counts;  // 各子树的 key 数
+
+    uint32_t child_index(std::string_view key) const {
+        auto it = std::upper_bound(seps.begin(), seps.end(), key,
+            [](std::string_view k, const std::string& s) { return k < std::string_view(s); });
+        return static_cast<uint32_t>(it - seps.begin());
+    }
+};
+
+namespace {
+
+// 区分 left（较小）与 right 的最短前缀：取 right 的前 (公共前缀长度 + 1) 个字符
+std::string shortest_separator(std::string_view left, std::string_view right) {
+    size_t n = std::min(left.size(), right.size());
+    size_t cp = std::mismatch(left.begin(), left.begin() + n, right.begin()).first - left.begin();
+    return std::string(right.substr(0, cp + 1));
+}
+
+// n 个条目均分成 groups 组时第 g 组的大小（各组相差不超过 1，不会出现过小的末组）
+size_t group_size(size_t n, size_t groups, size_t g) {
+    return n / groups + (g < n % groups ? 1 : 0);
+}
+
+size_t string_heap_bytes(const std::string& s) {
+    // libstdc++ 短字符串（<= 15 字节）存在对象内
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+}
+
+KeyIndex::KeyIndex(uint32_t leaf_max, uint32_t inner_max)
+    : leaf_max_(std::max<uint32_t>(leaf_max, 4)), inner_max_(std::max<uint32_t>(inner_max, 4)),
+      root_(new Leaf()) {}
+
+KeyIndex::~KeyIndex() = default;
+KeyIndex::KeyIndex(KeyIndex&& other) noexcept = default;
+KeyIndex& KeyIndex::operator=(KeyIndex&& other) noexcept = default;
+
+size_t KeyIndex::count_of(const Node* n) {
+    if (n->leaf) return static_cast<const Leaf*>(n)->count();
+    const Inner* in = static_cast<const Inner*>(n);
+    return std::accumulate(in->counts.begin(), in->counts.end(), size_t(0));
+}
+
+const KeyIndex::Leaf* KeyIndex::find_leaf(std::string_view key, size_t* rank) const {
+    const Node* n = root_.get();
+    while (!n->leaf) {
+        const Inner* in = static_cast<const Inner*>(n);
+        uint32_t i = in->child_index(key);
+        if (rank) *rank += std::accumulate(in->counts.begin(), in->counts.begin() + i, size_t(0));
+        n = in->children[i].get();
+    }
+    return static_cast<const Leaf*>(n);
+}
+
+bool KeyIndex::find(std::string_view key, uint32_t& value) const {
+    const Leaf* leaf = find_leaf(key, nullptr);
+    bool exact;
+    uint32_t pos = leaf->lower_bound(key, exact);
+    if (!exact) return false;
+    value = leaf->values[pos];
+    return true;
+}
+
+bool KeyIndex::assign(std::string_view key, uint32_t value) {
+    Leaf* leaf = const_cast<Leaf*>(find_leaf(key, nullptr));
+    bool exact;
+    uint32_t pos = leaf->lower_bound(key, exact);
+    if (!exact) return false;
+    leaf->values[pos] = value;
+    return true;
+}
+
+size_t KeyIndex::rank(std::string_view key) const {
+    size_t r = 0;
+    const Leaf* leaf = find_leaf(key, &r);
+    bool exact;
+    return r + leaf->lower_bound(key, exact);
+}
+
+size_t KeyIndex::count_prefix(std::string_view prefix) const {
+    // 以 prefix 开头的 key 落在 [prefix, prefix 的后继) 内；后继为去掉末尾 0xff 后末字节加一
+    std::string end(prefix);
+    while (!end.empty() && static_cast<unsigned char>(end.back()) == 0xff) end.pop_back();
+    if (end.empty()) return size_ - rank(prefix);
+    end.back() = static_cast<char>(static_cast<unsigned char>(end.back()) + 1);
+    return rank(end) - rank(prefix);
+}
+
+bool KeyIndex::insert(std::string_view key, uint32_t value) {
+    std::unique_ptr<Node> split;
+    std::string sep;
+    if (!insert_rec(root_.get(), key, value, split, sep)) return false;
+    ++size_;
+    if (split) {
+        // 根分裂：树长高一层
+        std::unique_ptr<Inner> root(new Inner());
+        size_t right = count_of(split.get());
+        root->counts.push_back(size_ - right);
+        root->counts.push_back(right);
+        root->seps.push_back(std::move(sep));
+        root->children.push_back(std::move(root_));
+        root->children.push_back(std::move(split));
+        root_ = std::move(root);
+    }
+    return true;
+}
+
+bool KeyIndex::insert_rec(Node* n, std::string_view key, uint32_t value,
+                          std::unique_ptr<Node>& split, std::string& sep) {
+    if (n->leaf) {
+        Leaf* leaf = static_cast<Leaf*>(n);
+        bool exact;
+        uint32_t pos = leaf->lower_bound(key, exact);
+        if (exact) return false;
+        leaf->insert_at(pos, key, value);
+        if (leaf->count() > leaf_max_) {
+            std::vector<std::string> keys;
+            std::vector<uint32_t> vals;
+            leaf->decode(keys, vals);
+            size_t mid = keys.size() / 2;
+            std::unique_ptr<Leaf> right(new Leaf());
+            right->assign(keys, vals, mid, keys.size());
+            leaf->assign(keys, vals, 0, mid);
+            right->next = leaf->next;
+            leaf->next = right.get();
+            sep = shortest_separator(keys[mid - 1], keys[mid]);
+            split = std::move(right);
+        }
+        return true;
+    }
+
+    Inner* in = static_cast<Inner*>(n);
+    uint32_t i = in->child_index(key);
+    std::unique_ptr<Node> child_split;
+    std::string child_sep;
+    if (!insert_rec(in->children[i].get(), key, value, child_split, child_sep)) return false;
+    ++in->counts[i];
+    if (child_split) {
+        size_t right = count_of(child_split.get());
+        in->counts[i] -= right;
+        in->seps.insert(in->seps.begin() + i, std::move(child_sep));
+        in->children.insert(in->children.begin() + i + 1, std::move(child_split));
+        in->counts.insert(in->counts.begin() + i + 1, right);
+    }
+    if (in->children.size() > inner_max_) {
+        // 左留 [0, mid) 个子树，seps[mid-1] 上提给父节点
+        size_t mid = in->children.size() / 2;
+        std::unique_ptr<Inner> right(new Inner());
+        right->seps.assign(std::make_move_iterator(in->seps.begin() + mid),
+                           std::make_move_iterator(in->seps.end()));
+        right->children.assign(std::make_move_iterator(in->children.begin() + mid),
+                               std::make_move_iterator(in->children.end()));
+        right->counts.assign(in->counts.begin() + mid, in->counts.end());
+        sep = std::move(in->seps[mid - 1]);
+        in->seps.resize(mid - 1);
+        in->children.resize(mid);
+        in->counts.resize(mid);
+        split = std::move(right);
+    }
+    return true;
+}
+
+bool KeyIndex::build_sorted(const std::vector<std::string_view>& keys, const std::vector<uint32_t>& values) {
+    if (keys.size() != values.size()) return false;
+    for (size_t i = 1; i < keys.size(); ++i)
+        if (!(keys[i - 1] < keys[i])) return false;
+    if (keys.empty()) {
+        root_.reset(new Leaf());
+        size_ = 0;
+        return true;
+    }
+
+    // 自底向上逐层建：同层节点按容量均分，分隔 key 取相邻子树边界 key 的最短区分前缀
+    struct Built {
+        std::unique_ptr<Node> node;
+        size_t count;
+        std::string_view first, last;
+    };
+    std::vector<Built> level;
+    size_t groups = (keys.size() + leaf_max_ - 1) / leaf_max_;
+    level.reserve(groups);
+    Leaf* prev = nullptr;
+    for (size_t g = 0, from = 0; g < groups; ++g) {
+        size_t to = from + group_size(keys.size(), groups, g);
+        std::unique_ptr<Leaf> leaf(new Leaf());
+        leaf->assign(keys, values, from, to);
+        if (prev) prev->next = leaf.get();
+        prev = leaf.get();
+        level.push_back(Built{std::move(leaf), to - from, keys[from], keys[to - 1]});
+        from = to;
+    }
+    while (level.size() > 1) {
+        std::vector<Built> up;
+        groups = (level.size() + inner_max_ - 1) / inner_max_;
+        up.reserve(groups);
+        for (size_t g = 0, from = 0; g < groups; ++g) {
+            size_t to = from + group_size(level.size(), groups, g);
+            std::unique_ptr<Inner> in(new Inner());
+            size_t count = 0;
+            for (size_t i = from; i < to; ++i) {
+                if (i > from) in->seps.push_back(shortest_separator(level[i - 1].last, level[i].first));
+                in->counts.push_back(level[i].count);
+                in->children.push_back(std::move(level[i].node));
+                count += level[i].count;
+            }
+            up.push_back(Built{std::move(in), count, level[from].first, level[to - 1].last});
+            from = to;
+        }
+        level.swap(up);
+    }
+    root_ = std::move(level[0].node);
+    size_ = keys.size();
+    return true;
+}
+
+bool KeyIndex::underflow(const Node* n) const {
+    if (n->leaf) return static_cast<const Leaf*>(n)->count() < std::max<uint32_t>(leaf_max_ / 4, 1);
+    return static_cast<const Inner*>(n)->children.size() < std::max<uint32_t>(inner_max_ / 4, 2);
+}
+
+bool KeyIndex::erase(std::string_view key) {
+    if (!erase_rec(root_.get(), key)) return false;
+    --size_;
+    // 根只剩一个子树时树降低一层
+    while (!root_->leaf && static_cast<Inner*>(root_.get())->children.size() == 1) {
+        std::unique_ptr<Node> child = std::move(static_cast<Inner*>(root_.get())->children[0]);
+        root_ = std::move(child);
+    }
+    return true;
+}
+
+bool KeyIndex::erase_rec(Node* n, std::string_view key) {
+    if (n->leaf) {
+        Leaf* leaf = static_cast<Leaf*>(n);
+        bool exact;
+        uint32_t pos = leaf->lower_bound(key, exact);
+        if (!exact) return false;
+        leaf->erase_at(pos);
+        return true;
+    }
+    Inner* in = static_cast<Inner*>(n);
+    uint32_t i = in->child_index(key);
+    if (!erase_rec(in->children[i].get(), key)) return false;
+    --in->counts[i];
+    if (in->children.size() > 1 && underflow(in->children[i].get())) rebalance(in, i);
+    return true;
+}
+
+// children[i] 过小：与相邻兄弟合并；合并后超出容量则在两者间平分
+void KeyIndex::rebalance(Inner* parent, uint32_t i) {
+    uint32_t l = i + 1 < parent->children.size() ? i : i - 1;
+    Node* left = parent->children[l].get();
+    Node* right = parent->children[l + 1].get();
+    size_t total = parent->counts[l] + parent->counts[l + 1];
+
+    if (left->leaf) {
+        Leaf* a = static_cast<Leaf*>(left);
+        Leaf* b = static_cast<Leaf*>(right);
+        std::vector<std::string> keys;
+        std::vector<uint32_t> vals;
+        keys.reserve(total);
+        vals.reserve(total);
+        a->decode(keys, vals);
+        b->decode(keys, vals);
+        if (keys.size() <= leaf_max_) {
+            a->assign(keys, vals, 0, keys.size());
+            a->next = b->next;
+            parent->counts[l] = keys.size();
+            parent->seps.erase(parent->seps.begin() + l);
+            parent->children.erase(parent->children.begin() + l + 1);
+            parent->counts.erase(parent->counts.begin() + l + 1);
+            return;
+        }
+        size_t mid = keys.size() / 2;
+        a->assign(keys, vals, 0, mid);
+        b->assign(keys, vals, mid, keys.size());
+        parent->seps[l] = shortest_separator(keys[mid - 1], keys[mid]);
+        parent->counts[l] = mid;
+        parent->counts[l + 1] = keys.size() - mid;
+        return;
+    }
+
+    Inner* a = static_cast<Inner*>(left);
+    Inner* b = static_cast<Inner*>(right);
+    a->seps.push_back(std::move(parent->seps[l]));
+    a->seps.insert(a->seps.end(), std::make_move_iterator(b->seps.begin()), std::make_move_iterator(b->seps.end()));
+    a->children.insert(a->children.end(), std::make_move_iterator(b->children.begin()),
+                       std::make_move_iterator(b->children.end()));
+    a->counts.insert(a->counts.end(), b->counts.begin(), b->counts.end());
+    if (a->children.size() <= inner_max_) {
+        parent->counts[l] = total;
+        parent->seps.erase(parent->seps.begin() + l);
+        parent->children.erase(parent->children.begin() + l + 1);
+        parent->counts.erase(parent->counts.begin() + l + 1);
+        return;
+    }
+    size_t mid = a->children.size() / 2;
+    b->seps.assign(std::make_move_iterator(a->seps.begin() + mid), std::make_move_iterator(a->seps.end()));
+    b->children.assign(std::make_move_iterator(a->children.begin() + mid),
+                       std::make_move_iterator(a->children.end()));
+    b->counts.assign(a->counts.begin() + mid, a->counts.end());
+    parent->seps[l] = std::move(a->seps[mid - 1]);
+    a->seps.resize(mid - 1);
+    a->children.resize(mid);
+    a->counts.resize(mid);
+    parent->counts[l] = count_of(a);
+    parent->counts[l + 1] = total - parent->counts[l];
+}
+
+size_t KeyIndex::memory_usage() const {
+    size_t bytes = 0;
+    std::vector<const Node*> stack{root_.get()};
+    while (!stack.empty()) {
+        const Node* n = stack.back();
+        stack.pop_back();
+        if (n->leaf) {
+            const Leaf* leaf = static_cast<const Leaf*>(n);
+            bytes += sizeof(Leaf) + string_heap_bytes(leaf->prefix) + string_heap_bytes(leaf->suffixes) +
+                     leaf->ends.capacity() * sizeof(uint32_t) + leaf->values.capacity() * sizeof(uint32_t);
+            continue;
+        }
+        const Inner* in = static_cast<const Inner*>(n);
+        bytes += sizeof(Inner) + in->seps.capacity() * sizeof(std::string) +
+                 in->children.capacity() * sizeof(std::unique_ptr<Node>) + in->counts.capacity() * sizeof(size_t);
+        for (const std::string& s : in->seps) bytes += string_heap_bytes(s);
+        for (const auto& c : in->children) stack.push_back(c.get());
+    }
+    return bytes;
+}
+
+KeyIndex::Iterator::Iterator(const Leaf* leaf, uint32_t pos) : leaf_(leaf), pos_(pos) {
+    // 落在叶尾时移到下一个非空叶子
+    while (leaf_ && pos_ >= leaf_->count()) {
+        leaf_ = leaf_->next;
+        pos_ = 0;
+    }
+}
+
+std::string KeyIndex::Iterator::key() const {
+    std::string out;
+    key(out);
+    return out;
+}
+
+void KeyIndex::Iterator::key(std::string& out) const { leaf_->key(pos_, out); }
+
+uint32_t KeyIndex::Iterator::value() const { return leaf_->values[pos_]; }
+
+bool KeyIndex::Iterator::has_prefix(std::string_view prefix) const {
+    const std::string& lp = leaf_->prefix;
+    if (prefix.size() <= lp.size()) return std::string_view(lp).substr(0, prefix.size()) == prefix;
+    if (prefix.substr(0, lp.size()) != lp) return false;
+    std::string_view rest = prefix.substr(lp.size());
+    return leaf_->suffix(pos_).substr(0, rest.size()) == rest;
+}
+
+void KeyIndex::Iterator::next() { *this = Iterator(leaf_, pos_ + 1); }
+
+KeyIndex::Iterator KeyIndex::begin() const {
+    const Node* n = root_.get();
+    while (!n->leaf) n = static_cast<const Inner*>(n)->children[0].get();
+    return Iterator(static_cast<const Leaf*>(n), 0);
+}
+
+KeyIndex::Iterator KeyIndex::lower_bound(std::string_view key) const {
+    const Leaf* leaf = find_leaf(key, nullptr);
+    bool exact;
+    return Iterator(leaf, leaf->lower_bound(key, exact));
+}
+
+KeyIndex::Iterator KeyIndex::upper_bound(std::string_view key) const {
+    const Leaf* leaf = find_leaf(key, nullptr);
+    bool exact;
+    uint32_t pos = leaf->lower_bound(key, exact);
+    return Iterator(leaf, exact ? pos + 1 : pos);
+}
+
+}
@@ -1,18 +1,33 @@
-// 元数据存储层：单文件
-// 文件路径：<data_root>/s3_meta.dat
+// 元数据存储层：快照 + 变更日志
+// 文本快照：<data_root>/s3_meta.dat
 // 首行格式：N\t<bucket_next_id>\t<object_next_id>（无 user_next_id，用户仅存 user.dat）
 // 桶行 B、对象行 O 同上；用户仅从 user.dat 读取，s3_meta.dat 不存 U 行
 // 字段禁止字符：\t、\n；写回方式：先写临时文件 s3_meta.dat.tmp 再 rename 覆盖
+// 二进制快照：<data_root>/s3_meta.snap（默认格式），布局见下方 SnapHeader；写回方式同上
+// 变更日志：<data_root>/s3_meta.journal.<gen>，每次变更追加一行（格式见 元数据.md）：
+//   B（建桶，同快照桶行）、b\t<bucket_id>（删桶）、O（写对象，同快照对象行）、o\t<bucket_id>\t<key>（删对象）、
+//   U\t<id>\t<username>\t<access_key>\t<secret>\t<created_at>（建用户）
+// load = 读快照 + 按 gen 升序重放日志（末尾不完整的行忽略）；checkpoint 先换到新一代日志，再写新快照，
+// 成功后删除旧日志。重放是按 id / key 的幂等覆盖，旧日志在新快照上重放也得到同一状态
 
 #include "meta/meta.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <charconv>
 #include <cerrno>
 #include <cstring>
 #include <ctime>
 #include <openssl/rand.h>
 #include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <atomic>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace meta {
 
@@ -44,6 +59,216 @@ std::vector<std::string> split_line(const std::string& line) {
     return out;
 }
 
+void append_bucket_line(std::string& out, const Bucket& b) {
+    out += "B\t";
+    out += std::to_string(b.id);
+    out += '\t';
+    out += b.name;
+    out += '\t';
+    out += b.created_at;
+    out += '\t';
+    out += b.owner_id;
+    out += '\n';
+}
+
+void append_object_line(std::string& out, const Object& o) {
+    out += "O\t";
+    out += std::to_string(o.id);
+    out += '\t';
+    out += std::to_string(o.bucket_id);
+    out += '\t';
+    out += o.key;
+    out += '\t';
+    out += std::to_string(o.size);
+    out += '\t';
+    out += o.last_modified;
+    out += '\t';
+    out += o.etag;
+    out += '\t';
+    out += o.storage_path;
+    out += '\t';
+    out += o.acl;
+    out += '\n';
+}
+
+// 十进制整数字段：整个字段须是（可带负号的）数字且不溢出，否则返回 false（不抛异常，损坏的记录由调用方处理）
+bool parse_int64(const std::string& s, int64_t& out) {
+    const char* end = s.data() + s.size();
+    std::from_chars_result r = std::from_chars(s.data(), end, out);
+    return r.ec == std::errc() && r.ptr == end;
+}
+
+// 快照桶行 / 日志 B 记录：B\t<id>\t<name>\t<created_at>\t<owner_id>
+bool parse_bucket_line(const std::vector<std::string>& parts, Bucket& b) {
+    if (parts.size() < 5 || !parse_int64(parts[1], b.id)) return false;
+    b.name = parts[2];
+    b.created_at = parts[3];
+    b.owner_id = parts[4];
+    return true;
+}
+
+// 快照对象行 / 日志 O 记录：O\t<id>\t<bucket_id>\t<key>\t<size>\t<last_modified>\t<etag>\t<storage_path>\t<acl>
+bool parse_object_line(const std::vector<std::string>& parts, Object& o) {
+    if (parts.size() < 9 || !parse_int64(parts[1], o.id) || !parse_int64(parts[2], o.bucket_id) ||
+        !parse_int64(parts[4], o.size)) {
+        return false;
+    }
+    o.key = parts[3];
+    o.last_modified = parts[5];
+    o.etag = parts[6];
+    o.storage_path = parts[7];
+    o.acl = parts[8];
+    return true;
+}
+
+// 以 fd 写完整个 buf（处理短写与 EINTR）
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// rename 后对目录 fsync，使新目录项落盘
+void fsync_dir(const std::string& dir) {
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+const char kJournalPrefix[] = "s3_meta.journal.";
+
+// checkpoint 每次持锁读取的对象数
+const size_t kCheckpointBatch = 4096;
+
+// 二进制快照 s3_meta.snap（版本 1，本机字节序）：
+//   SnapHeader | ObjectRecord[object_count] | BucketRecord[bucket_count] | 字符串堆
+// 对象记录按桶连续存放、桶内按 key 严格升序，BucketRecord 给出各桶的 [first_object, first_object + object_count)；
+// 字符串以（堆内偏移, 长度）引用，不带结尾 \0，acl、owner_id 等重复值只存一份。
+// 加载时 mmap 整个文件：对象按下标区间并行构造，各桶的有序 key 索引直接由已排序的记录自底向上建成
+const char kSnapMagic[8] = {'S', '3', 'M', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t kSnapVersion = 1;
+const uint32_t kSnapByteOrder = 0x01020304;
+
+struct SnapHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;     // 写入方的 kSnapByteOrder，字节序不同的机器拒绝加载
+    int64_t next_bucket_id;
+    int64_t next_object_id;
+    uint64_t object_count;
+    uint64_t bucket_count;
+    uint64_t objects_off;    // 各段在文件内的偏移（8 字节对齐）
+    uint64_t buckets_off;
+    uint64_t heap_off;
+    uint64_t heap_size;
+};
+
+enum { kObjKey, kObjLastModified, kObjEtag, kObjStoragePath, kObjAcl, kObjStrings };
+struct ObjectRecord {
+    int64_t id;
+    int64_t bucket_id;
+    int64_t size;
+    uint64_t off[kObjStrings];  // 各字符串在堆内的偏移，顺序同上面的枚举
+    uint32_t len[kObjStrings];
+    uint32_t reserved;
+};
+
+enum { kBucketName, kBucketCreatedAt, kBucketOwner, kBucketStrings };
+struct BucketRecord {
+    int64_t id;
+    uint64_t first_object;
+    uint64_t object_count;
+    uint64_t off[kBucketStrings];
+    uint32_t len[kBucketStrings];
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SnapHeader) == 80 && sizeof(ObjectRecord) == 88 && sizeof(BucketRecord) == 64,
+              "snapshot record layout is part of the on-disk format");
+
+// 写快照时的字符串堆：先追加到临时文件，对象与桶记录写完后再整体拷到快照末尾
+struct HeapWriter {
+    explicit HeapWriter(int f) : fd(f) {}
+    int fd;
+    std::string buf;
+    uint64_t size{0};
+    bool ok{true};
+    std::unordered_map<std::string, uint64_t> interned;
+
+    void put(const std::string& s, uint64_t& off, uint32_t& len) {
+        off = size;
+        len = static_cast<uint32_t>(s.size());
+        buf += s;
+        size += s.size();
+        if (buf.size() >= (1u << 20)) flush();
+    }
+    // 取值很少的字段（acl、owner_id）：相同的串只存一份
+    void put_interned(const std::string& s, uint64_t& off, uint32_t& len) {
+        auto it = interned.find(s);
+        if (it != interned.end()) {
+            off = it->second;
+            len = static_cast<uint32_t>(s.size());
+            return;
+        }
+        put(s, off, len);
+        interned.emplace(s, off);
+    }
+    bool flush() {
+        ok = ok && write_all(fd, buf.data(), buf.size());
+        buf.clear();
+        return ok;
+    }
+};
+
+// 把 src 从头起的 len 字节追加到 dst 的当前位置：copy_file_range 在内核中复制，不支持时退回读写
+bool copy_fd(int src, int dst, uint64_t len) {
+    loff_t in = 0;
+    while (len > 0) {
+        ssize_t n = ::copy_file_range(src, &in, dst, nullptr, len, 0);
+        if (n > 0) {
+            len -= static_cast<uint64_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || (errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP)) return false;
+        std::vector<char> buf(1u << 20);
+        while (len > 0) {
+            ssize_t r = ::pread(src, buf.data(), std::min<uint64_t>(len, buf.size()), in);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0 || !write_all(dst, buf.data(), static_cast<size_t>(r))) return false;
+            in += r;
+            len -= static_cast<uint64_t>(r);
+        }
+    }
+    return true;
+}
+
+// 只读映射整个文件，析构时解除
+struct FileMapping {
+    const char* data{nullptr};
+    size_t size{0};
+    ~FileMapping() {
+        if (data) ::munmap(const_cast<char*>(data), size);
+    }
+};
+
+// 在 threads 个线程（含调用线程）上各执行一次 fn(worker)，全部结束后返回
+template <class F>
+void run_workers(unsigned threads, F fn) {
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < threads; ++w) pool.emplace_back(fn, w);
+    fn(0u);
+    for (std::thread& t : pool) t.join();
+}
+
 } 
 
 std::string MetaStore::meta_file_path() const {
@@ -53,13 +278,39 @@ std::string MetaStore::meta_file_path() const {
     return p;
 }
 
-std::string MetaStore::meta_file_path_tmp() const {
+std::string MetaStore::snapshot_path() const {
     std::string p = data_root_;
     if (!p.empty() && p.back() != '/') p += '/';
-    p += "s3_meta.dat.tmp";
+    p += "s3_meta.snap";
     return p;
 }
 
+std::string MetaStore::journal_path(uint64_t gen) const {
+    std::string p = data_root_;
+    if (!p.empty() && p.back() != '/') p += '/';
+    p += kJournalPrefix;
+    p += std::to_string(gen);
+    return p;
+}
+
+// data_root 下已有的日志代号，升序
+std::vector<uint64_t> MetaStore::journal_gens() const {
+    std::vector<uint64_t> gens;
+    DIR* d = opendir(data_root_.empty() ? "." : data_root_.c_str());
+    if (!d) return gens;
+    const size_t plen = sizeof(kJournalPrefix) - 1;
+    while (struct dirent* e = readdir(d)) {
+        const char* name = e->d_name;
+        if (std::strncmp(name, kJournalPrefix, plen) != 0) continue;
+        const char* digits = name + plen;
+        if (!*digits || std::strspn(digits, "0123456789") != std::strlen(digits)) continue;
+        gens.push_back(std::strtoull(digits, nullptr, 10));
+    }
+    closedir(d);
+    std::sort(gens.begin(), gens.end());
+    return gens;
+}
+
 std::string MetaStore::user_dat_path() const {
     std::string p = data_root_;
     if (!p.empty() && p.back() != '/') p += '/';
@@ -67,27 +318,91 @@ std::string MetaStore::user_dat_path() const {
     return p;
 }
 
+MetaStore::~MetaStore() {
+    {
+        std::lock_guard<std::mutex> lock(journal_mutex_);
+        checkpointer_stop_ = true;
+    }
+    checkpoint_cv_.notify_all();
+    if (checkpointer_.joinable()) checkpointer_.join();
+}
+
+MetaStore::JournalFile::~JournalFile() {
+    ::close(fd);
+}
+
 bool MetaStore::load(const std::string& data_root) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> journal_lock(journal_mutex_);
+    std::lock_guard<RwLock> lock(mutex_);
+    std::unique_lock<RwLock> stripe_locks[kStripes];
+    for (size_t i = 0; i < kStripes; ++i) {
+        stripe_locks[i] = std::unique_lock<RwLock>(stripes_[i].mutex);
+        stripes_[i].objects.clear();
+        stripes_[i].keys_by_bucket.clear();
+        stripes_[i].dir_by_bucket.clear();
+    }
     data_root_ = data_root;
+    journal_file_.reset();
+    sealed_journals_.clear();
+    {
+        std::lock_guard<std::mutex> buf_lock(journal_buf_mutex_);
+        journal_buf_.clear();
+    }
+    journal_pending_.clear();
+    journal_bytes_ = 0;
     next_bucket_id_ = 1;
     next_object_id_ = 1;
     next_user_id_ = 1;
     buckets_.clear();
-    objects_.clear();
     users_.clear();
+    bucket_by_owner_name_.clear();
+    bucket_by_id_.clear();
+    user_by_access_key_.clear();
+    user_by_username_.clear();
     secret_by_access_key_.clear();
 
-    std::string path = meta_file_path();
-    std::ifstream f(path);
-    if (!f.is_open()) {
-        if (errno == ENOENT) {
-            std::cout << "meta: no " << path << ", starting with empty buckets/objects" << std::endl;
-            return true; // 新库
-        }
-        return false;
+    // 两种快照都在（切换格式的 checkpoint 中途崩溃）时任选其一都对：被新快照折叠的日志要等旧格式文件删除后才删
+    auto t0 = std::chrono::steady_clock::now();
+    std::string path = snapshot_path();
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0) {
+        if (!load_binary_snapshot(path)) return false;
+        disk_format_ = SnapshotFormat::binary;
+    } else if (path = meta_file_path(); ::stat(path.c_str(), &st) == 0) {
+        if (!load_text_snapshot(path)) return false;
+        disk_format_ = SnapshotFormat::text;
+    } else {
+        if (errno != ENOENT) return false;
+        std::cout << "meta: no snapshot in " << data_root_ << ", starting with empty buckets/objects" << std::endl;  // 新库（日志仍要重放）
+        disk_format_ = snapshot_format_;
     }
+    auto snapshot_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
 
+    // 重放快照之后的日志；新变更写到下一代
+    journal_gen_ = 1;
+    for (uint64_t gen : journal_gens()) {
+        if (!replay_journal(journal_path(gen))) return false;
+        journal_gen_ = gen + 1;
+    }
+    size_t index_bytes = 0, table_bytes = 0, objects = 0;
+    for (const Stripe& s : stripes_) {
+        for (const auto& kv : s.keys_by_bucket) index_bytes += kv.second.memory_usage();
+        table_bytes += s.objects.memory_usage();
+        objects += s.objects.size();
+    }
+    std::cout << "meta: loaded " << path << " buckets=" << buckets_.size() << " objects=" << objects
+              << " key_index_bytes=" << index_bytes;
+    if (objects > 0) std::cout << " (" << index_bytes / objects << " B/key)";
+    std::cout << " object_table_bytes=" << table_bytes;
+    if (objects > 0) std::cout << " (" << table_bytes / objects << " B/object)";
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << " journal_bytes=" << journal_bytes_ << " snapshot_ms=" << snapshot_ms << " total_ms=" << ms << std::endl;
+    return true;
+}
+
+bool MetaStore::load_text_snapshot(const std::string& path) {
+    std::ifstream f(path);
+    if (!f.is_open()) return false;
     std::string line;
     bool first = true;
     while (std::getline(f, line)) {
@@ -98,41 +413,246 @@ bool MetaStore::load(const std::string& data_root) {
         if (first) {
             first = false;
             // 首行 N\t<bucket_next_id>\t<object_next_id>（user 从 user.dat 读，不在此）
+            // 解析不了时沿用默认值，各行的 id 仍会把它们推到最大 id 之后
+            int64_t next_bucket, next_object;
             if (parts[0] == "N" && parts.size() >= 3) {
-                next_bucket_id_ = static_cast<int64_t>(std::stoll(parts[1]));
-                next_object_id_ = static_cast<int64_t>(std::stoll(parts[2]));
+                if (parse_int64(parts[1], next_bucket) && parse_int64(parts[2], next_object)) {
+                    next_bucket_id_ = next_bucket;
+                    next_object_id_ = next_object;
+                } else {
+                    std::cerr << "meta: bad header in " << path << ", ignored" << std::endl;
+                }
             }
             continue;
         }
 
-        if (parts[0] == "B" && parts.size() >= 5) {
-            Bucket b;
-            b.id = static_cast<int64_t>(std::stoll(parts[1]));
-            b.name = parts[2];
-            b.created_at = parts[3];
-            b.owner_id = parts[4];
-            buckets_.push_back(std::move(b));
-        } else if (parts[0] == "O" && parts.size() >= 9) {
-            Object o;
-            o.id = static_cast<int64_t>(std::stoll(parts[1]));
-            o.bucket_id = static_cast<int64_t>(std::stoll(parts[2]));
-            o.key = parts[3];
-            o.size = static_cast<int64_t>(std::stoll(parts[4]));
-            o.last_modified = parts[5];
-            o.etag = parts[6];
-            o.storage_path = parts[7];
-            o.acl = parts[8];
-            objects_.push_back(std::move(o));
+        // 同一 id 或 (owner_id, name) 的桶、同一 bucket_id+key 的对象出现多次时后一行覆盖前一行
+        Bucket b;
+        Object o;
+        if (parts[0] == "B") {
+            if (parse_bucket_line(parts, b)) insert_bucket(std::move(b));
+            else std::cerr << "meta: bad bucket line in " << path << ", skipped" << std::endl;
+        } else if (parts[0] == "O") {
+            if (parse_object_line(parts, o)) upsert_object(stripe_of(o.bucket_id), o);
+            else std::cerr << "meta: bad object line in " << path << ", skipped" << std::endl;
         }
         // 用户仅从 user.dat 读取，在 load_user_dat() 中读（且应在 ensure_root_user 之后调用）
     }
-    std::cout << "meta: loaded " << path << " buckets=" << buckets_.size() << " objects=" << objects_.size() << std::endl;
+    return true;
+}
+
+bool MetaStore::load_binary_snapshot(const std::string& path) {
+    auto fail = [&path](const char* why) {
+        std::cerr << "meta: bad snapshot " << path << ": " << why << std::endl;
+        return false;
+    };
+    FileMapping map;
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return fail(strerror(errno));
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SnapHeader))) {
+            ::close(fd);
+            return fail("truncated header");
+        }
+        void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return fail(strerror(errno));
+        map.data = static_cast<const char*>(p);
+        map.size = static_cast<size_t>(st.st_size);
+    }
+    const SnapHeader* h = reinterpret_cast<const SnapHeader*>(map.data);
+    if (std::memcmp(h->magic, kSnapMagic, sizeof(kSnapMagic)) != 0) return fail("bad magic");
+    if (h->version != kSnapVersion || h->byte_order != kSnapByteOrder) return fail("unsupported version or byte order");
+    auto section_ok = [&map](uint64_t off, uint64_t count, size_t record) {
+        return off % 8 == 0 && off <= map.size && count <= (map.size - off) / record;
+    };
+    if (!section_ok(h->objects_off, h->object_count, sizeof(ObjectRecord)) ||
+        !section_ok(h->buckets_off, h->bucket_count, sizeof(BucketRecord)) ||
+        h->heap_off > map.size || h->heap_size > map.size - h->heap_off || h->object_count > UINT32_MAX)
+        return fail("section out of range");
+    const ObjectRecord* orecs = reinterpret_cast<const ObjectRecord*>(map.data + h->objects_off);
+    const BucketRecord* brecs = reinterpret_cast<const BucketRecord*>(map.data + h->buckets_off);
+    const char* heap = map.data + h->heap_off;
+    const uint64_t heap_size = h->heap_size;
+    auto str_ok = [heap_size](uint64_t off, uint32_t len) { return off <= heap_size && len <= heap_size - off; };
+    auto str = [heap](uint64_t off, uint32_t len) { return std::string_view(heap + off, len); };
+
+    // 1. 桶（数量少，串行）：各桶的对象区间须首尾相接、恰好覆盖全部对象。
+    //    每个桶的对象放进它所在条带的对象表，在表内依次排在该条带之前各桶之后（local_first）
+    const size_t n = static_cast<size_t>(h->object_count);
+    const size_t m = static_cast<size_t>(h->bucket_count);
+    uint64_t next_first = 0;
+    std::vector<Stripe*> stripe(m);
+    std::vector<size_t> local_first(m);
+    size_t stripe_objects[kStripes] = {};
+    for (size_t j = 0; j < m; ++j) {
+        const BucketRecord& r = brecs[j];
+        for (int k = 0; k < kBucketStrings; ++k)
+            if (!str_ok(r.off[k], r.len[k])) return fail("string out of range");
+        if (r.first_object != next_first || r.object_count > n - next_first) return fail("bad bucket object range");
+        next_first += r.object_count;
+        Bucket b;
+        b.id = r.id;
+        b.name = str(r.off[kBucketName], r.len[kBucketName]);
+        b.created_at = str(r.off[kBucketCreatedAt], r.len[kBucketCreatedAt]);
+        b.owner_id = str(r.off[kBucketOwner], r.len[kBucketOwner]);
+        insert_bucket(std::move(b));
+        stripe[j] = &stripe_of(r.id);
+        stripe[j]->objects.intern_bucket(r.id);
+        size_t& count = stripe_objects[static_cast<uint64_t>(r.id) % kStripes];
+        local_first[j] = count;
+        count += static_cast<size_t>(r.object_count);
+    }
+    if (next_first != n || buckets_.size() != m) return fail("duplicate bucket or unowned objects");
+    std::vector<std::string> dirs(m);
+    for (size_t j = 0; j < m; ++j) dirs[j] = object_dir(brecs[j].id);
+    for (size_t i = 0; i < kStripes; ++i) stripes_[i].objects.resize(stripe_objects[i]);
+
+    // 2. 对象按下标区间并行编码成紧凑记录：先各自算出 arena 中所需字节数，串行分配后再并行写入 key 等字符串
+    auto fields = [&](size_t i) {
+        const ObjectRecord& r = orecs[i];
+        ObjectTable::Fields f;
+        f.id = r.id;
+        f.bucket_id = r.bucket_id;
+        f.size = r.size;
+        f.key = str(r.off[kObjKey], r.len[kObjKey]);
+        f.last_modified = str(r.off[kObjLastModified], r.len[kObjLastModified]);
+        f.etag = str(r.off[kObjEtag], r.len[kObjEtag]);
+        f.storage_path = str(r.off[kObjStoragePath], r.len[kObjStoragePath]);
+        f.acl = str(r.off[kObjAcl], r.len[kObjAcl]);
+        return f;
+    };
+    // 对第 w 个线程的下标区间逐个调用 fn(i, j, local)：j 为对象所在的桶，local 为它在条带对象表中的下标；fn 返回 false 时停止
+    auto for_each_in_range = [&](unsigned w, unsigned threads, auto fn) {
+        size_t from = n * w / threads, to = n * (w + 1) / threads;
+        if (from == to) return;
+        // 区间起点所在的桶：first_object 递增，二分查找
+        size_t j = static_cast<size_t>(std::upper_bound(brecs, brecs + m, from, [](uint64_t i, const BucketRecord& br) {
+                                           return i < br.first_object;
+                                       }) - brecs) - 1;
+        for (size_t i = from; i < to; ++i) {
+            while (i >= brecs[j].first_object + brecs[j].object_count) ++j;
+            if (!fn(i, j, static_cast<uint32_t>(local_first[j] + (i - brecs[j].first_object)))) return;
+        }
+    };
+    const size_t kPerThread = 1u << 16;
+    unsigned threads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(),
+                                                       static_cast<unsigned>((n + kPerThread - 1) / kPerThread)));
+    std::atomic<bool> bad{false};
+    // 各线程顺带记下所见的最大对象 id：checkpoint 先取 next_object_id 再拷对象，快照里可能有不小于头部值的 id
+    std::vector<int64_t> max_object_id(threads, 0);
+    run_workers(threads, [&](unsigned w) {
+        for_each_in_range(w, threads, [&](size_t i, size_t j, uint32_t local) {
+            const ObjectRecord& r = orecs[i];
+            bool ok = r.bucket_id == brecs[j].id;
+            for (int k = 0; ok && k < kObjStrings; ++k) ok = str_ok(r.off[k], r.len[k]);
+            if (!ok || !stripe[j]->objects.pack(local, fields(i), dirs[j])) {
+                bad.store(true);
+                return false;
+            }
+            if (r.id > max_object_id[w]) max_object_id[w] = r.id;
+            return true;
+        });
+    });
+    if (bad.load()) return fail("string out of range or object outside its bucket range");
+    for (Stripe& st : stripes_) st.objects.place_blobs();
+    run_workers(threads, [&](unsigned w) {
+        for_each_in_range(w, threads, [&](size_t i, size_t j, uint32_t local) {
+            stripe[j]->objects.write_blob(local, fields(i));
+            return true;
+        });
+    });
+
+    // 3. 各条带的 (bucket_id, key) 哈希索引与各桶的有序 key 索引（key 取自映射，直接由有序记录建成）作为任务并行建
+    std::vector<KeyIndex> indexes(m);
+    std::atomic<size_t> next_task{0};
+    auto build = [&](unsigned) {
+        std::vector<std::string_view> keys;
+        std::vector<uint32_t> values;
+        for (size_t t; (t = next_task.fetch_add(1)) < kStripes + m;) {
+            if (t < kStripes) {
+                stripes_[t].objects.build_index();
+                continue;
+            }
+            size_t j = t - kStripes;
+            const BucketRecord& br = brecs[j];
+            keys.clear();
+            values.clear();
+            for (uint64_t i = br.first_object; i < br.first_object + br.object_count; ++i) {
+                keys.push_back(str(orecs[i].off[kObjKey], orecs[i].len[kObjKey]));
+                values.push_back(static_cast<uint32_t>(local_first[j] + (i - br.first_object)));
+            }
+            if (!indexes[j].build_sorted(keys, values)) {
+                bad.store(true);
+                return;
+            }
+        }
+    };
+    run_workers(std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), static_cast<unsigned>(kStripes + m))),
+                build);
+    if (bad.load()) return fail("keys not in ascending order within a bucket");
+    for (size_t j = 0; j < m; ++j) {
+        if (!indexes[j].empty()) stripe[j]->keys_by_bucket.emplace(brecs[j].id, std::move(indexes[j]));
+    }
+    // 与文本快照一致：头部值只作下限，insert_bucket 已把 next_bucket_id_ 推到最大桶 id 之后
+    next_bucket_id_ = std::max(next_bucket_id_, h->next_bucket_id);
+    int64_t next_object = h->next_object_id;
+    for (int64_t id : max_object_id) next_object = std::max(next_object, id + 1);
+    next_object_id_ = next_object;
+    return true;
+}
+
+bool MetaStore::replay_journal(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) return false;
+    std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    journal_bytes_ += data.size();
+    size_t pos = 0, records = 0;
+    while (true) {
+        size_t nl = data.find('\n', pos);
+        if (nl == std::string::npos) break;  // 末尾不完整的行（写到一半时崩溃）忽略
+        std::vector<std::string> parts = split_line(data.substr(pos, nl - pos));
+        size_t start = pos;
+        pos = nl + 1;
+        if (parts.empty()) continue;
+        const std::string& t = parts[0];
+        Bucket b;
+        Object o;
+        int64_t id;
+        if (t == "B" && parse_bucket_line(parts, b)) {
+            insert_bucket(std::move(b));
+        } else if (t == "b" && parts.size() >= 2 && parse_int64(parts[1], id)) {
+            remove_bucket(id);
+        } else if (t == "O" && parse_object_line(parts, o)) {
+            upsert_object(stripe_of(o.bucket_id), o);
+        } else if (t == "o" && parts.size() >= 3 && parse_int64(parts[1], id)) {
+            erase_object(stripe_of(id), id, parts[2]);
+        } else if (t == "U" && parts.size() >= 6 && parse_int64(parts[1], id)) {
+            if (user_by_access_key_.count(parts[3]) || user_by_username_.count(parts[2])) continue;
+            User u;
+            u.id = id;
+            u.username = parts[2];
+            u.access_key = parts[3];
+            u.created_at = parts[5];
+            secret_by_access_key_[u.access_key] = parts[4];
+            if (u.id >= next_user_id_) next_user_id_ = u.id + 1;
+            add_user(std::move(u));
+        } else {
+            // 损坏的记录：视为这一代日志有效内容的结尾（之后的记录可能依赖它），新变更写在下一代，不受影响
+            std::cerr << "meta: bad record in " << path << " at offset " << start << ", ignoring the remaining "
+                      << data.size() - start << " bytes of this journal" << std::endl;
+            break;
+        }
+        ++records;
+    }
+    std::cout << "meta: replayed " << path << " records=" << records << std::endl;
     return true;
 }
 
 bool MetaStore::load_user_dat() {
     // 在 ensure_root_user() 之后调用：从 user.dat 读取其余用户与 next_user_id，不覆盖已存在的 root
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<RwLock> lock(mutex_);
     std::string udat = user_dat_path();
     std::ifstream fu(udat);
     if (!fu.is_open()) return true;  // 文件不存在视为仅有内存中的 root
@@ -144,21 +664,25 @@ bool MetaStore::load_user_dat() {
         std::vector<std::string> up = split_line(uline);
         if (up.empty()) continue;
         if (u_first && up[0] == "N" && up.size() >= 2) {
-            int64_t file_next = static_cast<int64_t>(std::stoll(up[1]));
-            if (file_next > next_user_id_) next_user_id_ = file_next;
+            int64_t file_next;
+            if (parse_int64(up[1], file_next) && file_next > next_user_id_) next_user_id_ = file_next;
             u_first = false;
             continue;
         }
         u_first = false;
         if (up[0] == "U" && up.size() >= 6) {
             if (up[2] == "root") continue;  // root 已由 ensure_root_user 加入，不重复
+            if (user_by_access_key_.count(up[3])) continue;  // 已由日志重放加入
             User u;
-            u.id = static_cast<int64_t>(std::stoll(up[1]));
+            if (!parse_int64(up[1], u.id)) {
+                std::cerr << "meta: bad user line in " << udat << ", skipped" << std::endl;
+                continue;
+            }
             u.username = up[2];
             u.access_key = up[3];
             u.created_at = up[5];
             secret_by_access_key_[u.access_key] = up[4];
-            users_.push_back(std::move(u));
+            add_user(std::move(u));
         } else if (up.size() >= 2 && up[0] != "N") {
             // 兼容旧格式：每行 access_key\tsecret_key
             if (secret_by_access_key_.count(up[0])) continue;
@@ -168,7 +692,7 @@ bool MetaStore::load_user_dat() {
             u.username = up[0];
             u.access_key = up[0];
             u.created_at = "";
-            users_.push_back(std::move(u));
+            add_user(std::move(u));
         }
     }
     if (uid_placeholder > 1 && uid_placeholder > next_user_id_)
@@ -176,62 +700,311 @@ bool MetaStore::load_user_dat() {
     return true;
 }
 
-bool MetaStore::save() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    last_save_error_.clear();
-    std::string path = meta_file_path();
-    std::string path_tmp = meta_file_path_tmp();
-    std::ofstream f(path_tmp);
-    if (!f.is_open()) {
-        last_save_error_ = path_tmp + ": " + strerror(errno);
+bool MetaStore::flush_journal() {
+    {
+        // 只在换出缓冲时持缓冲锁，写文件期间查询与变更照常进行
+        std::lock_guard<std::mutex> lock(journal_buf_mutex_);
+        if (journal_pending_.empty()) journal_pending_.swap(journal_buf_);
+        else journal_pending_ += journal_buf_;
+        journal_buf_.clear();
+    }
+    if (journal_pending_.empty()) return true;
+    if (!journal_file_) {
+        // 每一代日志在第一次有记录要写时才创建
+        std::string path = journal_path(journal_gen_);
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            last_save_error_ = path + ": " + strerror(errno);
+            return false;
+        }
+        journal_file_ = std::make_shared<JournalFile>(fd);
+        journal_file_bytes_ = 0;
+        if (journal_sync_) fsync_dir(data_root_);  // 新文件的目录项也要落盘（每代一次）
+    }
+    if (!write_all(journal_file_->fd, journal_pending_.data(), journal_pending_.size())) {
+        last_save_error_ = journal_path(journal_gen_) + ": " + strerror(errno);
+        // 截掉写了一半的记录，未写的记录留在 journal_pending_ 等下次 save
+        if (::ftruncate(journal_file_->fd, static_cast<off_t>(journal_file_bytes_)) != 0) {
+            journal_file_.reset();
+            ++journal_gen_;  // 截断失败时换新一代，不在残缺记录后追加
+        }
         return false;
     }
+    journal_file_bytes_ += journal_pending_.size();
+    journal_bytes_ += journal_pending_.size();
+    journal_pending_.clear();
+    return true;
+}
 
-    // 首行仅桶与对象 next_id，用户存 user.dat
-    f << "N\t" << next_bucket_id_ << "\t" << next_object_id_ << "\n";
-    for (const Bucket& b : buckets_)
-        f << "B\t" << b.id << "\t" << b.name << "\t" << b.created_at << "\t" << b.owner_id << "\n";
-    for (const Object& o : objects_)
-        f << "O\t" << o.id << "\t" << o.bucket_id << "\t" << o.key << "\t" << o.size << "\t"
-          << o.last_modified << "\t" << o.etag << "\t" << o.storage_path << "\t" << o.acl << "\n";
-
-    f.close();
-    if (!f.good()) {
-        last_save_error_ = "write failed: " + path_tmp;
-        return false;
+bool MetaStore::save() {
+    std::vector<std::shared_ptr<JournalFile>> files;
+    {
+        std::lock_guard<std::mutex> lock(journal_mutex_);
+        last_save_error_.clear();
+        if (!flush_journal()) return false;
+        if (checkpoint_bytes_ > 0 && journal_bytes_ >= checkpoint_bytes_) checkpoint_cv_.notify_one();
+        if (!journal_sync_) return true;
+        // 本次的记录可能已被别的 save() 写入、随后被 checkpoint 封存，因此已封存未折叠的各代也要同步
+        files = sealed_journals_;
+        if (journal_file_) files.push_back(journal_file_);
     }
-    if (rename(path_tmp.c_str(), path.c_str()) != 0) {
-        last_save_error_ = std::string("rename to ") + path + ": " + strerror(errno);
+    // 锁外同步，其他线程可以继续写日志并加入同一批组提交
+    std::vector<int> fds;
+    for (const auto& f : files) fds.push_back(f->fd);
+    if (journal_sync_(fds)) return true;
+    int err = errno;
+    std::lock_guard<std::mutex> lock(journal_mutex_);
+    last_save_error_ = std::string("journal sync: ") + strerror(err);
+    return false;
+}
+
+bool MetaStore::copy_object_batch(int64_t bucket_id, bool started, const std::string& cursor, size_t max,
+                                  std::vector<Object>& out) const {
+    out.clear();
+    const Stripe& s = stripe_of(bucket_id);
+    std::shared_lock<RwLock> lock(s.mutex);
+    auto b = s.keys_by_bucket.find(bucket_id);
+    if (b == s.keys_by_bucket.end()) return true;  // 桶已清空
+    KeyIndex::Iterator it = started ? b->second.upper_bound(cursor) : b->second.begin();
+    std::string dir = stripe_dir(s, bucket_id);
+    for (; out.size() < max && it.valid(); it.next()) {
+        out.emplace_back();
+        s.objects.get(it.value(), dir, out.back());
+    }
+    return !it.valid();
+}
+
+bool MetaStore::write_text_snapshot(int fd, int64_t next_bucket_id, int64_t next_object_id,
+                                    const std::vector<Bucket>& buckets) const {
+    std::string buf = "N\t" + std::to_string(next_bucket_id) + "\t" + std::to_string(next_object_id) + "\n";
+    for (const Bucket& b : buckets) append_bucket_line(buf, b);
+    if (!write_all(fd, buf.data(), buf.size())) return false;
+    std::vector<Object> batch;
+    for (const Bucket& b : buckets) {
+        bool done = false;
+        std::string cursor;
+        for (bool started = false; !done; started = true) {
+            done = copy_object_batch(b.id, started, cursor, kCheckpointBatch, batch);
+            if (batch.empty()) break;
+            buf.clear();
+            for (const Object& o : batch) append_object_line(buf, o);
+            cursor = batch.back().key;
+            if (!write_all(fd, buf.data(), buf.size())) return false;
+        }
+    }
+    return true;
+}
+
+bool MetaStore::write_binary_snapshot(int fd, int64_t next_bucket_id, int64_t next_object_id,
+                                      const std::vector<Bucket>& buckets) const {
+    // 字符串堆先写到一个已 unlink 的临时文件，记录写完后再拷到快照末尾，整个过程内存只占一批对象
+    std::string heap_path = snapshot_path() + ".heap";
+    int heap_fd = ::open(heap_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (heap_fd < 0) return false;
+    ::unlink(heap_path.c_str());
+    HeapWriter heap(heap_fd);
+
+    SnapHeader h;
+    std::memset(&h, 0, sizeof(h));
+    bool ok = write_all(fd, reinterpret_cast<const char*>(&h), sizeof(h));
+    std::vector<BucketRecord> brecs;
+    brecs.reserve(buckets.size());
+    std::vector<ObjectRecord> orecs;
+    std::vector<Object> batch;
+    uint64_t object_count = 0;
+    for (size_t i = 0; ok && i < buckets.size(); ++i) {
+        const Bucket& b = buckets[i];
+        BucketRecord br;
+        std::memset(&br, 0, sizeof(br));
+        br.id = b.id;
+        br.first_object = object_count;
+        heap.put(b.name, br.off[kBucketName], br.len[kBucketName]);
+        heap.put(b.created_at, br.off[kBucketCreatedAt], br.len[kBucketCreatedAt]);
+        heap.put_interned(b.owner_id, br.off[kBucketOwner], br.len[kBucketOwner]);
+        bool done = false;
+        std::string cursor;
+        for (bool started = false; ok && !done; started = true) {
+            done = copy_object_batch(b.id, started, cursor, kCheckpointBatch, batch);
+            if (batch.empty()) break;
+            orecs.assign(batch.size(), ObjectRecord{});
+            for (size_t k = 0; k < batch.size(); ++k) {
+                const Object& o = batch[k];
+                ObjectRecord& r = orecs[k];
+                r.id = o.id;
+                r.bucket_id = o.bucket_id;
+                r.size = o.size;
+                heap.put(o.key, r.off[kObjKey], r.len[kObjKey]);
+                heap.put(o.last_modified, r.off[kObjLastModified], r.len[kObjLastModified]);
+                heap.put(o.etag, r.off[kObjEtag], r.len[kObjEtag]);
+                heap.put(o.storage_path, r.off[kObjStoragePath], r.len[kObjStoragePath]);
+                heap.put_interned(o.acl, r.off[kObjAcl], r.len[kObjAcl]);
+            }
+            cursor = batch.back().key;
+            object_count += batch.size();
+            ok = heap.ok && write_all(fd, reinterpret_cast<const char*>(orecs.data()), orecs.size() * sizeof(ObjectRecord));
+        }
+        br.object_count = object_count - br.first_object;
+        brecs.push_back(br);
+    }
+    if (ok) ok = write_all(fd, reinterpret_cast<const char*>(brecs.data()), brecs.size() * sizeof(BucketRecord));
+    if (ok) ok = heap.flush() && copy_fd(heap_fd, fd, heap.size);
+    int err = errno;
+    ::close(heap_fd);
+    if (!ok) {
+        errno = err;
         return false;
     }
-    // 用户完整信息（含 secret）仅写 user.dat：首行 N\t<next_user_id>，后续 U\t<id>\t<username>\t<access_key>\t<secret>\t<created_at>
-    std::string udat = user_dat_path();
-    std::string udat_tmp = udat + ".tmp";
-    std::ofstream fu(udat_tmp);
-    if (fu.is_open()) {
-        fu << "N\t" << next_user_id_ << "\n";
+
+    std::memcpy(h.magic, kSnapMagic, sizeof(kSnapMagic));
+    h.version = kSnapVersion;
+    h.byte_order = kSnapByteOrder;
+    h.next_bucket_id = next_bucket_id;
+    h.next_object_id = next_object_id;
+    h.object_count = object_count;
+    h.bucket_count = brecs.size();
+    h.objects_off = sizeof(SnapHeader);
+    h.buckets_off = h.objects_off + object_count * sizeof(ObjectRecord);
+    h.heap_off = h.buckets_off + brecs.size() * sizeof(BucketRecord);
+    h.heap_size = heap.size;
+    return ::pwrite(fd, &h, sizeof(h), 0) == static_cast<ssize_t>(sizeof(h));
+}
+
+bool MetaStore::checkpoint() {
+    std::lock_guard<std::mutex> cp_lock(checkpoint_mutex_);
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t sealed_gen = 0, sealed_bytes = 0;
+    SnapshotFormat format;
+    int64_t next_bucket_id = 0, next_object_id = 0;
+    std::string users;
+    std::vector<Bucket> buckets;
+    {
+        // 1. 把缓冲写进当前日志并封存，之后的变更写到下一代；再取桶、用户与 next_id（数量少，持共享锁拷贝）。
+        //    换出缓冲与拷贝之间发生的变更既在新一代日志里、也可能已反映在拷贝中，重放幂等，结果不变
+        std::lock_guard<std::mutex> journal_lock(journal_mutex_);
+        last_save_error_.clear();
+        if (!flush_journal()) {
+            std::cerr << "meta: checkpoint failed: " << last_save_error_ << std::endl;
+            return false;
+        }
+        format = snapshot_format_;
+        if (journal_bytes_ == 0 && disk_format_ == format) return true;  // 快照之后没有变更，也无需转换格式
+        sealed_gen = journal_gen_++;
+        sealed_bytes = journal_bytes_;
+        if (journal_sync_ && journal_file_) sealed_journals_.push_back(journal_file_);
+        journal_file_.reset();
+
+        std::shared_lock<RwLock> lock(mutex_);
+        next_bucket_id = next_bucket_id_;
+        next_object_id = next_object_id_;
+        buckets = buckets_;
+        users = "N\t" + std::to_string(next_user_id_) + "\n";
         for (const User& u : users_) {
             auto it = secret_by_access_key_.find(u.access_key);
-            if (it != secret_by_access_key_.end())
-                fu << "U\t" << u.id << "\t" << u.username << "\t" << u.access_key << "\t" << it->second << "\t" << u.created_at << "\n";
+            if (it == secret_by_access_key_.end()) continue;
+            users += "U\t" + std::to_string(u.id) + "\t" + u.username + "\t" + u.access_key + "\t" +
+                     it->second + "\t" + u.created_at + "\n";
         }
-        fu.close();
-        if (fu.good())
-            rename(udat_tmp.c_str(), udat.c_str());
     }
+    std::sort(buckets.begin(), buckets.end(), [](const Bucket& a, const Bucket& b) { return a.id < b.id; });
+
+    // 2. 写新快照：对象按桶、按 key 分批取（copy_object_batch），每批单独持锁，批间其他请求照常读写。
+    //    从未变更的对象按 key 游标恰好取到一次；扫描期间变更的对象都在新一代日志里，重放后得到最终状态
+    auto write_file = [](const std::string& path, const std::function<bool(int)>& write) -> bool {
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            std::cerr << "meta: checkpoint open " << tmp << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        bool ok = write(fd) && ::fdatasync(fd) == 0;
+        if (!ok) std::cerr << "meta: checkpoint write " << tmp << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        if (ok && ::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::cerr << "meta: checkpoint rename " << path << ": " << strerror(errno) << std::endl;
+            ok = false;
+        }
+        if (!ok) ::unlink(tmp.c_str());
+        return ok;
+    };
+    bool binary = format == SnapshotFormat::binary;
+    std::string path = binary ? snapshot_path() : meta_file_path();
+    bool ok = write_file(path, [&](int fd) {
+        return binary ? write_binary_snapshot(fd, next_bucket_id, next_object_id, buckets)
+                      : write_text_snapshot(fd, next_bucket_id, next_object_id, buckets);
+    });
+    ok = ok && write_file(user_dat_path(), [&users](int fd) { return write_all(fd, users.data(), users.size()); });
+    if (!ok) return false;  // 已封存的日志保留，下次 checkpoint 一并折叠
+    fsync_dir(data_root_);
+
+    // 3. 删除另一种格式的旧快照（load 优先读二进制快照，不删则切回文本格式后重启仍会读到它）。
+    //    删除落盘之前不能删日志：否则崩溃后可能读到旧快照而缺了已被新快照折叠的日志
+    std::string other = binary ? meta_file_path() : snapshot_path();
+    if (::unlink(other.c_str()) == 0) fsync_dir(data_root_);
+    else if (errno != ENOENT) {
+        std::cerr << "meta: checkpoint unlink " << other << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 4. 快照已落盘，删除被它覆盖的各代日志
+    for (uint64_t gen : journal_gens()) {
+        if (gen <= sealed_gen) ::unlink(journal_path(gen).c_str());
+    }
+    {
+        std::lock_guard<std::mutex> journal_lock(journal_mutex_);
+        journal_bytes_ -= sealed_bytes;
+        sealed_journals_.clear();  // 都已被落盘的快照覆盖
+        disk_format_ = format;
+    }
+    size_t objects = object_count();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "meta: checkpoint " << (binary ? "binary" : "text") << " objects=" << objects
+              << " folded_journal_bytes=" << sealed_bytes << " in " << ms << " ms" << std::endl;
     return true;
 }
 
-const Bucket* MetaStore::get_bucket_by_name_and_owner(const std::string& name, const std::string& owner_id) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const Bucket& b : buckets_) {
-        if (b.name == name && b.owner_id == owner_id) return &b;
+void MetaStore::start_checkpointer(uint64_t journal_bytes) {
+    if (journal_bytes == 0 || checkpointer_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(journal_mutex_);
+        checkpoint_bytes_ = journal_bytes;
+        checkpointer_stop_ = false;
     }
-    return nullptr;
+    checkpointer_ = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(journal_mutex_);
+        while (!checkpointer_stop_) {
+            if (journal_bytes_ < checkpoint_bytes_) {
+                checkpoint_cv_.wait(lock);
+                continue;
+            }
+            lock.unlock();
+            bool ok = checkpoint();
+            lock.lock();
+            // 失败（如磁盘满）时不立即重试
+            if (!ok) checkpoint_cv_.wait_for(lock, std::chrono::seconds(10));
+        }
+    });
+}
+
+void MetaStore::stop_checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock(journal_mutex_);
+        checkpointer_stop_ = true;
+    }
+    checkpoint_cv_.notify_all();
+    if (checkpointer_.joinable()) checkpointer_.join();
+    checkpoint();  // 退出前折叠日志，下次启动无需重放
+}
+
+bool MetaStore::get_bucket_by_name_and_owner(const std::string& name, const std::string& owner_id, Bucket& out) const {
+    std::shared_lock<RwLock> lock(mutex_);
+    auto it = bucket_by_owner_name_.find(std::make_pair(owner_id, name));
+    if (it == bucket_by_owner_name_.end()) return false;
+    out = buckets_[it->second];
+    return true;
 }
 
 std::vector<Bucket> MetaStore::list_buckets_by_owner(const std::string& owner_id) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<RwLock> lock(mutex_);
     std::vector<Bucket> out;
     for (const Bucket& b : buckets_)
         if (b.owner_id == owner_id) out.push_back(b);
@@ -239,62 +1012,206 @@ std::vector<Bucket> MetaStore::list_buckets_by_owner(const std::string& owner_id
 }
 
 int64_t MetaStore::create_bucket(const std::string& name, const std::string& owner_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const Bucket& b : buckets_)
-        if (b.name == name && b.owner_id == owner_id) return 0;  // 同一用户同名桶只记一次
+    std::lock_guard<RwLock> lock(mutex_);
+    if (bucket_by_owner_name_.count(std::make_pair(owner_id, name))) return 0;  // 同一用户同名桶只记一次
     Bucket b;
     b.id = next_bucket_id_++;
     b.name = name;
     b.created_at = now_iso8601();
     b.owner_id = owner_id;
-    buckets_.push_back(std::move(b));
-    return buckets_.back().id;
+    int64_t id = b.id;
+    std::lock_guard<RwLock> stripe_lock(stripe_of(id).mutex);
+    std::string record;
+    append_bucket_line(record, b);
+    journal_append(record);
+    insert_bucket(std::move(b));
+    return id;
 }
 
 bool MetaStore::delete_bucket(int64_t bucket_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = std::remove_if(buckets_.begin(), buckets_.end(),
-        [bucket_id](const Bucket& b) { return b.id == bucket_id; });
-    if (it == buckets_.end()) return false; // 未找到
-    buckets_.erase(it, buckets_.end());
+    std::lock_guard<RwLock> lock(mutex_);
+    std::lock_guard<RwLock> stripe_lock(stripe_of(bucket_id).mutex);
+    if (!remove_bucket(bucket_id)) return false; // 未找到
+    journal_append("b\t" + std::to_string(bucket_id) + "\n");
+    return true;
+}
+
+void MetaStore::insert_bucket(Bucket b) {
+    // 重放时同一 id 或同一 (owner_id, name) 的旧记录先移除
+    remove_bucket(b.id);
+    auto same = bucket_by_owner_name_.find(std::make_pair(b.owner_id, b.name));
+    if (same != bucket_by_owner_name_.end()) remove_bucket(buckets_[same->second].id);
+    if (b.id >= next_bucket_id_) next_bucket_id_ = b.id + 1;
+    bucket_by_owner_name_[std::make_pair(b.owner_id, b.name)] = buckets_.size();
+    bucket_by_id_[b.id] = buckets_.size();
+    int64_t id = b.id;
+    buckets_.push_back(std::move(b));
+    stripe_of(id).dir_by_bucket[id] = object_dir(id);
+}
+
+bool MetaStore::remove_bucket(int64_t bucket_id) {
+    auto it = bucket_by_id_.find(bucket_id);
+    if (it == bucket_by_id_.end()) return false; // 未找到
+    // 仍有对象时（重放中桶被同 id 或同名的新桶替换）先把它们的推导路径固定下来，之后不再依赖这个桶
+    Stripe& s = stripe_of(bucket_id);
+    auto keys = s.keys_by_bucket.find(bucket_id);
+    if (keys != s.keys_by_bucket.end()) {
+        std::string dir = stripe_dir(s, bucket_id);
+        for (KeyIndex::Iterator k = keys->second.begin(); k.valid(); k.next()) s.objects.pin_storage_path(k.value(), dir);
+    }
+    s.dir_by_bucket.erase(bucket_id);
+    size_t idx = it->second;
+    bucket_by_id_.erase(it);
+    bucket_by_owner_name_.erase(std::make_pair(buckets_[idx].owner_id, buckets_[idx].name));
+    size_t last = buckets_.size() - 1;
+    if (idx != last) {
+        buckets_[idx] = std::move(buckets_[last]);
+        bucket_by_id_[buckets_[idx].id] = idx;
+        bucket_by_owner_name_[std::make_pair(buckets_[idx].owner_id, buckets_[idx].name)] = idx;
+    }
+    buckets_.pop_back();
+    return true;
+}
+
+std::string MetaStore::object_dir(int64_t bucket_id) const {
+    auto it = bucket_by_id_.find(bucket_id);
+    if (it == bucket_by_id_.end()) return std::string();
+    const Bucket& b = buckets_[it->second];
+    std::string p = data_root_;
+    if (!p.empty() && p.back() != '/') p += '/';
+    p += "s3/";
+    if (!b.owner_id.empty()) {
+        p += b.owner_id;
+        p += '_';
+    }
+    p += b.name;
+    p += '/';
+    return p;
+}
+
+std::string MetaStore::stripe_dir(const Stripe& s, int64_t bucket_id) {
+    auto it = s.dir_by_bucket.find(bucket_id);
+    return it != s.dir_by_bucket.end() ? it->second : std::string();
+}
+
+bool MetaStore::erase_object(Stripe& s, int64_t bucket_id, const std::string& key) {
+    uint32_t idx;
+    if (!s.objects.find(bucket_id, key, idx)) return false;
+    auto b = s.keys_by_bucket.find(bucket_id);
+    b->second.erase(key);
+    if (b->second.empty()) s.keys_by_bucket.erase(b);
+    // 与末尾交换后弹出，只需改被移动那条的 key 索引（哈希索引由 ObjectTable 维护）
+    if (s.objects.erase(idx)) s.keys_by_bucket[s.objects.bucket_id(idx)].assign(s.objects.key(idx), idx);
     return true;
 }
 
 bool MetaStore::get_object(int64_t bucket_id, const std::string& key, Object& out) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const Object& o : objects_)
-        if (o.bucket_id == bucket_id && o.key == key) {
-            out = o;
-            return true;
-        }
-    return false;
+    const Stripe& s = stripe_of(bucket_id);
+    std::shared_lock<RwLock> lock(s.mutex);
+    uint32_t idx;
+    if (!s.objects.find(bucket_id, key, idx)) return false;
+    s.objects.get(idx, stripe_dir(s, bucket_id), out);
+    return true;
 }
 
 std::vector<Object> MetaStore::list_objects(int64_t bucket_id) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    const Stripe& s = stripe_of(bucket_id);
+    std::shared_lock<RwLock> lock(s.mutex);
     std::vector<Object> out;
-    for (const Object& o : objects_)
-        if (o.bucket_id == bucket_id) out.push_back(o);
+    auto b = s.keys_by_bucket.find(bucket_id);
+    if (b == s.keys_by_bucket.end()) return out;
+    out.resize(b->second.size());
+    std::string dir = stripe_dir(s, bucket_id);
+    size_t i = 0;
+    for (KeyIndex::Iterator it = b->second.begin(); it.valid(); it.next()) s.objects.get(it.value(), dir, out[i++]);
     return out;
 }
 
+bool MetaStore::has_objects(int64_t bucket_id) const {
+    const Stripe& s = stripe_of(bucket_id);
+    std::shared_lock<RwLock> lock(s.mutex);
+    return s.keys_by_bucket.count(bucket_id) > 0;  // 桶的最后一个对象删除时其索引项一并移除
+}
+
+size_t MetaStore::object_count() const {
+    size_t n = 0;
+    for (const Stripe& s : stripes_) {
+        std::shared_lock<RwLock> lock(s.mutex);
+        n += s.objects.size();
+    }
+    return n;
+}
+
+// 以 p 开头的所有字符串之后的第一个字符串（末尾 0xff 进位）；返回空表示不存在上界
+static std::string prefix_successor(std::string p) {
+    while (!p.empty() && static_cast<unsigned char>(p.back()) == 0xff) p.pop_back();
+    if (!p.empty()) p.back() = static_cast<char>(static_cast<unsigned char>(p.back()) + 1);
+    return p;
+}
+
+void MetaStore::list_objects_page(int64_t bucket_id, const std::string& prefix, const std::string& delimiter,
+                                  const std::string& start_after, size_t max_keys, ListPage& out) const {
+    out.objects.clear();
+    out.common_prefixes.clear();
+    out.truncated = false;
+    out.next_marker.clear();
+    const Stripe& s = stripe_of(bucket_id);
+    std::shared_lock<RwLock> lock(s.mutex);
+    auto b = s.keys_by_bucket.find(bucket_id);
+    if (b == s.keys_by_bucket.end()) return;
+    const KeyIndex& keys = b->second;
+    std::string dir = stripe_dir(s, bucket_id);
+
+    KeyIndex::Iterator it = keys.lower_bound(prefix);
+    if (start_after >= prefix) {
+        // start_after 本身是公共前缀（上一页以它结尾）时跳过整组
+        bool is_group = !delimiter.empty() && start_after.size() > prefix.size() &&
+            start_after.compare(0, prefix.size(), prefix) == 0 &&
+            start_after.find(delimiter, prefix.size()) == start_after.size() - delimiter.size();
+        if (is_group) {
+            std::string next = prefix_successor(start_after);
+            it = next.empty() ? KeyIndex::Iterator() : keys.lower_bound(next);
+        } else {
+            it = keys.upper_bound(start_after);
+        }
+    }
+
+    size_t count = 0;
+    std::string key;
+    while (it.valid()) {
+        if (!it.has_prefix(prefix)) break;  // 已越过前缀范围
+        if (count == max_keys) {
+            out.truncated = count > 0;  // max_keys=0 只返回空页，不给出续页
+            break;
+        }
+        it.key(key);
+        size_t pos = delimiter.empty() ? std::string::npos : key.find(delimiter, prefix.size());
+        if (pos != std::string::npos) {
+            std::string group = key.substr(0, pos + delimiter.size());
+            std::string next = prefix_successor(group);
+            out.common_prefixes.push_back(std::move(group));
+            out.next_marker = out.common_prefixes.back();
+            it = next.empty() ? KeyIndex::Iterator() : keys.lower_bound(next);
+        } else {
+            out.objects.emplace_back();
+            s.objects.get(it.value(), dir, out.objects.back());
+            out.next_marker = key;
+            it.next();
+        }
+        ++count;
+    }
+    if (!out.truncated) out.next_marker.clear();
+}
+
 // 同一 bucket_id+key 在 s3_meta.dat 只记一条；重复 PUT 为覆盖更新
 bool MetaStore::put_object(int64_t bucket_id, const std::string& key, int64_t size,
                            const std::string& last_modified, const std::string& etag,
                            const std::string& storage_path, const std::string& acl) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (Object& o : objects_) {
-        if (o.bucket_id == bucket_id && o.key == key) {
-            o.size = size;
-            o.last_modified = last_modified;
-            o.etag = etag;
-            o.storage_path = storage_path;
-            o.acl = acl;
-            return true;
-        }
-    }
+    Stripe& s = stripe_of(bucket_id);
+    std::lock_guard<RwLock> lock(s.mutex);
+    uint32_t existing;
     Object o;
-    o.id = next_object_id_++;
+    o.id = s.objects.find(bucket_id, key, existing) ? s.objects.id(existing) : next_object_id_++;
     o.bucket_id = bucket_id;
     o.key = key;
     o.size = size;
@@ -302,37 +1219,103 @@ bool MetaStore::put_object(int64_t bucket_id, const std::string& key, int64_t si
     o.etag = etag;
     o.storage_path = storage_path;
     o.acl = acl;
-    objects_.push_back(std::move(o));
+    std::string record;
+    append_object_line(record, o);
+    journal_append(record);
+    upsert_object(s, o);
+    if (!s.reserved.empty()) s.reserved.erase(std::make_pair(bucket_id, key));
     return true;
 }
 
+bool MetaStore::reserve_object(int64_t bucket_id, const std::string& key) {
+    Stripe& s = stripe_of(bucket_id);
+    std::lock_guard<RwLock> lock(s.mutex);
+    uint32_t existing;
+    if (s.objects.find(bucket_id, key, existing)) return false;
+    return s.reserved.emplace(bucket_id, key).second;
+}
+
+void MetaStore::release_object(int64_t bucket_id, const std::string& key) {
+    Stripe& s = stripe_of(bucket_id);
+    std::lock_guard<RwLock> lock(s.mutex);
+    s.reserved.erase(std::make_pair(bucket_id, key));
+}
+
+void MetaStore::upsert_object(Stripe& s, const Object& o) {
+    if (o.id >= next_object_id_) next_object_id_ = o.id + 1;  // 只在重放时成立（单线程）
+    ObjectTable::Fields f;
+    f.id = o.id;
+    f.bucket_id = o.bucket_id;
+    f.size = o.size;
+    f.key = o.key;
+    f.last_modified = o.last_modified;
+    f.etag = o.etag;
+    f.storage_path = o.storage_path;
+    f.acl = o.acl;
+    bool inserted;
+    uint32_t idx = s.objects.upsert(f, stripe_dir(s, o.bucket_id), inserted);
+    if (inserted) s.keys_by_bucket[o.bucket_id].insert(o.key, idx);
+}
+
+void MetaStore::journal_append(const std::string& record) {
+    std::lock_guard<std::mutex> lock(journal_buf_mutex_);
+    journal_buf_ += record;
+}
+
+void MetaStore::journal_object_delete(int64_t bucket_id, const std::string& key) {
+    std::lock_guard<std::mutex> lock(journal_buf_mutex_);
+    journal_buf_ += "o\t";
+    journal_buf_ += std::to_string(bucket_id);
+    journal_buf_ += '\t';
+    journal_buf_ += key;
+    journal_buf_ += '\n';
+}
+
 bool MetaStore::delete_object(int64_t bucket_id, const std::string& key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = std::remove_if(objects_.begin(), objects_.end(),
-        [bucket_id, &key](const Object& o) { return o.bucket_id == bucket_id && o.key == key; });
-    if (it == objects_.end()) return false; // 未找到
-    objects_.erase(it, objects_.end());
+    Stripe& s = stripe_of(bucket_id);
+    std::lock_guard<RwLock> lock(s.mutex);
+    if (!erase_object(s, bucket_id, key)) return false;
+    journal_object_delete(bucket_id, key);
     return true;
 }
 
+void MetaStore::get_objects(int64_t bucket_id, const std::vector<std::string>& keys, std::vector<Object>& out) const {
+    out.assign(keys.size(), Object());
+    const Stripe& s = stripe_of(bucket_id);
+    std::shared_lock<RwLock> lock(s.mutex);
+    std::string dir = stripe_dir(s, bucket_id);
+    uint32_t idx;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (s.objects.find(bucket_id, keys[i], idx)) s.objects.get(idx, dir, out[i]);
+    }
+}
+
+size_t MetaStore::delete_objects(int64_t bucket_id, const std::vector<std::string>& keys) {
+    Stripe& s = stripe_of(bucket_id);
+    std::lock_guard<RwLock> lock(s.mutex);
+    size_t n = 0;
+    for (const std::string& key : keys) {
+        if (!erase_object(s, bucket_id, key)) continue;
+        journal_object_delete(bucket_id, key);
+        ++n;
+    }
+    return n;
+}
+
 std::string MetaStore::get_secret_by_access_key(const std::string& access_key) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<RwLock> lock(mutex_);
     auto it = secret_by_access_key_.find(access_key);
     return it != secret_by_access_key_.end() ? it->second : std::string{};
 }
 
 bool MetaStore::has_user_by_access_key(const std::string& access_key) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const User& u : users_)
-        if (u.access_key == access_key) return true;
-    return false;
+    std::shared_lock<RwLock> lock(mutex_);
+    return user_by_access_key_.count(access_key) > 0;
 }
 
 bool MetaStore::has_user_by_username(const std::string& username) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const User& u : users_)
-        if (u.username == username) return true;
-    return false;
+    std::shared_lock<RwLock> lock(mutex_);
+    return user_by_username_.count(username) > 0;
 }
 
 static const char kAlnum[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
@@ -351,18 +1334,17 @@ bool MetaStore::create_user(const std::string& username, std::string& out_access
     }
     std::string ak, sk;
     if (!random_alnum_string(20, ak) || !random_alnum_string(40, sk)) return false;
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const User& u : users_) {
-        if (u.access_key == ak) return false;   // 新 access_key 与已有用户冲突（极低概率）
-        if (u.username == username) return false; // 用户名已存在，视为用户已存在
-    }
+    std::lock_guard<RwLock> lock(mutex_);
+    if (user_by_access_key_.count(ak)) return false;   // 新 access_key 与已有用户冲突（极低概率）
+    if (user_by_username_.count(username)) return false; // 用户名已存在，视为用户已存在
     std::string created = now_iso8601();
     User u;
     u.id = next_user_id_++;
     u.username = username;
     u.access_key = ak;
     u.created_at = created;
-    users_.push_back(std::move(u));
+    journal_append("U\t" + std::to_string(u.id) + "\t" + u.username + "\t" + ak + "\t" + sk + "\t" + created + "\n");
+    add_user(std::move(u));
     secret_by_access_key_[ak] = std::move(sk);  // 仅存服务端 user.dat，不返回给调用方
     out_access_key = std::move(ak);
     out_created_at = std::move(created);
@@ -371,22 +1353,26 @@ bool MetaStore::create_user(const std::string& username, std::string& out_access
 
 void MetaStore::ensure_root_user(const std::string& access_key, const std::string& secret_key) {
     if (access_key.empty()) return;
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const User& u : users_) {
-        if (u.username == "root") return;  // 已存在 root，不重复添加
-    }
+    std::lock_guard<RwLock> lock(mutex_);
+    if (user_by_username_.count("root")) return;  // 已存在 root，不重复添加
     std::string created = now_iso8601();
     User u;
     u.id = next_user_id_++;
     u.username = "root";
     u.access_key = access_key;
     u.created_at = created;
-    users_.push_back(std::move(u));
+    add_user(std::move(u));
     secret_by_access_key_[access_key] = secret_key;
 }
 
+void MetaStore::add_user(User u) {
+    user_by_access_key_[u.access_key] = users_.size();
+    user_by_username_[u.username] = users_.size();
+    users_.push_back(std::move(u));
+}
+
 std::vector<User> MetaStore::list_users() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<RwLock> lock(mutex_);
     return users_;
 }
 
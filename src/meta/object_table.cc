@@ -0,0 +1,471 @@
+#include "meta/object_table.h"
+#include "meta/meta.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace meta {
+
+namespace {
+
+// Rec::flags：该字段不能紧凑表示，原样存在 blob 中（按位序依次排在 key 之后）
+enum : uint8_t {
+    kExtraLastModified = 1,
+    kExtraEtag = 2,
+    kExtraStoragePath = 4,
+    kExtraAcl = 8,
+    kEtagEmpty = 16,  // etag 为空串（S3_ETAG_HASH=none）
+};
+
+const char* const kAcls[] = {"private", "public-read", "public-read-write", "authenticated-read"};
+
+// arena 新块的大小为已有各块之和（首块 kMinChunkSize），到 kChunkSize 为止；超长 blob 单独成块。
+// MetaStore 每个条带一张表，小表不必各占一整块
+const uint32_t kMinChunkSize = 64u << 10;
+const uint32_t kChunkSize = 4u << 20;
+const uint64_t kCompactMinGarbage = 16u << 20;
+
+// 公历日期与 1970-01-01 起天数互转（Howard Hinnant 的 days_from_civil / civil_from_days）
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+// 格式化为 YYYY-MM-DDTHH:MM:SSZ（年份须在 0..9999）
+void format_iso8601(int64_t t, char out[20]) {
+    int64_t days = t >= 0 ? t / 86400 : -((-t + 86399) / 86400);
+    int64_t secs = t - days * 86400;
+    int64_t y;
+    unsigned m, d;
+    civil_from_days(days, y, m, d);
+    auto put = [](char* p, unsigned v, int width) {
+        for (int i = width - 1; i >= 0; --i, v /= 10) p[i] = static_cast<char>('0' + v % 10);
+    };
+    put(out, static_cast<unsigned>(y), 4);
+    out[4] = '-';
+    put(out + 5, m, 2);
+    out[7] = '-';
+    put(out + 8, d, 2);
+    out[10] = 'T';
+    put(out + 11, static_cast<unsigned>(secs / 3600), 2);
+    out[13] = ':';
+    put(out + 14, static_cast<unsigned>(secs / 60 % 60), 2);
+    out[16] = ':';
+    put(out + 17, static_cast<unsigned>(secs % 60), 2);
+    out[19] = 'Z';
+}
+
+// 只接受格式化后能原样还原的时间戳（否则存原串）
+bool parse_iso8601(std::string_view s, int64_t& t) {
+    if (s.size() != 20) return false;
+    unsigned v[6];
+    static const int pos[6] = {0, 5, 8, 11, 14, 17};
+    static const int width[6] = {4, 2, 2, 2, 2, 2};
+    for (int i = 0; i < 6; ++i) {
+        v[i] = 0;
+        for (int j = 0; j < width[i]; ++j) {
+            char c = s[pos[i] + j];
+            if (c < '0' || c > '9') return false;
+            v[i] = v[i] * 10 + static_cast<unsigned>(c - '0');
+        }
+    }
+    if (v[1] < 1 || v[1] > 12 || v[2] < 1 || v[2] > 31) return false;
+    t = days_from_civil(v[0], v[1], v[2]) * 86400 + v[3] * 3600 + v[4] * 60 + v[5];
+    char back[20];
+    format_iso8601(t, back);
+    return s == std::string_view(back, sizeof(back));
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// <32 位小写十六进制>[-<1..65535>]
+bool parse_etag(std::string_view s, uint8_t md5[16], uint16_t& parts) {
+    if (s.size() < 32) return false;
+    for (int i = 0; i < 16; ++i) {
+        int hi = hex_value(s[2 * i]), lo = hex_value(s[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        md5[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    parts = 0;
+    if (s.size() == 32) return true;
+    if (s[32] != '-' || s.size() < 34 || s.size() > 38 || s[33] == '0') return false;
+    uint32_t n = 0;
+    for (size_t i = 33; i < s.size(); ++i) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        n = n * 10 + static_cast<uint32_t>(s[i] - '0');
+    }
+    if (n > UINT16_MAX) return false;
+    parts = static_cast<uint16_t>(n);
+    return true;
+}
+
+bool derived_path(std::string_view path, std::string_view prefix, std::string_view key) {
+    return !prefix.empty() && path.size() == prefix.size() + key.size() &&
+           path.compare(0, prefix.size(), prefix) == 0 && path.compare(prefix.size(), key.size(), key) == 0;
+}
+
+// blob 中 key 之后的额外字段，顺序同 flags 位序
+template <class F>
+void for_each_extra(uint8_t flags, const ObjectTable::Fields& f, F fn) {
+    if (flags & kExtraLastModified) fn(f.last_modified);
+    if (flags & kExtraEtag) fn(f.etag);
+    if (flags & kExtraStoragePath) fn(f.storage_path);
+    if (flags & kExtraAcl) fn(f.acl);
+}
+
+}
+
+ObjectTable::ObjectTable() = default;
+ObjectTable::~ObjectTable() = default;
+
+void ObjectTable::clear() {
+    recs_.clear();
+    recs_.shrink_to_fit();
+    bucket_ids_.clear();
+    slot_of_bucket_.clear();
+    chunks_.clear();
+    chunk_sizes_.clear();
+    chunk_bytes_ = 0;
+    chunk_used_ = 0;
+    live_bytes_ = 0;
+    garbage_bytes_ = 0;
+    slots_.clear();
+    slots_.shrink_to_fit();
+}
+
+uint32_t ObjectTable::hash_of(int64_t bucket_id, std::string_view key) {
+    uint64_t h = std::hash<std::string_view>()(key) ^ (static_cast<uint64_t>(bucket_id) * 0x9e3779b97f4a7c15ULL);
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 32;
+    return static_cast<uint32_t>(h);
+}
+
+uint32_t ObjectTable::bucket_slot(int64_t bucket_id) {
+    auto ins = slot_of_bucket_.emplace(bucket_id, static_cast<uint32_t>(bucket_ids_.size()));
+    if (ins.second) bucket_ids_.push_back(bucket_id);
+    return ins.first->second;
+}
+
+void ObjectTable::encode(Rec& r, const Fields& f, std::string_view path_prefix) {
+    r.id = f.id;
+    r.size = f.size;
+    r.key_len = static_cast<uint32_t>(f.key.size());
+    r.hash = hash_of(f.bucket_id, f.key);
+    r.flags = 0;
+    r.mtime = 0;
+    std::memset(r.etag, 0, sizeof(r.etag));
+    r.etag_parts = 0;
+    r.acl = 0;
+    if (!parse_iso8601(f.last_modified, r.mtime)) r.flags |= kExtraLastModified;
+    if (f.etag.empty()) r.flags |= kEtagEmpty;
+    else if (!parse_etag(f.etag, r.etag, r.etag_parts)) r.flags |= kExtraEtag;
+    if (!derived_path(f.storage_path, path_prefix, f.key)) r.flags |= kExtraStoragePath;
+    r.flags |= kExtraAcl;
+    for (uint8_t i = 0; i < sizeof(kAcls) / sizeof(kAcls[0]); ++i) {
+        if (f.acl == kAcls[i]) {
+            r.acl = i;
+            r.flags &= static_cast<uint8_t>(~kExtraAcl);
+            break;
+        }
+    }
+}
+
+size_t ObjectTable::encoded_size(const Rec& r, const Fields& f) {
+    size_t n = f.key.size();
+    for_each_extra(r.flags, f, [&n](std::string_view s) { n += sizeof(uint32_t) + s.size(); });
+    return n;
+}
+
+void ObjectTable::write_encoded(char* p, const Rec& r, const Fields& f) {
+    std::memcpy(p, f.key.data(), f.key.size());
+    p += f.key.size();
+    for_each_extra(r.flags, f, [&p](std::string_view s) {
+        uint32_t len = static_cast<uint32_t>(s.size());
+        std::memcpy(p, &len, sizeof(len));
+        std::memcpy(p + sizeof(len), s.data(), s.size());
+        p += sizeof(len) + s.size();
+    });
+}
+
+size_t ObjectTable::blob_size(const Rec& r, const char* p) {
+    size_t n = r.key_len;
+    for (uint8_t bit = kExtraLastModified; bit <= kExtraAcl; bit <<= 1) {
+        if (!(r.flags & bit)) continue;
+        uint32_t len;
+        std::memcpy(&len, p + n, sizeof(len));
+        n += sizeof(len) + len;
+    }
+    return n;
+}
+
+const char* ObjectTable::blob_ptr(uint64_t blob) const {
+    return chunks_[blob >> 32].get() + static_cast<uint32_t>(blob);
+}
+
+char* ObjectTable::blob_ptr(uint64_t blob) {
+    return chunks_[blob >> 32].get() + static_cast<uint32_t>(blob);
+}
+
+uint64_t ObjectTable::alloc(size_t len) {
+    if (chunks_.empty() || len > chunk_sizes_.back() - chunk_used_) {
+        uint32_t size = static_cast<uint32_t>(std::min<uint64_t>(kChunkSize, std::max<uint64_t>(kMinChunkSize, chunk_bytes_)));
+        size = std::max<uint32_t>(size, static_cast<uint32_t>(len));
+        chunks_.emplace_back(new char[size]);
+        chunk_sizes_.push_back(size);
+        chunk_bytes_ += size;
+        chunk_used_ = 0;
+    }
+    uint64_t blob = static_cast<uint64_t>(chunks_.size() - 1) << 32 | chunk_used_;
+    chunk_used_ += static_cast<uint32_t>(len);
+    live_bytes_ += len;
+    return blob;
+}
+
+void ObjectTable::store(Rec& r, const Fields& f) {
+    size_t len = encoded_size(r, f);
+    r.blob = alloc(len);
+    write_encoded(blob_ptr(r.blob), r, f);
+}
+
+void ObjectTable::release(const Rec& r) {
+    size_t len = blob_size(r, blob_ptr(r.blob));
+    live_bytes_ -= len;
+    garbage_bytes_ += len;
+}
+
+void ObjectTable::maybe_compact() {
+    if (garbage_bytes_ < kCompactMinGarbage || garbage_bytes_ < live_bytes_) return;
+    // 按记录顺序把存活的 blob 拷到新块，代价与存活字节数成正比；只在空洞多于存活数据时做，均摊到每次删除为 O(1)
+    std::vector<std::unique_ptr<char[]>> old;
+    old.swap(chunks_);
+    chunk_sizes_.clear();
+    chunk_bytes_ = 0;
+    chunk_used_ = 0;
+    live_bytes_ = 0;
+    garbage_bytes_ = 0;
+    for (Rec& r : recs_) {
+        const char* src = old[r.blob >> 32].get() + static_cast<uint32_t>(r.blob);
+        size_t len = blob_size(r, src);
+        r.blob = alloc(len);
+        std::memcpy(blob_ptr(r.blob), src, len);
+    }
+}
+
+std::string_view ObjectTable::key(uint32_t idx) const {
+    const Rec& r = recs_[idx];
+    return std::string_view(blob_ptr(r.blob), r.key_len);
+}
+
+bool ObjectTable::find(int64_t bucket_id, std::string_view key, uint32_t& idx) const {
+    if (slots_.empty()) return false;
+    uint32_t hash = hash_of(bucket_id, key);
+    size_t mask = slots_.size() - 1;
+    for (size_t pos = hash & mask; slots_[pos] != 0; pos = (pos + 1) & mask) {
+        uint64_t s = slots_[pos];
+        if (static_cast<uint32_t>(s >> 32) != hash) continue;
+        uint32_t i = static_cast<uint32_t>(s) - 1;
+        if (bucket_ids_[recs_[i].bucket] == bucket_id && this->key(i) == key) {
+            idx = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ObjectTable::slot_of(uint32_t hash, uint32_t idx) const {
+    size_t mask = slots_.size() - 1;
+    uint64_t want = static_cast<uint64_t>(hash) << 32 | (idx + 1);
+    size_t pos = hash & mask;
+    while (slots_[pos] != want) pos = (pos + 1) & mask;
+    return pos;
+}
+
+void ObjectTable::index_insert(uint32_t hash, uint32_t idx) {
+    size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    while (slots_[pos] != 0) pos = (pos + 1) & mask;
+    slots_[pos] = static_cast<uint64_t>(hash) << 32 | (idx + 1);
+}
+
+void ObjectTable::index_erase(size_t pos) {
+    // 线性探测的后移删除：把后面探测链上、本可放在空位处的项前移，不留墓碑
+    size_t mask = slots_.size() - 1;
+    for (;;) {
+        slots_[pos] = 0;
+        size_t next = pos;
+        for (;;) {
+            next = (next + 1) & mask;
+            if (slots_[next] == 0) return;
+            size_t home = static_cast<uint32_t>(slots_[next] >> 32) & mask;
+            bool stays = pos <= next ? (pos < home && home <= next) : (pos < home || home <= next);
+            if (!stays) break;
+        }
+        slots_[pos] = slots_[next];
+        pos = next;
+    }
+}
+
+bool ObjectTable::reserve_index(size_t n) {
+    // 负载不超过 3/4
+    size_t cap = slots_.empty() ? 16 : slots_.size();
+    while (n * 4 > cap * 3) cap *= 2;
+    if (cap == slots_.size()) return false;
+    slots_.assign(cap, 0);
+    for (uint32_t i = 0; i < recs_.size(); ++i) index_insert(recs_[i].hash, i);
+    return true;
+}
+
+uint32_t ObjectTable::upsert(const Fields& f, std::string_view path_prefix, bool& inserted) {
+    uint32_t idx;
+    inserted = !find(f.bucket_id, f.key, idx);
+    Rec r;
+    r.bucket = bucket_slot(f.bucket_id);
+    encode(r, f, path_prefix);
+    if (!inserted) {
+        release(recs_[idx]);
+        store(r, f);
+        recs_[idx] = r;
+        maybe_compact();
+        return idx;
+    }
+    store(r, f);
+    idx = static_cast<uint32_t>(recs_.size());
+    recs_.push_back(r);
+    if (!reserve_index(recs_.size())) index_insert(r.hash, idx);  // 扩容时已连同新记录一起重建
+    return idx;
+}
+
+bool ObjectTable::erase(uint32_t idx) {
+    index_erase(slot_of(recs_[idx].hash, idx));
+    release(recs_[idx]);
+    uint32_t last = static_cast<uint32_t>(recs_.size() - 1);
+    bool moved = idx != last;
+    if (moved) {
+        recs_[idx] = recs_[last];
+        slots_[slot_of(recs_[idx].hash, last)] = static_cast<uint64_t>(recs_[idx].hash) << 32 | (idx + 1);
+    }
+    recs_.pop_back();
+    maybe_compact();
+    return moved;
+}
+
+void ObjectTable::get(uint32_t idx, std::string_view path_prefix, Object& out) const {
+    const Rec& r = recs_[idx];
+    const char* p = blob_ptr(r.blob);
+    out.id = r.id;
+    out.bucket_id = bucket_ids_[r.bucket];
+    out.size = r.size;
+    out.key.assign(p, r.key_len);
+    p += r.key_len;
+    auto next_extra = [&p](std::string& s) {
+        uint32_t len;
+        std::memcpy(&len, p, sizeof(len));
+        s.assign(p + sizeof(len), len);
+        p += sizeof(len) + len;
+    };
+    if (r.flags & kExtraLastModified) {
+        next_extra(out.last_modified);
+    } else {
+        char buf[20];
+        format_iso8601(r.mtime, buf);
+        out.last_modified.assign(buf, sizeof(buf));
+    }
+    if (r.flags & kExtraEtag) {
+        next_extra(out.etag);
+    } else if (r.flags & kEtagEmpty) {
+        out.etag.clear();
+    } else {
+        static const char kHex[] = "0123456789abcdef";
+        out.etag.resize(32);
+        for (int i = 0; i < 16; ++i) {
+            out.etag[2 * i] = kHex[r.etag[i] >> 4];
+            out.etag[2 * i + 1] = kHex[r.etag[i] & 15];
+        }
+        if (r.etag_parts) out.etag += "-" + std::to_string(r.etag_parts);
+    }
+    if (r.flags & kExtraStoragePath) {
+        next_extra(out.storage_path);
+    } else {
+        out.storage_path.reserve(path_prefix.size() + out.key.size());
+        out.storage_path.assign(path_prefix.data(), path_prefix.size());
+        out.storage_path += out.key;
+    }
+    if (r.flags & kExtraAcl) next_extra(out.acl);
+    else out.acl = kAcls[r.acl];
+}
+
+void ObjectTable::pin_storage_path(uint32_t idx, std::string_view path_prefix) {
+    Rec& r = recs_[idx];
+    if (r.flags & kExtraStoragePath) return;
+    Object o;
+    get(idx, path_prefix, o);
+    Fields f;
+    f.key = o.key;
+    f.last_modified = o.last_modified;
+    f.etag = o.etag;
+    f.storage_path = o.storage_path;
+    f.acl = o.acl;
+    release(r);
+    r.flags |= kExtraStoragePath;
+    store(r, f);
+    maybe_compact();
+}
+
+void ObjectTable::resize(size_t n) {
+    recs_.assign(n, Rec());
+}
+
+bool ObjectTable::pack(uint32_t idx, const Fields& f, std::string_view path_prefix) {
+    auto it = slot_of_bucket_.find(f.bucket_id);
+    if (it == slot_of_bucket_.end()) return false;
+    Rec& r = recs_[idx];
+    r.bucket = it->second;
+    encode(r, f, path_prefix);
+    r.blob = encoded_size(r, f);  // place_blobs 之前暂存 blob 长度
+    return true;
+}
+
+void ObjectTable::place_blobs() {
+    for (Rec& r : recs_) r.blob = alloc(static_cast<size_t>(r.blob));
+}
+
+void ObjectTable::write_blob(uint32_t idx, const Fields& f) {
+    const Rec& r = recs_[idx];
+    write_encoded(blob_ptr(r.blob), r, f);
+}
+
+void ObjectTable::build_index() {
+    slots_.clear();
+    reserve_index(recs_.size());
+}
+
+size_t ObjectTable::memory_usage() const {
+    size_t n = recs_.capacity() * sizeof(Rec) + slots_.capacity() * sizeof(uint64_t) +
+               bucket_ids_.capacity() * sizeof(int64_t) + chunk_sizes_.capacity() * sizeof(uint32_t) +
+               chunks_.capacity() * sizeof(chunks_[0]);
+    return n + chunk_bytes_;
+}
+
+}
@@ -0,0 +1,66 @@
+#include "metrics/metrics.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace metrics {
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::function<int64_t()>> gauges;
+    std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+}
+
+Counter& counter(const std::string& name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::unique_ptr<Counter>& slot = r.counters[name];
+    if (!slot) slot.reset(new Counter);
+    return *slot;
+}
+
+void gauge(const std::string& name, std::function<int64_t()> fn) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.gauges[name] = std::move(fn);
+}
+
+int64_t uptime_ms() {
+    auto d = std::chrono::steady_clock::now() - registry().start;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
+
+std::string to_json() {
+    Registry& r = registry();
+    std::map<std::string, int64_t> values;
+    std::map<std::string, std::function<int64_t()>> gauges;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& kv : r.counters) values[kv.first] = kv.second->get();
+        gauges = r.gauges;
+    }
+    // 派生指标在锁外计算，允许其内部再取计数器
+    for (const auto& kv : gauges) values[kv.first] = kv.second();
+    std::string out = "{\"uptime_ms\":" + std::to_string(static_cast<long long>(uptime_ms()));
+    for (const auto& kv : values) {
+        out += ",\"";
+        out += kv.first;  // 指标名由代码注册，不含需转义字符
+        out += "\":";
+        out += std::to_string(static_cast<long long>(kv.second));
+    }
+    out += "}";
+    return out;
+}
+
+}
@@ -117,7 +117,8 @@ x_buf_ptr x_buf_pool_t::get() {
         std::lock_guard<std::mutex> lock(global_lock_);
         if (X_UNLIKELY(global_free_list_.empty())) return x_buf_ptr(nullptr); // 流控：返回空
         
-        size_t fetch_cnt = std::min(global_free_list_.size(), x_thread_cache_t::L1_CAPACITY / 2);
+        // 批量按全局余量递减：线程多时避免少数线程把全局池一次搬空、其余线程在 L1 无货时饿死
+        size_t fetch_cnt = std::min(std::max<size_t>(global_free_list_.size() / 32, 1), x_thread_cache_t::L1_CAPACITY / 2);
         for (size_t i = 0; i < fetch_cnt - 1; ++i) {
             tlc.stack[tlc.count++] = global_free_list_.back();
             global_free_list_.pop_back();
@@ -251,6 +252,102 @@ bool x_msg_t::copy_in(x_buf_pool_t& pool, const void* src, uint32_t len)
     return true;
 }
 
+void x_msg_t::append_view(const x_msg_t& src, uint32_t offset, uint32_t len) {
+    for (const segment& seg : src.segments_) {
+        if (len == 0) break;
+        if (offset >= seg.length) {
+            offset -= seg.length;
+            continue;
+        }
+        uint32_t take = std::min(len, seg.length - offset);
+        append_unit(seg.unit, seg.offset + offset, take);
+        offset = 0;
+        len -= take;
+    }
+}
+
+uint32_t x_msg_t::tail_space(struct iovec& iov) const {
+    iov.iov_base = nullptr;
+    iov.iov_len = 0;
+    if (segments_.empty()) return 0;
+    const segment& last = segments_.back();
+    uint32_t used = last.offset + last.length;
+    if (used >= last.unit->capacity) return 0;
+    iov.iov_base = last.unit->data_ptr + used;
+    iov.iov_len = last.unit->capacity - used;
+    return static_cast<uint32_t>(iov.iov_len);
+}
+
+void x_msg_t::commit(uint32_t len) {
+    if (len == 0) return;
+    if (X_UNLIKELY(segments_.empty())) X_PANIC("COMMIT_WITHOUT_TAIL");
+    segment& last = segments_.back();
+    if (X_UNLIKELY(last.offset + last.length + len > last.unit->capacity)) X_PANIC("COMMIT_OUT_OF_BOUNDS");
+    last.length += len;
+    total_len_ += len;
+}
+
+void x_msg_t::consume(uint32_t len) {
+    if (len >= total_len_) {
+        clear();
+        return;
+    }
+    size_t drop = 0;
+    while (len > 0) {
+        segment& seg = segments_[drop];
+        if (len < seg.length) {
+            seg.offset += len;
+            seg.length -= len;
+            total_len_ -= len;
+            break;
+        }
+        len -= seg.length;
+        total_len_ -= seg.length;
+        seg.unit->release();
+        ++drop;
+    }
+    segments_.erase(segments_.begin(), segments_.begin() + drop);
+}
+
+bool x_msg_t::insert(x_buf_pool_t& pool, uint32_t pos, const void* src, uint32_t len) {
+    if (X_UNLIKELY(!src || len == 0)) return true;
+    if (pos >= total_len_) return copy_in(pool, src, len);
+
+    size_t i = 0;
+    while (pos >= segments_[i].length) {
+        pos -= segments_[i].length;
+        ++i;
+    }
+    segment& seg = segments_[i];
+    x_buf_unit_t* u = seg.unit;
+    // 快路径：unit 只被本 segment 引用且尾部放得下，段内后移后写入
+    if (u->ref.load(std::memory_order_acquire) == 1 && seg.offset + seg.length + len <= u->capacity) {
+        uint8_t* at = u->data_ptr + seg.offset + pos;
+        memmove(at + len, at, seg.length - pos);
+        memcpy(at, src, len);
+        seg.length += len;
+        total_len_ += len;
+        return true;
+    }
+
+    x_buf_ptr new_ptr = pool.get();
+    if (X_UNLIKELY(!new_ptr)) return false;
+    if (X_UNLIKELY(len > new_ptr->capacity)) X_PANIC("INSERT_TOO_LARGE");
+    memcpy(new_ptr->data_ptr, src, len);
+    new_ptr->add_ref();
+    segment inserted{new_ptr.get(), 0, len};
+    if (pos == 0) {
+        segments_.insert(segments_.begin() + i, inserted);
+    } else {
+        segment tail{u, seg.offset + pos, seg.length - pos};
+        u->add_ref();
+        seg.length = pos;
+        segments_.insert(segments_.begin() + i + 1, {inserted, tail});
+    }
+    total_len_ += len;
+    return true;
+}
+
 /**
  * copy_out: 导出数据到连续缓冲区
  */
@@ -282,4 +379,19 @@ size_t x_msg_t::get_iovec(struct iovec* iov, size_t max_iov) const {
         iov[i].iov_len  = segments_[i].length;
     }
     return count;
-}
\ No newline at end of file
+}
+size_t x_msg_t::get_iovec(struct iovec* iov, size_t max_iov, uint32_t skip) const {
+    size_t count = 0;
+    for (size_t i = 0; i < segments_.size() && count < max_iov; ++i) {
+        const segment& seg = segments_[i];
+        if (skip >= seg.length) {
+            skip -= seg.length;
+            continue;
+        }
+        iov[count].iov_base = seg.unit->data_ptr + seg.offset + skip;
+        iov[count].iov_len  = seg.length - skip;
+        skip = 0;
+        ++count;
+    }
+    return count;
+}
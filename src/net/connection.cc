@@ -1,101 +1,161 @@
 #include "net/connection.h"
+#include "net/conn_handler.h"
 #include "msg/msg_buffer4.h"
+#include <poll.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <unistd.h>
-#include <cstring>
-#include <vector>
 #include <algorithm>
-#include <strings.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 
 namespace net {
 
-static const size_t kMaxHeader = 65536;
-// 限制 body 大小，防止 Content-Length 导致 OOM
-static const int64_t kMaxContentLength = 1024 * 1024 * 1024 ;  // 1024MB
+static const uint32_t kRecvMinRoom = 16384;  // 尾部 unit 余量少于此值时再挂一个新 unit，一次 readv 收得更多
+static const size_t kMaxIov = 64;
+static const int kIdleSliceMs = 50;  // 空闲等待时检查 yield_idle 的间隔
 
+int recv_into(int fd, x_msg_t& msg, x_buf_pool_t& pool) {
+    // 直接收进 msg 尾部 unit 的剩余空间（不足时连同一个新 unit），不经中转缓冲
+    struct iovec iov[2];
+    int cnt = 0;
+    uint32_t room = msg.tail_space(iov[0]);
+    if (room > 0) ++cnt;
+    x_buf_ptr spare;
+    if (room < kRecvMinRoom) {
+        spare = pool.get();
+        if (spare) {
+            iov[cnt].iov_base = spare->data_ptr;
+            iov[cnt].iov_len = spare->capacity;
+            ++cnt;
+        } else if (cnt == 0) {
+            return -1;  // 池耗尽
+        }
+    }
+    ssize_t n;
+    do {
+        n = readv(fd, iov, cnt);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return static_cast<int>(n);
+    uint32_t in_tail = std::min(static_cast<uint32_t>(n), room);
+    msg.commit(in_tail);
+    if (static_cast<uint32_t>(n) > in_tail)
+        msg.append_unit(spare.get(), 0, static_cast<uint32_t>(n) - in_tail);
+    return static_cast<int>(n);
+}
 
-int read_request(int fd, x_msg_t& msg, x_buf_pool_t& pool, int64_t& content_length_out) {
-    msg.clear();
-    content_length_out = -1;
-    std::vector<char> buf(4096);
-    size_t total = 0;
-    bool found_end = false;
-    while (total < kMaxHeader) {
-        ssize_t n = recv(fd, buf.data(), buf.size(), 0);
-        if (n <= 0) return static_cast<int>(n);
-        if (!msg.copy_in(pool, buf.data(), static_cast<uint32_t>(n)))
+int write_response(int fd, const x_msg_t& msg, int flags) {
+    uint32_t total = msg.total_length();
+    uint32_t sent = 0;
+    while (sent < total) {
+        struct iovec iov[kMaxIov];
+        size_t n = msg.get_iovec(iov, kMaxIov, sent);
+        if (n == 0) break;
+        struct msghdr mh;
+        std::memset(&mh, 0, sizeof(mh));
+        mh.msg_iov = iov;
+        mh.msg_iovlen = n;
+        // MSG_NOSIGNAL：对端已关闭时返回 EPIPE 而不是触发 SIGPIPE
+        ssize_t w = sendmsg(fd, &mh, MSG_NOSIGNAL | flags);
+        if (w < 0) {
+            if (errno == EINTR) continue;
             return -1;
-        total += static_cast<size_t>(n);
-        // 查找 \r\n\r\n
-        uint32_t len = msg.total_length();
-        std::vector<char> linear(len + 1);
-        msg.copy_out(linear.data(), len);
-        linear[len] = '\0';
-        const char* end = std::strstr(linear.data(), "\r\n\r\n");
-        if (end) {
-            found_end = true;
-            break;
         }
-        if (n < static_cast<ssize_t>(buf.size())) break;
+        sent += static_cast<uint32_t>(w);
     }
-    if (!found_end) return total > 0 ? static_cast<int>(total) : -1;
-    // 解析 Content-Length
-    uint32_t len = msg.total_length();
-    std::vector<char> linear(len + 1);
-    msg.copy_out(linear.data(), len);
-    linear[len] = '\0';
-    const char* p = std::strstr(linear.data(), "\r\n\r\n");
-    size_t header_len = p ? (p + 4 - linear.data()) : len;
-    int64_t cl = -1;
-    const char* cl_key = "Content-Length:";
-    size_t cl_len = 15;
-    p = linear.data();
-    while (p + cl_len <= linear.data() + len) {
-        if (strncasecmp(p, cl_key, cl_len) == 0) {
-            p += cl_len;
-            while (p < linear.data() + len && (*p == ' ' || *p == '\t')) ++p;
-            int64_t v = 0;
-            while (p < linear.data() + len && *p >= '0' && *p <= '9')
-                v = v * 10 + (*p++ - '0');
-            cl = v;
-            break;
+    return static_cast<int>(sent);
+}
+
+bool send_file(int fd, int file_fd, uint64_t offset, uint64_t length) {
+    off_t off = static_cast<off_t>(offset);
+    while (length > 0) {
+        // 单次 sendfile 上限约 2GB，分段发送
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(length, 1u << 30));
+        ssize_t n = sendfile(fd, file_fd, &off, chunk);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
         }
-        p = std::strchr(p, '\n');
-        if (!p) break;
-        ++p;
-    }
-    // 无 Content-Length 时视为无 body（如 GET）；仅当存在且非法或过大时拒绝
-    if (cl >= 0 && cl > kMaxContentLength) {
-        content_length_out = -1;
-        return -1;  // Content-Length 过大，拒绝请求
+        if (n == 0) return false;  // 文件比预期短
+        length -= static_cast<uint64_t>(n);
     }
-    content_length_out = (cl >= 0) ? cl : 0;
-    if (cl > 0 && total < header_len + static_cast<size_t>(cl)) {
-        size_t need = header_len + static_cast<size_t>(cl) - total;
-        while (need > 0) {
-            size_t to_read = std::min(need, buf.size());
-            ssize_t n = recv(fd, buf.data(), to_read, 0);
-            if (n <= 0) return static_cast<int>(n);
-            if (!msg.copy_in(pool, buf.data(), static_cast<uint32_t>(n)))
-                return -1;
-            total += static_cast<size_t>(n);
-            need -= static_cast<size_t>(n);
+    return true;
+}
+
+// 等待空闲连接上的下一个请求：可读返回 true，超时/被让出/出错返回 false
+static bool wait_next_request(int fd, int idle_timeout_ms, const std::function<bool()>& yield_idle) {
+    int waited = 0;
+    for (;;) {
+        int slice = kIdleSliceMs;
+        if (idle_timeout_ms >= 0) {
+            if (waited >= idle_timeout_ms) return false;
+            slice = std::min(slice, idle_timeout_ms - waited);
         }
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int r = poll(&pfd, 1, slice);
+        if (r > 0) return true;
+        if (r < 0 && errno != EINTR) return false;
+        waited += slice;
+        if (yield_idle && yield_idle()) return false;
+    }
+}
+
+// 等待请求进行中（或第一个请求）的数据：可读返回 true，timeout_ms 内无数据或出错返回 false；timeout_ms < 0 不限
+static bool wait_request_data(int fd, int timeout_ms) {
+    if (timeout_ms < 0) return true;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() < 0) return false;
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int r = poll(&pfd, 1, static_cast<int>(left.count()));
+        if (r > 0) return true;
+        if (r == 0 || errno != EINTR) return false;
     }
-    return static_cast<int>(total);
 }
 
-int write_response(int fd, const x_msg_t& msg) {
-    struct iovec iov[64];
-    size_t n = msg.get_iovec(iov, 64);
-    if (n == 0) return 0;
-    ssize_t w = writev(fd, iov, static_cast<int>(n));
-    return static_cast<int>(w);
+void serve_connection(int fd, ConnHandler& handler, x_buf_pool_t& pool, int idle_timeout_ms, int request_timeout_ms,
+                      const std::function<bool()>& yield_idle) {
+    IoAction action = IoAction::Recv;
+    // 空闲超时与让出只用于两次请求之间：新连接上的第一个请求不受 keep-alive 空闲超时约束（超时为 0 时也不例外），
+    // 关闭 keep-alive 由 handler 在第一个响应中带 Connection: close 完成
+    bool served = false;
+    while (action != IoAction::Close) {
+        if (action == IoAction::Recv) {
+            if (served && handler.idle()) {
+                if (!wait_next_request(fd, idle_timeout_ms, yield_idle)) break;
+            } else if (!wait_request_data(fd, request_timeout_ms)) {
+                break;  // 半个请求头或慢速 body：不让少数连接长期占住工作线程
+            }
+            if (recv_into(fd, handler.input(), pool) <= 0) break;
+            action = handler.on_input();
+        } else if (action == IoAction::Work) {
+            action = handler.work();  // 本线程即可阻塞
+        } else if (action == IoAction::SendFile) {
+            const FileSegment& seg = handler.file_segment();
+            if (write_response(fd, handler.output(), MSG_MORE) < 0) break;
+            if (!send_file(fd, seg.fd, seg.offset, seg.length)) break;
+            served = true;
+            action = handler.on_sent();
+        } else {
+            if (write_response(fd, handler.output()) < 0) break;
+            served = true;
+            action = handler.on_sent();
+        }
+    }
+    close_fd(fd);
 }
 
 void close_fd(int fd) {
     if (fd >= 0) close(fd);
 }
 
-} 
+}
@@ -1,6 +1,9 @@
 #include "net/listener.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
@@ -8,7 +11,7 @@
 
 namespace net {
 
-int listen_tcp(const std::string& addr, uint16_t port) {
+int listen_tcp(const std::string& addr, uint16_t port, const ListenOptions& opts) {
     int fd = socket(AF_INET, SOCK_STREAM, 0);
     if (fd < 0) return -1;
     int on = 1;
@@ -16,6 +19,14 @@ int listen_tcp(const std::string& addr, uint16_t port) {
         close(fd);
         return -1;
     }
+    if (opts.reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (opts.defer_accept_secs > 0) {
+        int secs = opts.defer_accept_secs;
+        setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &secs, sizeof(secs));  // 不支持时忽略
+    }
     struct sockaddr_in sa;
     std::memset(&sa, 0, sizeof(sa));
     sa.sin_family = AF_INET;
@@ -34,7 +45,7 @@ int listen_tcp(const std::string& addr, uint16_t port) {
         close(fd);
         return -1;
     }
-    if (::listen(fd, 128) < 0) {
+    if (::listen(fd, opts.backlog > 0 ? opts.backlog : 128) < 0) {
         close(fd);
         return -1;
     }
@@ -47,4 +58,13 @@ int accept_one(int listen_fd) {
     return accept(listen_fd, reinterpret_cast<struct sockaddr*>(&peer), &len);
 }
 
-} 
+bool pin_current_thread(int cpu) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpu < 0 || ncpu <= 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(cpu % ncpu), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+}
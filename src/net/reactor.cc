@@ -0,0 +1,706 @@
+#include "net/reactor.h"
+#include "net/conn_handler.h"
+#include "msg/msg_buffer4.h"
+
+#include <liburing.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+namespace {
+
+constexpr unsigned kRingEntries = 256;
+constexpr uint32_t kMaxRecvBufs = 32768;    // provided buffer ring 的内核上限
+constexpr uint32_t kRecvCopyMax = 4096;     // 不超过此长度且连接输入尾部放得下的 recv 拷贝后归还 unit，避免涓流发送每次占一个 unit
+constexpr unsigned short kRecvBufGroup = 0;
+constexpr size_t kMaxIov = 64;
+constexpr long long kWaitTimeoutNs = 200 * 1000 * 1000;  // 轮询 stop 的间隔
+constexpr auto kIdleSweepInterval = std::chrono::milliseconds(200);
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kPipeSize = 1 << 20;     // 零拷贝发送用的管道容量（F_SETPIPE_SZ，失败则用系统默认）
+
+// user_data = Conn 指针 | 操作类型（Conn 至少 8 字节对齐，低 3 位空闲）；取消请求的 user_data 为 0，其 CQE 忽略
+enum OpTag : uint64_t { kOpAccept = 1, kOpRecv = 2, kOpSend = 3, kOpSpliceIn = 4, kOpSpliceOut = 5, kOpWake = 6 };
+constexpr uint64_t kTagMask = 7;
+
+struct Conn {
+    int fd{-1};
+    std::unique_ptr<ConnHandler> handler;
+    IoAction want{IoAction::Recv};
+    size_t worker{0};          // 执行本连接 work() 的工作线程
+    bool worked{false};        // 调用过 work()：handler 须在该工作线程上析构
+    bool recv_armed{false};
+    bool recv_cancelling{false};  // 已提交对 multishot recv 的取消，等其最终 CQE
+    x_msg_t stash;             // 不在 Recv 状态时（处理中、发送中）收到的数据，回到 Recv 时交给 handler
+    bool peer_closed{false};   // 已读到 EOF；正在发送的响应发完后关闭
+    bool closing{false};
+    bool served{false};        // 已发完至少一个响应；keep-alive 空闲超时只对此后的空闲连接生效
+    int inflight{0};           // 已提交、尚未收到最终 CQE 的操作数
+    uint32_t sent{0};          // output() 已发送字节数
+    Clock::time_point last_active;  // 最近一次收到数据或发完响应的时间，用于空闲超时与请求读超时
+    // SendFile：文件 →(splice)→ 管道 →(splice)→ socket，管道按需创建并在连接上复用
+    int pipe_r{-1};
+    int pipe_w{-1};
+    uint32_t pipe_cap{0};
+    uint32_t pipe_bytes{0};    // 已进管道、尚未送入 socket 的字节数
+    FileSegment file;          // 剩余待发送的文件区间
+    struct iovec iov[kMaxIov];
+    struct msghdr mh;
+};
+static_assert(alignof(Conn) >= 8, "Conn pointer low bits carry the op tag");
+
+// 执行 ConnHandler::work() 的线程。任务按连接固定到某个线程（文件读写用线程本地的 io_uring，
+// FileWriter / FileReader 的在途操作只能在发起它的线程上回收），handler 的析构也排到这里。
+struct WorkThread {
+    struct Task {
+        Conn* conn{nullptr};                   // 非空：执行 conn->handler->work()（reset 时改为析构它）
+        std::unique_ptr<ConnHandler> dispose;  // 非空：析构该 handler（连接已释放）
+        bool reset{false};
+    };
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Task> tasks;
+    bool stop{false};
+};
+
+class EventLoop {
+public:
+    EventLoop(int listen_fd, x_buf_pool_t& pool, const HandlerFactory& factory, int idle_timeout_ms,
+              int request_timeout_ms, uint32_t recv_buffers, uint32_t work_threads);
+    ~EventLoop();
+
+    bool init();
+    void run(const std::atomic<bool>& stop);
+
+private:
+    int listen_fd_;
+    x_buf_pool_t& pool_;
+    const HandlerFactory& factory_;
+    std::chrono::milliseconds idle_timeout_;
+    std::chrono::milliseconds request_timeout_;
+    Clock::time_point last_sweep_;
+
+    struct io_uring ring_;
+    bool ring_inited_{false};
+    struct io_uring_buf_ring* buf_ring_{nullptr};
+    size_t buf_ring_bytes_{0};
+    uint32_t recv_buf_count_{1};
+    std::vector<x_buf_ptr> recv_units_;          // 按 bid 索引：借给内核的 pool unit
+    std::vector<unsigned short> missing_bids_;   // 池耗尽时暂未补回 ring 的 bid
+    bool recv_starved_{false};                   // 有连接因 ring 无缓冲而停收，补回缓冲后重新挂 recv
+    bool accept_armed_{false};
+    std::unordered_set<Conn*> conns_;
+
+    // 阻塞工作交给工作线程，完成的 (连接, 下一步) 放进 done_ 后写 eventfd，事件循环上的 read 完成即取回
+    uint32_t work_thread_count_;
+    std::vector<std::unique_ptr<WorkThread>> workers_;
+    size_t next_worker_{0};
+    int wake_fd_{-1};
+    uint64_t wake_buf_{0};
+    bool wake_armed_{false};
+    std::mutex done_mutex_;
+    std::vector<std::pair<Conn*, IoAction>> done_;
+
+    struct io_uring_sqe* get_sqe();
+    void arm_accept();
+    void arm_recv(Conn* c);
+    void stop_recv(Conn* c);
+    void arm_wake();
+    void post_work(size_t worker, WorkThread::Task task);
+    void work_main(WorkThread& w);
+    void stop_workers();
+    void submit_send(Conn* c);
+    void output_sent(Conn* c);
+    bool open_pipe(Conn* c);
+    void submit_splice_in(Conn* c);
+    void submit_splice_out(Conn* c);
+    void provide_buffer(unsigned short bid);
+    void refill_buffers(Conn* current = nullptr);
+
+    void on_accept(const struct io_uring_cqe* cqe);
+    void on_recv(Conn* c, const struct io_uring_cqe* cqe);
+    void on_send(Conn* c, const struct io_uring_cqe* cqe);
+    void on_splice_in(Conn* c, const struct io_uring_cqe* cqe);
+    void on_splice_out(Conn* c, const struct io_uring_cqe* cqe);
+    void on_wake(const struct io_uring_cqe* cqe);
+    void dispatch(Conn* c, IoAction action);
+    void begin_close(Conn* c);
+    void release_if_done(Conn* c);
+    void sweep_idle();
+};
+
+EventLoop::~EventLoop() {
+    // 先让工作线程做完手上的 work() 并析构用过它的 handler（排在同一连接的 work 之后），再关闭连接
+    for (Conn* c : conns_) {
+        if (c->worked) post_work(c->worker, WorkThread::Task{c, nullptr, true});
+    }
+    stop_workers();
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    for (Conn* c : conns_) {
+        ::close(c->fd);
+        if (c->pipe_r >= 0) ::close(c->pipe_r);
+        if (c->pipe_w >= 0) ::close(c->pipe_w);
+        delete c;
+    }
+    if (ring_inited_) io_uring_queue_exit(&ring_);
+    if (buf_ring_) munmap(buf_ring_, buf_ring_bytes_);
+}
+
+EventLoop::EventLoop(int listen_fd, x_buf_pool_t& pool, const HandlerFactory& factory, int idle_timeout_ms,
+                     int request_timeout_ms, uint32_t recv_buffers, uint32_t work_threads)
+    : listen_fd_(listen_fd), pool_(pool), factory_(factory), idle_timeout_(idle_timeout_ms),
+      request_timeout_(request_timeout_ms), work_thread_count_(std::max<uint32_t>(work_threads, 1)) {
+    // ring 项数须为 2 的幂：向下取整
+    uint32_t limit = std::min(std::max<uint32_t>(recv_buffers, 1), kMaxRecvBufs);
+    while (recv_buf_count_ * 2 <= limit) recv_buf_count_ *= 2;
+}
+
+bool EventLoop::init() {
+    int ret = io_uring_queue_init(kRingEntries, &ring_, 0);
+    if (ret < 0) {
+        std::cerr << "reactor: io_uring_queue_init failed: " << strerror(-ret) << std::endl;
+        return false;
+    }
+    ring_inited_ = true;
+
+    // provided buffer ring：内核在 recv 完成时从中挑选缓冲，multishot recv 依赖它。
+    // 缓冲就是 pool unit，收到数据的 unit 直接交给连接（不再拷贝），空出的 bid 换一个新 unit 补回。
+    buf_ring_bytes_ = sizeof(struct io_uring_buf) * recv_buf_count_;
+    void* mem = mmap(nullptr, buf_ring_bytes_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (mem == MAP_FAILED) {
+        buf_ring_ = nullptr;
+        return false;
+    }
+    buf_ring_ = static_cast<struct io_uring_buf_ring*>(mem);
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = recv_buf_count_;
+    reg.bgid = kRecvBufGroup;
+    ret = io_uring_register_buf_ring(&ring_, &reg, 0);
+    if (ret < 0) {
+        std::cerr << "reactor: register buf ring failed: " << strerror(-ret) << std::endl;
+        return false;
+    }
+    io_uring_buf_ring_init(buf_ring_);
+    recv_units_.resize(recv_buf_count_);
+    for (uint32_t i = 0; i < recv_buf_count_; ++i) {
+        recv_units_[i] = pool_.get();
+        if (recv_units_[i]) provide_buffer(static_cast<unsigned short>(i));
+        else missing_bids_.push_back(static_cast<unsigned short>(i));
+    }
+
+    wake_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        std::cerr << "reactor: eventfd failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    for (uint32_t i = 0; i < work_thread_count_; ++i) {
+        workers_.emplace_back(new WorkThread);
+        WorkThread* w = workers_.back().get();
+        w->thread = std::thread([this, w]() { work_main(*w); });
+    }
+    return true;
+}
+
+void EventLoop::work_main(WorkThread& w) {
+    for (;;) {
+        WorkThread::Task task;
+        {
+            std::unique_lock<std::mutex> lock(w.mutex);
+            w.cv.wait(lock, [&w] { return !w.tasks.empty() || w.stop; });
+            if (w.tasks.empty()) return;  // stop 且队列已空
+            task = std::move(w.tasks.front());
+            w.tasks.pop_front();
+        }
+        if (task.dispose || task.reset) {
+            if (task.reset) task.conn->handler.reset();
+            task.dispose.reset();
+            continue;
+        }
+        IoAction next;
+        do {
+            next = task.conn->handler->work();
+        } while (next == IoAction::Work);
+        {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            done_.emplace_back(task.conn, next);
+        }
+        uint64_t one = 1;
+        ssize_t n;
+        do {
+            n = ::write(wake_fd_, &one, sizeof(one));
+        } while (n < 0 && errno == EINTR);
+    }
+}
+
+void EventLoop::post_work(size_t worker, WorkThread::Task task) {
+    WorkThread& w = *workers_[worker];
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.tasks.push_back(std::move(task));
+    }
+    w.cv.notify_one();
+}
+
+void EventLoop::stop_workers() {
+    for (auto& w : workers_) {
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->stop = true;
+        }
+        w->cv.notify_one();
+    }
+    for (auto& w : workers_) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+    workers_.clear();
+}
+
+struct io_uring_sqe* EventLoop::get_sqe() {
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+    if (!sqe) {
+        // SQ 已满：先提交再取
+        io_uring_submit(&ring_);
+        sqe = io_uring_get_sqe(&ring_);
+    }
+    return sqe;
+}
+
+void EventLoop::arm_accept() {
+    struct io_uring_sqe* sqe = get_sqe();
+    if (!sqe) return;
+    io_uring_prep_multishot_accept(sqe, listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    io_uring_sqe_set_data64(sqe, kOpAccept);
+    accept_armed_ = true;
+}
+
+void EventLoop::arm_recv(Conn* c) {
+    struct io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        begin_close(c);
+        return;
+    }
+    io_uring_prep_recv_multishot(sqe, c->fd, nullptr, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kRecvBufGroup;
+    io_uring_sqe_set_data64(sqe, reinterpret_cast<uint64_t>(c) | kOpRecv);
+    c->recv_armed = true;
+    ++c->inflight;
+}
+
+// 离开 Recv 状态（处理或发送响应期间）时取消 multishot recv，不再无限制地收后续数据；
+// 取消生效前已收到的数据暂存在 stash 中，回到 Recv 时重新挂上
+void EventLoop::stop_recv(Conn* c) {
+    if (!c->recv_armed || c->recv_cancelling) return;
+    struct io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        begin_close(c);
+        return;
+    }
+    io_uring_prep_cancel64(sqe, reinterpret_cast<uint64_t>(c) | kOpRecv, 0);
+    io_uring_sqe_set_data64(sqe, 0);
+    c->recv_cancelling = true;
+}
+
+void EventLoop::arm_wake() {
+    struct io_uring_sqe* sqe = get_sqe();
+    if (!sqe) return;
+    io_uring_prep_read(sqe, wake_fd_, &wake_buf_, sizeof(wake_buf_), 0);
+    io_uring_sqe_set_data64(sqe, kOpWake);
+    wake_armed_ = true;
+}
+
+void EventLoop::submit_send(Conn* c) {
+    size_t n = c->handler->output().get_iovec(c->iov, kMaxIov, c->sent);
+    if (n == 0) {
+        output_sent(c);
+        return;
+    }
+    struct io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        begin_close(c);
+        return;
+    }
+    std::memset(&c->mh, 0, sizeof(c->mh));
+    c->mh.msg_iov = c->iov;
+    c->mh.msg_iovlen = n;
+    // 后面紧跟文件内容时加 MSG_MORE，让响应头与 body 合包
+    io_uring_prep_sendmsg(sqe, c->fd, &c->mh, MSG_NOSIGNAL | (c->want == IoAction::SendFile ? MSG_MORE : 0));
+    io_uring_sqe_set_data64(sqe, reinterpret_cast<uint64_t>(c) | kOpSend);
+    ++c->inflight;
+}
+
+// output() 已全部发出：普通响应直接回调 on_sent，SendFile 开始搬运文件区间
+void EventLoop::output_sent(Conn* c) {
+    if (c->want != IoAction::SendFile) {
+        c->last_active = Clock::now();
+        c->served = true;
+        dispatch(c, c->handler->on_sent());
+        return;
+    }
+    c->file = c->handler->file_segment();
+    c->pipe_bytes = 0;
+    if (c->file.length == 0) {
+        c->want = IoAction::Send;
+        output_sent(c);
+        return;
+    }
+    if (!open_pipe(c)) {
+        begin_close(c);
+        return;
+    }
+    submit_splice_in(c);
+}
+
+bool EventLoop::open_pipe(Conn* c) {
+    if (c->pipe_r >= 0) return true;
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return false;
+    c->pipe_r = fds[0];
+    c->pipe_w = fds[1];
+    int cap = fcntl(c->pipe_w, F_SETPIPE_SZ, kPipeSize);
+    if (cap <= 0) cap = fcntl(c->pipe_w, F_GETPIPE_SZ);
+    c->pipe_cap = cap > 0 ? static_cast<uint32_t>(cap) : 65536;
+    return true;
+}
+
+void EventLoop::submit_splice_in(Conn* c) {
+    struct io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        begin_close(c);
+        return;
+    }
+    unsigned n = static_cast<unsigned>(std::min<uint64_t>(c->file.length, c->pipe_cap));
+    io_uring_prep_splice(sqe, c->file.fd, static_cast<int64_t>(c->file.offset), c->pipe_w, -1, n, SPLICE_F_MOVE);
+    io_uring_sqe_set_data64(sqe, reinterpret_cast<uint64_t>(c) | kOpSpliceIn);
+    ++c->inflight;
+}
+
+void EventLoop::submit_splice_out(Conn* c) {
+    struct io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        begin_close(c);
+        return;
+    }
+    io_uring_prep_splice(sqe, c->pipe_r, -1, c->fd, -1, c->pipe_bytes, SPLICE_F_MOVE);
+    io_uring_sqe_set_data64(sqe, reinterpret_cast<uint64_t>(c) | kOpSpliceOut);
+    ++c->inflight;
+}
+
+void EventLoop::provide_buffer(unsigned short bid) {
+    x_buf_unit_t* unit = recv_units_[bid].get();
+    io_uring_buf_ring_add(buf_ring_, unit->data_ptr, unit->capacity, bid,
+                          io_uring_buf_ring_mask(recv_buf_count_), 0);
+    io_uring_buf_ring_advance(buf_ring_, 1);
+}
+
+// 为池耗尽时空出的 bid 补 unit；补上后让因无缓冲而停收的连接重新挂 recv。
+// current 是调用方正在处理的连接：由调用方自己重挂，这里不碰它（挂失败时会被释放，调用方随后还要访问它）
+void EventLoop::refill_buffers(Conn* current) {
+    bool provided = false;
+    while (!missing_bids_.empty()) {
+        x_buf_ptr unit = pool_.get();
+        if (!unit) break;
+        unsigned short bid = missing_bids_.back();
+        missing_bids_.pop_back();
+        recv_units_[bid] = std::move(unit);
+        provide_buffer(bid);
+        provided = true;
+    }
+    if (!provided || !recv_starved_) return;
+    recv_starved_ = false;
+    std::vector<Conn*> rearm;
+    for (Conn* c : conns_) {
+        if (c != current && !c->closing && !c->peer_closed && !c->recv_armed && c->want == IoAction::Recv)
+            rearm.push_back(c);
+    }
+    for (Conn* c : rearm) {
+        arm_recv(c);
+        release_if_done(c);  // 挂不上 recv 时已 begin_close，且没有在途操作
+    }
+}
+
+void EventLoop::on_accept(const struct io_uring_cqe* cqe) {
+    if (!(cqe->flags & IORING_CQE_F_MORE)) accept_armed_ = false;
+    if (cqe->res < 0) {
+        if (cqe->res != -EINVAL && cqe->res != -ECANCELED)
+            std::cerr << "reactor: accept failed: " << strerror(-cqe->res) << std::endl;
+        return;
+    }
+    Conn* c = new Conn;
+    c->fd = cqe->res;
+    c->handler = factory_();
+    c->worker = next_worker_++ % workers_.size();
+    c->last_active = Clock::now();
+    conns_.insert(c);
+    arm_recv(c);
+    release_if_done(c);
+}
+
+void EventLoop::on_recv(Conn* c, const struct io_uring_cqe* cqe) {
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        c->recv_armed = false;
+        c->recv_cancelling = false;
+        --c->inflight;
+    }
+    int res = cqe->res;
+    if (res > 0) {
+        unsigned short bid = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        x_buf_ptr& unit = recv_units_[bid];
+        uint32_t n = static_cast<uint32_t>(res);
+        if (c->closing) {
+            provide_buffer(bid);
+        } else {
+            // 处理或发送期间 handler 可能正在工作线程上使用 input()：先放进 stash
+            x_msg_t& in = c->want == IoAction::Recv ? c->handler->input() : c->stash;
+            struct iovec tail;
+            if (n <= kRecvCopyMax && in.tail_space(tail) >= n) {
+                std::memcpy(tail.iov_base, unit->data_ptr, n);
+                in.commit(n);
+                provide_buffer(bid);
+            } else {
+                // unit 交给连接，ring 中的这个 bid 换一个新 unit
+                in.append_unit(unit.get(), 0, n);
+                unit = pool_.get();
+                if (unit) provide_buffer(bid);
+                else missing_bids_.push_back(bid);
+            }
+            c->last_active = Clock::now();
+            if (c->want == IoAction::Recv) dispatch(c, c->handler->on_input());
+        }
+    } else if (res == 0) {
+        // 对端关闭写方向：若仍在等请求则直接关闭，否则等当前响应发完
+        c->peer_closed = true;
+        if (c->want == IoAction::Recv) begin_close(c);
+    } else if (res == -ENOBUFS) {
+        // ring 暂时没有缓冲：若是池耗尽导致的（所有 bid 都待补），等 refill_buffers 补上后再挂
+        refill_buffers(c);
+        if (missing_bids_.size() == recv_buf_count_) {
+            recv_starved_ = true;
+            release_if_done(c);
+            return;
+        }
+    } else if (res != -ECANCELED) {  // ECANCELED：stop_recv 的取消生效
+        begin_close(c);
+    }
+    // multishot 终止（缓冲耗尽或内核主动结束）且仍需数据时重新挂上
+    if (!c->closing && !c->peer_closed && !c->recv_armed && c->want == IoAction::Recv)
+        arm_recv(c);
+    release_if_done(c);
+}
+
+void EventLoop::on_send(Conn* c, const struct io_uring_cqe* cqe) {
+    --c->inflight;
+    if (!c->closing) {
+        if (cqe->res < 0) {
+            begin_close(c);
+        } else {
+            c->sent += static_cast<uint32_t>(cqe->res);
+            if (c->sent < c->handler->output().total_length())
+                submit_send(c);
+            else
+                output_sent(c);
+        }
+    }
+    release_if_done(c);
+}
+
+void EventLoop::on_splice_in(Conn* c, const struct io_uring_cqe* cqe) {
+    --c->inflight;
+    if (!c->closing) {
+        if (cqe->res <= 0) {
+            begin_close(c);  // 出错，或文件比预期短（响应头已发出，只能断开）
+        } else {
+            uint32_t n = static_cast<uint32_t>(cqe->res);
+            c->file.offset += n;
+            c->file.length -= n;
+            c->pipe_bytes = n;
+            submit_splice_out(c);
+        }
+    }
+    release_if_done(c);
+}
+
+void EventLoop::on_splice_out(Conn* c, const struct io_uring_cqe* cqe) {
+    --c->inflight;
+    if (!c->closing) {
+        if (cqe->res <= 0) {
+            begin_close(c);
+        } else {
+            c->pipe_bytes -= static_cast<uint32_t>(cqe->res);
+            if (c->pipe_bytes > 0)
+                submit_splice_out(c);
+            else if (c->file.length > 0)
+                submit_splice_in(c);
+            else {
+                c->last_active = Clock::now();
+                c->served = true;
+                dispatch(c, c->handler->on_sent());
+            }
+        }
+    }
+    release_if_done(c);
+}
+
+void EventLoop::on_wake(const struct io_uring_cqe* cqe) {
+    (void)cqe;
+    wake_armed_ = false;
+    std::vector<std::pair<Conn*, IoAction>> done;
+    {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        done.swap(done_);
+    }
+    Clock::time_point now = Clock::now();
+    for (auto& d : done) {
+        Conn* c = d.first;
+        --c->inflight;
+        if (!c->closing) {
+            c->last_active = now;  // 请求读超时从处理完成时重新计
+            dispatch(c, d.second);
+        }
+        release_if_done(c);
+    }
+}
+
+void EventLoop::dispatch(Conn* c, IoAction action) {
+    c->want = action;
+    switch (action) {
+    case IoAction::Recv:
+        if (c->stash.total_length() > 0) {
+            // 处理期间已到达的数据（如流水线上的下一个请求、body 的后续部分）
+            x_msg_t& in = c->handler->input();
+            in.append_view(c->stash, 0, c->stash.total_length());
+            c->stash.clear();
+            dispatch(c, c->handler->on_input());
+        } else if (c->peer_closed) {
+            begin_close(c);
+        } else if (!c->recv_armed) {
+            arm_recv(c);
+        }
+        break;
+    case IoAction::Send:
+    case IoAction::SendFile:
+        stop_recv(c);
+        c->sent = 0;
+        submit_send(c);
+        break;
+    case IoAction::Work:
+        stop_recv(c);
+        if (c->closing) break;
+        c->worked = true;
+        ++c->inflight;
+        post_work(c->worker, WorkThread::Task{c, nullptr, false});
+        break;
+    case IoAction::Close:
+        begin_close(c);
+        break;
+    }
+}
+
+// shutdown 让仍挂着的 multishot recv 以 0 结束；所有操作的最终 CQE 到齐后在 release_if_done 中释放
+void EventLoop::begin_close(Conn* c) {
+    if (c->closing) return;
+    c->closing = true;
+    ::shutdown(c->fd, SHUT_RDWR);
+}
+
+void EventLoop::release_if_done(Conn* c) {
+    if (!c->closing || c->inflight > 0) return;
+    if (c->worked) post_work(c->worker, WorkThread::Task{nullptr, std::move(c->handler), false});
+    ::close(c->fd);
+    if (c->pipe_r >= 0) ::close(c->pipe_r);
+    if (c->pipe_w >= 0) ::close(c->pipe_w);
+    conns_.erase(c);
+    delete c;
+}
+
+// 关闭在两次请求之间空闲过久的 keep-alive 连接，以及第一个请求或收了一半的请求迟迟不来数据的连接
+void EventLoop::sweep_idle() {
+    Clock::time_point now = Clock::now();
+    if (now - last_sweep_ < kIdleSweepInterval) return;
+    last_sweep_ = now;
+    std::vector<Conn*> expired;
+    for (Conn* c : conns_) {
+        if (c->closing || c->want != IoAction::Recv) continue;
+        bool between = c->served && c->handler->idle();
+        std::chrono::milliseconds limit = between ? idle_timeout_ : request_timeout_;
+        if (limit.count() >= 0 && now - c->last_active >= limit) expired.push_back(c);
+    }
+    for (Conn* c : expired) {
+        begin_close(c);
+        release_if_done(c);  // 因缓冲不足未挂 recv 的连接没有在途操作，不会再有 CQE
+    }
+}
+
+void EventLoop::run(const std::atomic<bool>& stop) {
+    arm_accept();
+    last_sweep_ = Clock::now();
+    while (!stop.load(std::memory_order_relaxed)) {
+        sweep_idle();
+        if (!missing_bids_.empty()) refill_buffers();
+        if (!accept_armed_) arm_accept();
+        if (!wake_armed_) arm_wake();
+        io_uring_submit(&ring_);
+        struct __kernel_timespec ts;
+        ts.tv_sec = 0;
+        ts.tv_nsec = kWaitTimeoutNs;
+        struct io_uring_cqe* cqe = nullptr;
+        int ret = io_uring_wait_cqe_timeout(&ring_, &cqe, &ts);
+        if (ret == -ETIME || ret == -EINTR) continue;
+        if (ret < 0) {
+            std::cerr << "reactor: wait cqe failed: " << strerror(-ret) << std::endl;
+            break;
+        }
+        unsigned head;
+        unsigned count = 0;
+        io_uring_for_each_cqe(&ring_, head, cqe) {
+            ++count;
+            uint64_t data = io_uring_cqe_get_data64(cqe);
+            Conn* c = reinterpret_cast<Conn*>(data & ~kTagMask);
+            switch (data & kTagMask) {
+            case kOpAccept: on_accept(cqe); break;
+            case kOpRecv:   on_recv(c, cqe); break;
+            case kOpSend:   on_send(c, cqe); break;
+            case kOpSpliceIn:  on_splice_in(c, cqe); break;
+            case kOpSpliceOut: on_splice_out(c, cqe); break;
+            case kOpWake:      on_wake(cqe); break;
+            default: break;
+            }
+        }
+        io_uring_cq_advance(&ring_, count);
+    }
+}
+
+}
+
+bool run_event_loop(int listen_fd, x_buf_pool_t& pool, const HandlerFactory& factory, int idle_timeout_ms,
+                    int request_timeout_ms, uint32_t recv_buffers, uint32_t work_threads,
+                    const std::atomic<bool>& stop) {
+    EventLoop loop(listen_fd, pool, factory, idle_timeout_ms, request_timeout_ms, recv_buffers, work_threads);
+    if (!loop.init()) return false;
+    loop.run(stop);
+    return true;
+}
+
+}
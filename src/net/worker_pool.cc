@@ -0,0 +1,140 @@
+#include "net/worker_pool.h"
+#include "net/listener.h"
+#include "metrics/metrics.h"
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace net {
+
+namespace {
+
+metrics::Counter& m_workers = metrics::counter("pool.workers");
+metrics::Counter& m_workers_busy = metrics::counter("pool.workers_busy");
+metrics::Counter& m_busy_ns = metrics::counter("pool.busy_ns_total");
+metrics::Counter& m_queue_capacity = metrics::counter("pool.queue_capacity");
+metrics::Counter& m_queue_depth = metrics::counter("pool.queue_depth");
+metrics::Counter& m_queue_depth_max = metrics::counter("pool.queue_depth_max");
+metrics::Counter& m_queue_full = metrics::counter("pool.queue_full_waits");
+metrics::Counter& m_enqueued = metrics::counter("pool.enqueued");
+metrics::Counter& m_wait_ns_total = metrics::counter("pool.queue_wait_ns_total");
+metrics::Counter& m_wait_ns_max = metrics::counter("pool.queue_wait_ns_max");
+
+int64_t elapsed_ns(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+// 派生指标：平均排队时间、工作线程利用率（忙碌时间 / (线程数 × 运行时间)）
+void register_derived_gauges() {
+    metrics::gauge("pool.queue_wait_us_avg", []() -> int64_t {
+        int64_t n = m_enqueued.get();
+        return n > 0 ? m_wait_ns_total.get() / n / 1000 : 0;
+    });
+    metrics::gauge("pool.utilization_pct", []() -> int64_t {
+        int64_t capacity_ns = m_workers.get() * metrics::uptime_ms() * 1000000;
+        return capacity_ns > 0 ? m_busy_ns.get() * 100 / capacity_ns : 0;
+    });
+}
+
+}
+
+WorkerPool::WorkerPool(uint32_t workers, uint32_t queue_depth, ServeFn serve, int first_cpu, int cpu_count)
+    : serve_(std::move(serve)), first_cpu_(first_cpu), cpu_count_(cpu_count > 0 ? cpu_count : 1) {
+    if (workers == 0) workers = 1;
+    if (queue_depth == 0) queue_depth = 1;
+    queue_.resize(queue_depth);
+    active_fds_.assign(workers, -1);
+    register_derived_gauges();
+    m_workers.add(workers);
+    m_queue_capacity.add(queue_depth);
+    threads_.reserve(workers);
+    for (uint32_t i = 0; i < workers; ++i)
+        threads_.emplace_back(&WorkerPool::worker_main, this, static_cast<size_t>(i));
+}
+
+WorkerPool::~WorkerPool() {
+    stop(std::chrono::milliseconds(0));
+}
+
+bool WorkerPool::submit(int fd) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (count_ == queue_.size() && !stopping_) {
+        m_queue_full.add();
+        not_full_.wait(lock, [this] { return count_ < queue_.size() || stopping_; });
+    }
+    if (stopping_) return false;
+    queue_[(head_ + count_) % queue_.size()] = Item{fd, std::chrono::steady_clock::now()};
+    ++count_;
+    m_enqueued.add();
+    m_queue_depth.add();
+    m_queue_depth_max.update_max(static_cast<int64_t>(count_));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+}
+
+bool WorkerPool::reclaim_idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_ > 0 || stopping_;
+}
+
+void WorkerPool::worker_main(size_t index) {
+    if (first_cpu_ >= 0) pin_current_thread(first_cpu_ + static_cast<int>(index % static_cast<size_t>(cpu_count_)));
+    for (;;) {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this] { return count_ > 0 || stopping_; });
+            if (count_ == 0) return;  // stopping 且队列已空
+            item = queue_[head_];
+            head_ = (head_ + 1) % queue_.size();
+            --count_;
+            m_queue_depth.sub();
+            if (aborting_) {
+                ::close(item.fd);
+                continue;
+            }
+            active_fds_[index] = item.fd;
+            ++busy_;
+        }
+        not_full_.notify_one();
+
+        int64_t wait_ns = elapsed_ns(item.enqueued);
+        m_wait_ns_total.add(wait_ns);
+        m_wait_ns_max.update_max(wait_ns);
+
+        m_workers_busy.add();
+        auto start = std::chrono::steady_clock::now();
+        serve_(item.fd);
+        m_busy_ns.add(elapsed_ns(start));
+        m_workers_busy.sub();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_fds_[index] = -1;
+            --busy_;
+        }
+        idle_.notify_all();
+    }
+}
+
+void WorkerPool::stop(std::chrono::milliseconds grace) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (joined_) return;
+    stopping_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    bool drained = idle_.wait_for(lock, grace, [this] { return count_ == 0 && busy_ == 0; });
+    if (!drained) {
+        // 超时：丢弃排队连接，打断在途连接上阻塞的 recv/send
+        aborting_ = true;
+        for (int fd : active_fds_)
+            if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+    }
+    joined_ = true;
+    lock.unlock();
+    for (std::thread& t : threads_)
+        if (t.joinable()) t.join();
+    m_workers.sub(static_cast<int64_t>(threads_.size()));
+}
+
+}
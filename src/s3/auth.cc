@@ -41,17 +41,23 @@ bool verify_query_signature(const http::HttpRequest& req, const s3config::Config
     if (static_cast<int64_t>(std::time(nullptr)) > expires)
         return false;
     // StringToSign v2: Method + "\n" + Content-MD5 + "\n" + Content-Type + "\n" + Expires + "\n" + CanonicalizedAmzHeaders + CanonicalizedResource
-    std::string string_to_sign;
-    string_to_sign += req.method;
-    string_to_sign += '\n';
-    string_to_sign += req.content_md5;
-    string_to_sign += '\n';
-    string_to_sign += req.content_type;
-    string_to_sign += '\n';
-    string_to_sign += expires_str;
-    string_to_sign += '\n';
-    string_to_sign += req.path;
-    std::string expected_sig = hmac_sha1_base64(secret, string_to_sign);
+    auto sign = [&](std::string_view method) {
+        std::string string_to_sign;
+        string_to_sign += method;
+        string_to_sign += '\n';
+        string_to_sign += req.content_md5;
+        string_to_sign += '\n';
+        string_to_sign += req.content_type;
+        string_to_sign += '\n';
+        string_to_sign += expires_str;
+        string_to_sign += '\n';
+        string_to_sign += req.path;
+        return hmac_sha1_base64(secret, string_to_sign);
+    };
+    std::string expected_sig = sign(req.method);
+    // HEAD 与 GET 共用路由：为 GET 预签的 URL 也可用于 HEAD
+    if (expected_sig != sig_from_client && req.method == "HEAD" && sign("GET") == sig_from_client)
+        return true;
     std::cout << expected_sig << " " << sig_from_client << std::endl;
     if (expected_sig != sig_from_client) {
         std::cerr << "[S3 auth] Signature does not match. Server used this StringToSign (5 lines):\n"
@@ -0,0 +1,96 @@
+#include "s3/etag.h"
+#include "msg/msg_buffer4.h"
+#include <openssl/evp.h>
+#include <sys/uio.h>
+#include <cstdio>
+#include <ctime>
+
+namespace s3 {
+
+Md5Stream::Md5Stream() : ctx_(EVP_MD_CTX_new()) {
+    if (ctx_) EVP_DigestInit_ex(ctx_, EVP_md5(), nullptr);
+}
+
+Md5Stream::~Md5Stream() {
+    EVP_MD_CTX_free(ctx_);
+}
+
+void Md5Stream::update(const void* data, size_t len) {
+    if (ctx_ && len > 0) EVP_DigestUpdate(ctx_, data, len);
+}
+
+void Md5Stream::update(const x_msg_t& data) {
+    static const size_t kIov = 64;
+    struct iovec iov[kIov];
+    uint32_t done = 0;
+    while (done < data.total_length()) {
+        size_t n = data.get_iovec(iov, kIov, done);
+        if (n == 0) break;
+        for (size_t i = 0; i < n; ++i) {
+            update(iov[i].iov_base, iov[i].iov_len);
+            done += static_cast<uint32_t>(iov[i].iov_len);
+        }
+    }
+}
+
+void Md5Stream::final(unsigned char digest[kMd5Size]) {
+    unsigned int len = 0;
+    if (!ctx_ || EVP_DigestFinal_ex(ctx_, digest, &len) != 1) {
+        for (size_t i = 0; i < kMd5Size; ++i) digest[i] = 0;
+    }
+}
+
+std::string hex_digest(const unsigned char* digest, size_t len) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string s(len * 2, '0');
+    for (size_t i = 0; i < len; ++i) {
+        s[2 * i] = kHex[digest[i] >> 4];
+        s[2 * i + 1] = kHex[digest[i] & 0xf];
+    }
+    return s;
+}
+
+bool decode_content_md5(std::string_view b64, unsigned char digest[kMd5Size]) {
+    // 16 字节的 base64 固定为 24 个字符，以 == 结尾
+    if (b64.size() != 24 || b64[22] != '=' || b64[23] != '=') return false;
+    unsigned char buf[24];
+    int n = EVP_DecodeBlock(buf, reinterpret_cast<const unsigned char*>(b64.data()), 24);
+    if (n != 18) return false;
+    for (size_t i = 0; i < kMd5Size; ++i) digest[i] = buf[i];
+    return true;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string multipart_etag(const std::vector<std::string>& part_etags) {
+    Md5Stream md5;
+    for (const std::string& e : part_etags) {
+        if (e.size() != 2 * kMd5Size) return {};
+        unsigned char d[kMd5Size];
+        for (size_t i = 0; i < kMd5Size; ++i) {
+            int hi = hex_value(e[2 * i]), lo = hex_value(e[2 * i + 1]);
+            if (hi < 0 || lo < 0) return {};
+            d[i] = static_cast<unsigned char>((hi << 4) | lo);
+        }
+        md5.update(d, kMd5Size);
+    }
+    unsigned char digest[kMd5Size];
+    md5.final(digest);
+    return hex_digest(digest, kMd5Size) + "-" + std::to_string(part_etags.size());
+}
+
+std::string version_etag(int64_t size) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%llx%08lx-%llx", static_cast<unsigned long long>(ts.tv_sec),
+                  static_cast<unsigned long>(ts.tv_nsec), static_cast<unsigned long long>(size));
+    return buf;
+}
+
+}
@@ -1,12 +1,22 @@
 #include "s3/handler.h"
 #include "s3/response.h"
+#include "s3/etag.h"
+#include "s3/multipart.h"
 #include "config/config.h"
 #include "http/http_request.h"
+#include "http/chunked.h"
+#include "http/range.h"
 #include "msg/msg_buffer4.h"
 #include "io_uring/file_io.h"
 #include "meta/meta.h"
+#include "metrics/metrics.h"
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <unordered_set>
+#include <cstdlib>
 #include <cstring>
 #include <string>
 #include <ctime>
@@ -17,14 +27,32 @@
 
 namespace s3 {
 
-// URL 按操作前缀区分：/getBucket/、/getObject/、/deleteBucket/、/deleteObject/、/createBucket/、/createObject/
-enum class PathAction { None, GetBucket, GetObject, DeleteBucket, DeleteObject, CreateBucket, CreateObject };
+static metrics::Counter& m_upload_active = metrics::counter("upload.active");
+static metrics::Counter& m_upload_bytes = metrics::counter("upload.bytes_total");
+static metrics::Counter& m_upload_inflight_max = metrics::counter("upload.write_inflight_max");
+static metrics::Counter& m_download_bytes = metrics::counter("download.bytes_total");
+static metrics::Counter& m_range_requests = metrics::counter("download.range_requests");
+static metrics::Counter& m_not_modified = metrics::counter("download.not_modified");
+static metrics::Counter& m_head_requests = metrics::counter("download.head_requests");
+static metrics::Counter& m_bulk_deleted = metrics::counter("delete.bulk_objects");
+static metrics::Counter& m_list_pages = metrics::counter("list.pages");
+
+// 批量删除单次请求的 key 数上限
+static const size_t kMaxBulkDeleteKeys = 10000;
+static metrics::Counter& m_multipart_assembled = metrics::counter("multipart.assembled_bytes");
+
+// URL 按操作前缀区分：/getBucket/、/getObject/、/deleteBucket/、/deleteObject/、/deleteObjects/、/createBucket/、/createObject/，
+// 以及分片上传 /initiateMultipartUpload/、/uploadPart/、/completeMultipartUpload/、/abortMultipartUpload/、/listParts/
+enum class PathAction {
+    None, GetBucket, GetObject, DeleteBucket, DeleteObject, DeleteObjects, CreateBucket, CreateObject,
+    InitiateMultipart, UploadPart, CompleteMultipart, AbortMultipart, ListParts
+};
 
 // 解析路径前缀与后续 bucket_name、object_key。path 已规范化（如 /getBucket/my-bucket、/getObject/bucket/key）
-static PathAction parse_action_path(const std::string& path, std::string& bucket_name, std::string& object_key) {
+static PathAction parse_action_path(std::string_view path, std::string& bucket_name, std::string& object_key) {
     bucket_name.clear();
     object_key.clear();
-    std::string p = path;
+    std::string p(path);
     while (!p.empty() && p[0] == '/') p.erase(0, 1);
     if (p.empty()) return PathAction::None;
 
@@ -61,6 +89,14 @@ static PathAction parse_action_path(const std::string& path, std::string& bucket
         bucket_name = p;
         return PathAction::DeleteBucket;
     }
+    // deleteObjects 须在 deleteObject 之前匹配（前者以后者为前缀）
+    if (strip_prefix("deleteObjects")) {
+        if (p.empty()) return PathAction::None;
+        size_t pos = p.find('/');
+        if (pos != std::string::npos) return PathAction::None;  // 仅桶名，key 在 body 中
+        bucket_name = p;
+        return PathAction::DeleteObjects;
+    }
     if (strip_prefix("deleteObject")) {
         if (p.empty()) return PathAction::None;
         size_t pos = p.find('/');
@@ -84,6 +120,22 @@ static PathAction parse_action_path(const std::string& path, std::string& bucket
         object_key = p.substr(pos + 1);
         return PathAction::CreateObject;
     }
+    // 分片上传的各操作都作用于 bucket/key
+    static const struct { const char* prefix; PathAction action; } kMultipartActions[] = {
+        {"initiateMultipartUpload", PathAction::InitiateMultipart},
+        {"uploadPart", PathAction::UploadPart},
+        {"completeMultipartUpload", PathAction::CompleteMultipart},
+        {"abortMultipartUpload", PathAction::AbortMultipart},
+        {"listParts", PathAction::ListParts},
+    };
+    for (const auto& m : kMultipartActions) {
+        if (!strip_prefix(m.prefix)) continue;
+        size_t pos = p.find('/');
+        if (pos == std::string::npos) return PathAction::None;
+        bucket_name = p.substr(0, pos);
+        object_key = p.substr(pos + 1);
+        return m.action;
+    }
     return PathAction::None;
 }
 
@@ -143,6 +195,59 @@ static bool is_storage_path_safe(const std::string& storage_path, const std::str
     return true;
 }
 
+// path 所在目录（不含结尾 /）
+static std::string parent_dir(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos || slash == 0 ? std::string("/") : path.substr(0, slash);
+}
+
+// 逐级创建 path 所在的目录（已存在的忽略）；created 非空时记下本次新建的目录
+static void make_parent_dirs(const std::string& path, std::vector<std::string>* created = nullptr) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) return;
+    std::string dir = path.substr(0, slash);
+    for (size_t i = 1; i <= dir.size(); ++i) {
+        if (i == dir.size() || dir[i] == '/') {
+            std::string sub = dir.substr(0, i);
+            if (mkdir(sub.c_str(), 0755) == 0 && created) created->push_back(sub);
+        }
+    }
+}
+
+// 按 durability 让已 rename 到位的新文件在写元数据之前落盘：fdatasync 只同步文件数据；
+// full 用 fsync，并同步文件所在目录与本次新建目录的上级目录，崩溃后目录项也还在。经组提交与并发请求合并
+static bool sync_new_file(const s3config::Config& config, const std::string& path,
+                          const std::vector<std::string>& created_dirs) {
+    if (config.durability == "none") return true;
+    if (config.durability == "fdatasync") return uring::sync_paths({path}, true);
+    std::vector<std::string> paths{parent_dir(path)};
+    for (const std::string& d : created_dirs) paths.push_back(parent_dir(d));
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    paths.insert(paths.begin(), path);
+    return uring::sync_paths(paths, false);
+}
+
+// data_root/.uploads/ 下一个新的临时文件路径。先写临时文件再 rename，未完成的写不会以正式文件出现
+static std::string new_upload_tmp_path(const s3config::Config& config) {
+    std::string tmp_dir = config.data_root;
+    if (!tmp_dir.empty() && tmp_dir.back() != '/') tmp_dir += '/';
+    tmp_dir += ".uploads";
+    mkdir(tmp_dir.c_str(), 0755);
+    static std::atomic<uint64_t> seq{0};
+    return tmp_dir + "/" + std::to_string(static_cast<long long>(getpid())) + "-" +
+           std::to_string(static_cast<unsigned long long>(seq.fetch_add(1)));
+}
+
+static std::string now_iso8601() {
+    time_t now_t = time(nullptr);
+    struct tm tm_buf;
+    char buf[32];
+    if (gmtime_r(&now_t, &tm_buf)) strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm_buf);
+    else buf[0] = '\0';
+    return buf;
+}
+
 // 将字符串中 " \ 转义后追加到 s
 static void json_escape_append(std::string& s, const std::string& raw) {
     for (char c : raw) {
@@ -153,26 +258,147 @@ static void json_escape_append(std::string& s, const std::string& raw) {
     }
 }
 
+static void append_list_prefix(std::string& body, const std::string& bucket_name) {
+    body += "{\"code\":1,\"Name\":\"";
+    json_escape_append(body, bucket_name);
+    body += "\",\"Contents\":[";
+}
+
+static void append_list_entry(std::string& body, const meta::Object& o, bool first) {
+    if (!first) body += ",";
+    body += "{\"Key\":\"";
+    json_escape_append(body, o.key);
+    body += "\",\"Size\":";
+    body += std::to_string(static_cast<long long>(o.size));
+    body += ",\"LastModified\":\"";
+    json_escape_append(body, o.last_modified);
+    body += "\",\"ETag\":\"";
+    json_escape_append(body, o.etag);
+    body += "\"}";
+}
+
 static void write_list_json_from_meta(x_msg_t& out, x_buf_pool_t& pool,
                                       const std::string& bucket_name,
                                       const std::vector<meta::Object>& objects) {
     std::string body;
     body.reserve(256 + objects.size() * 128);
-    body += "{\"code\":1,\"Name\":\"";
-    json_escape_append(body, bucket_name);
-    body += "\",\"Contents\":[";
-    for (size_t i = 0; i < objects.size(); ++i) {
-        const meta::Object& o = objects[i];
+    append_list_prefix(body, bucket_name);
+    for (size_t i = 0; i < objects.size(); ++i) append_list_entry(body, objects[i], i == 0);
+    body += "]}";
+    write_success_response(out, pool, body.data(), body.size());
+}
+
+// 对象数超过该值的 getBucket 列表以 chunked 编码分批生成、边生成边发送
+static const size_t kListStreamMin = 1000;
+// 每个 chunk 的目标大小
+static const uint32_t kListChunkBytes = 64 * 1024;
+
+// 大列表的流式响应体：每次 next 只序列化够一个 chunk 的条目（至少一个），整个 JSON 不会同时驻留内存。
+// 对象按 key 顺序分页从 store 读取（每页 kListStreamMin 个，游标为上一页最后一个 key），当前页发完才取下一页，
+// 桶内对象也不会一次拷出。各页分别持锁读取：发送期间增删的对象是否出现在结果中，取决于其 key 是否已越过游标
+class ListBody : public BodySource {
+public:
+    ListBody(x_buf_pool_t& pool, const meta::MetaStore& store, int64_t bucket_id, const std::string& bucket_name,
+             meta::ListPage first)
+        : pool_(pool), store_(store), bucket_id_(bucket_id), page_(std::move(first)) {
+        append_list_prefix(buf_, bucket_name);
+    }
+
+    int64_t next(x_msg_t& out, uint32_t max_bytes) override {
+        if (done_) return 0;
+        uint32_t target = std::min(kListChunkBytes, max_bytes / 2);
+        do {
+            if (pos_ == page_.objects.size() && !fetch()) break;
+            append_list_entry(buf_, page_.objects[pos_], emitted_ == 0);
+            ++pos_;
+            ++emitted_;
+        } while (buf_.size() < target);
+        bool last = pos_ == page_.objects.size() && !page_.truncated;
+        if (last) buf_ += "]}";
+        uint32_t before = out.total_length();
+        if (!buf_.empty() && !http::append_chunk(out, pool_, buf_.data(), static_cast<uint32_t>(buf_.size()))) return -1;
+        buf_.clear();
+        if (last) {
+            if (!http::append_last_chunk(out, pool_)) return -1;
+            done_ = true;
+        }
+        return out.total_length() - before;
+    }
+
+private:
+    x_buf_pool_t& pool_;
+    const meta::MetaStore& store_;
+    int64_t bucket_id_;
+    meta::ListPage page_;
+    size_t pos_{0};       // page_.objects 中下一个要发送的
+    size_t emitted_{0};
+    std::string buf_;
+    bool done_{false};
+
+    // 当前页已发完时取下一页；没有更多对象时返回 false
+    bool fetch() {
+        if (!page_.truncated) return false;
+        std::string cursor = std::move(page_.next_marker);
+        page_ = meta::ListPage();
+        pos_ = 0;
+        store_.list_objects_page(bucket_id_, "", "", cursor, kListStreamMin, page_);
+        return !page_.objects.empty();
+    }
+};
+
+// 分页列表：max-keys 默认与上限
+static const size_t kListPageMaxKeys = 1000;
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// continuation-token 为上一页 next_marker 的十六进制编码（key 可含任意字节，编码后可直接放进 query）
+static bool decode_continuation_token(const std::string& token, std::string& marker) {
+    if (token.size() % 2 != 0) return false;
+    marker.clear();
+    marker.reserve(token.size() / 2);
+    for (size_t i = 0; i < token.size(); i += 2) {
+        int hi = hex_value(token[i]), lo = hex_value(token[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        marker += static_cast<char>(hi * 16 + lo);
+    }
+    return true;
+}
+
+static void write_list_page_json(x_msg_t& out, x_buf_pool_t& pool, const std::string& bucket_name,
+                                 const std::string& prefix, const std::string& delimiter,
+                                 size_t max_keys, const meta::ListPage& page) {
+    std::string body;
+    body.reserve(256 + page.objects.size() * 128 + page.common_prefixes.size() * 64);
+    append_list_prefix(body, bucket_name);
+    for (size_t i = 0; i < page.objects.size(); ++i) append_list_entry(body, page.objects[i], i == 0);
+    body += "],\"CommonPrefixes\":[";
+    for (size_t i = 0; i < page.common_prefixes.size(); ++i) {
         if (i) body += ",";
-        body += "{\"Key\":\"";
-        json_escape_append(body, o.key);
-        body += "\",\"Size\":";
-        body += std::to_string(static_cast<long long>(o.size));
-        body += ",\"LastModified\":\"";
-        json_escape_append(body, o.last_modified);
+        body += "{\"Prefix\":\"";
+        json_escape_append(body, page.common_prefixes[i]);
         body += "\"}";
     }
-    body += "]}";
+    body += "],\"Prefix\":\"";
+    json_escape_append(body, prefix);
+    body += "\",\"Delimiter\":\"";
+    json_escape_append(body, delimiter);
+    body += "\",\"MaxKeys\":";
+    body += std::to_string(max_keys);
+    body += ",\"KeyCount\":";
+    body += std::to_string(page.objects.size() + page.common_prefixes.size());
+    body += ",\"IsTruncated\":";
+    body += page.truncated ? "true" : "false";
+    if (page.truncated) {
+        body += ",\"NextContinuationToken\":\"";
+        body += hex_digest(reinterpret_cast<const unsigned char*>(page.next_marker.data()), page.next_marker.size());
+        body += "\"";
+    }
+    body += "}";
     write_success_response(out, pool, body.data(), body.size());
 }
 
@@ -195,26 +421,220 @@ static void write_list_buckets_json(x_msg_t& out, x_buf_pool_t& pool,
     write_success_response(out, pool, body.data(), body.size());
 }
 
+// 对象文件区间作为响应体：零拷贝时直接交出 fd；否则经 uring::FileReader 预读，读完的 unit 直接挂到待发送的 msg 上
+class FileBody : public BodySource {
+public:
+    FileBody(x_buf_pool_t& pool, uint32_t window) : pool_(pool), window_(window) {}
+    ~FileBody() override {
+        reader_.reset();  // 先等在途读完成再关 fd
+        if (fd_ >= 0) close(fd_);
+    }
+    bool open(const std::string& path, uint64_t offset, uint64_t length) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        offset_ = offset;
+        length_ = length;
+        return fd_ >= 0;
+    }
+    int64_t next(x_msg_t& out, uint32_t max_bytes) override {
+        if (!reader_) {
+            reader_.reset(new uring::FileReader(pool_, window_));
+            if (!reader_->open(fd_, offset_, length_)) return -1;
+        }
+        int64_t n = reader_->next(out, max_bytes);
+        if (n > 0) m_download_bytes.add(n);
+        return n;
+    }
+    bool file_range(int& fd, uint64_t& offset, uint64_t& length) override {
+        if (reader_) return false;  // 已开始经用户态发送
+        fd = fd_;
+        offset = offset_;
+        length = length_;
+        return true;
+    }
+
+private:
+    x_buf_pool_t& pool_;
+    uint32_t window_;
+    std::unique_ptr<uring::FileReader> reader_;
+    int fd_{-1};
+    uint64_t offset_{0};
+    uint64_t length_{0};
+};
+
+// 多区间 Range 的 multipart/byteranges 响应体：依次输出每段的分隔头与文件区间（FileReader 按区间预读），最后是结束分隔符。
+// 总长度在构造时算出，响应头可带准确的 Content-Length。
+class MultiRangeBody : public BodySource {
+public:
+    MultiRangeBody(x_buf_pool_t& pool, uint32_t window, std::vector<http::ByteRange> ranges, uint64_t size)
+        : pool_(pool), window_(window), ranges_(std::move(ranges)), size_(size) {
+        static std::atomic<uint64_t> seq{0};
+        uint64_t tag = (static_cast<uint64_t>(std::time(nullptr)) << 20) ^ seq.fetch_add(1, std::memory_order_relaxed);
+        std::snprintf(boundary_, sizeof(boundary_), "s3range%016llx", static_cast<unsigned long long>(tag));
+    }
+    ~MultiRangeBody() override {
+        reader_.reset();
+        if (fd_ >= 0) close(fd_);
+    }
+    bool open(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        return fd_ >= 0;
+    }
+    const char* boundary() const { return boundary_; }
+    uint64_t content_length() const {
+        uint64_t total = closing().size();
+        for (size_t i = 0; i < ranges_.size(); ++i) total += part_header(i).size() + ranges_[i].length;
+        return total;
+    }
+    int64_t next(x_msg_t& out, uint32_t max_bytes) override {
+        int64_t appended = 0;
+        while (appended < static_cast<int64_t>(max_bytes) && !done_) {
+            if (part_ == ranges_.size()) {
+                std::string tail = closing();
+                if (!out.copy_in(pool_, tail.data(), static_cast<uint32_t>(tail.size()))) return -1;
+                appended += static_cast<int64_t>(tail.size());
+                done_ = true;
+                break;
+            }
+            if (!reader_) {
+                std::string head = part_header(part_);
+                if (!out.copy_in(pool_, head.data(), static_cast<uint32_t>(head.size()))) return -1;
+                appended += static_cast<int64_t>(head.size());
+                reader_.reset(new uring::FileReader(pool_, window_));
+                if (!reader_->open(fd_, ranges_[part_].first, ranges_[part_].length)) return -1;
+            }
+            if (reader_->remaining() > 0) {
+                int64_t n = reader_->next(out, max_bytes - static_cast<uint32_t>(appended));
+                if (n <= 0) return -1;
+                appended += n;
+                m_download_bytes.add(n);
+            }
+            if (reader_->remaining() == 0) {
+                reader_.reset();
+                ++part_;
+            }
+        }
+        return appended;
+    }
+
+private:
+    x_buf_pool_t& pool_;
+    uint32_t window_;
+    std::vector<http::ByteRange> ranges_;
+    uint64_t size_;
+    char boundary_[32];
+    int fd_{-1};
+    size_t part_{0};
+    bool done_{false};
+    std::unique_ptr<uring::FileReader> reader_;
+
+    std::string part_header(size_t i) const {
+        char buf[256];
+        const http::ByteRange& r = ranges_[i];
+        int n = std::snprintf(buf, sizeof(buf),
+            "%s--%s\r\nContent-Type: application/octet-stream\r\nContent-Range: bytes %llu-%llu/%llu\r\n\r\n",
+            i == 0 ? "" : "\r\n", boundary_, static_cast<unsigned long long>(r.first),
+            static_cast<unsigned long long>(r.first + r.length - 1), static_cast<unsigned long long>(size_));
+        return std::string(buf, static_cast<size_t>(n));
+    }
+    std::string closing() const {
+        return std::string("\r\n--") + boundary_ + "--\r\n";
+    }
+};
+
+// meta 中的 ISO8601 时间 / 请求头中的 HTTP-date（IMF-fixdate）转为 time_t，解析失败返回 -1
+static time_t parse_time(const std::string& s, const char* format) {
+    struct tm tm;
+    std::memset(&tm, 0, sizeof(tm));
+    const char* end = strptime(s.c_str(), format, &tm);
+    if (!end || *end) return -1;
+    return timegm(&tm);
+}
+static const char kIsoFormat[] = "%Y-%m-%dT%H:%M:%SZ";
+static const char kHttpDateFormat[] = "%a, %d %b %Y %H:%M:%S GMT";
+
+// 对象的 Last-Modified（HTTP-date）；meta 中为 ISO8601，解析失败返回空
+static std::string http_date(const std::string& iso8601) {
+    time_t t = parse_time(iso8601, kIsoFormat);
+    if (t < 0) return {};
+    struct tm gm;
+    if (!gmtime_r(&t, &gm)) return {};
+    char buf[64];
+    size_t n = strftime(buf, sizeof(buf), kHttpDateFormat, &gm);
+    return std::string(buf, n);
+}
+
+// If-Range 是否与当前对象一致（一致才按 Range 响应，否则回整个对象）。
+// 实体标签须为强标签且与 ETag 相同；日期须与 Last-Modified 完全相同。
+static bool if_range_matches(std::string_view if_range, const meta::Object& obj, const std::string& last_modified) {
+    if (if_range.empty()) return true;
+    if (if_range.front() == '"' || if_range.compare(0, 2, "W/") == 0) {
+        if (if_range.front() != '"' || if_range.size() < 2 || if_range.back() != '"') return false;
+        std::string_view tag = if_range.substr(1, if_range.size() - 2);
+        std::string_view etag = obj.etag;
+        if (etag.size() >= 2 && etag.front() == '"' && etag.back() == '"') etag = etag.substr(1, etag.size() - 2);
+        return !etag.empty() && tag == etag;
+    }
+    return !last_modified.empty() && if_range == last_modified;
+}
+
+// 条件 GET：If-None-Match（弱比较，* 匹配任意）命中，或没有 If-None-Match 且对象在 If-Modified-Since 之后未修改时，
+// 回 304。只看 meta，不碰对象文件
+static bool is_not_modified(const http::HttpRequest& req, const meta::Object& obj) {
+    std::string_view inm = req.header("If-None-Match");
+    if (!inm.empty()) {
+        if (obj.etag.empty()) return false;
+        size_t pos = 0;
+        while (pos < inm.size()) {
+            size_t comma = inm.find(',', pos);
+            if (comma == std::string_view::npos) comma = inm.size();
+            std::string_view tag = inm.substr(pos, comma - pos);
+            pos = comma + 1;
+            while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) tag.remove_prefix(1);
+            while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) tag.remove_suffix(1);
+            if (tag == "*") return true;
+            if (tag.compare(0, 2, "W/") == 0) tag.remove_prefix(2);
+            if (tag.size() >= 2 && tag.front() == '"' && tag.back() == '"') tag = tag.substr(1, tag.size() - 2);
+            if (tag == obj.etag) return true;
+        }
+        return false;
+    }
+    std::string_view ims = req.header("If-Modified-Since");
+    if (ims.empty()) return false;
+    time_t since = parse_time(std::string(ims), kHttpDateFormat);
+    time_t mtime = parse_time(obj.last_modified, kIsoFormat);
+    return since >= 0 && mtime >= 0 && mtime <= since;
+}
+
 /*  
     路由：
     管理级（仅 config.access_key 管理员）
     POST	/_admin/users	创建用户
     GET	/_admin/users	列出用户
+    GET	/_admin/stats	运行指标（metrics 计数器，JSON）
     桶/对象（均需 query 鉴权）
     GET	/getBucket/	列出当前用户所有桶
     GET	/getBucket/<bucket_name>	列出桶内对象
     GET	/getObject/<bucket_name>/<key>	获取对象内容
+    HEAD	/getObject/<bucket_name>/<key>	只取对象的响应头（大小、Last-Modified、ETag），仅查 meta
     PUT	/createBucket/<bucket_name>	创建桶
     PUT	/createObject/<bucket_name>/<key>	创建对象（body=文件内容）
     DELETE	/deleteBucket/<bucket_name>	删除桶
     DELETE	/deleteObject/<bucket_name>/<key>	删除对象
+    POST	/deleteObjects/<bucket_name>	批量删除（body 每行一个 key，最多 10000 个），逐 key 返回结果
+    分片上传（各分片可由不同连接并发上传，重传同号分片覆盖）
+    PUT	/initiateMultipartUpload/<bucket_name>/<key>	开始分片上传，返回 upload_id
+    PUT	/uploadPart/<bucket_name>/<key>?uploadId=&partNumber=N	上传第 N 个分片（1..10000，body=分片内容）
+    GET	/listParts/<bucket_name>/<key>?uploadId=	列出已上传的分片（用于续传）
+    PUT	/completeMultipartUpload/<bucket_name>/<key>?uploadId=	按分片号拼成对象（body 可选：逗号分隔的分片号）
+    DELETE	/abortMultipartUpload/<bucket_name>/<key>?uploadId=	放弃并删除已上传的分片
 */
 static bool is_admin(const http::HttpRequest& req, const s3config::Config& config) {
     return req.get_query_param("AWSAccessKeyId") == config.access_key;
 }
 
 bool handle_request(const http::HttpRequest& req, const s3config::Config& config,
-    meta::MetaStore& store, x_msg_t& out, x_buf_pool_t& pool, const x_msg_t* body_msg) {
+    meta::MetaStore& store, x_msg_t& out, x_buf_pool_t& pool, const x_msg_t* body_msg,
+    std::unique_ptr<BodySource>& body) {
     // ----- 管理级：创建/列举用户（仅管理员） -----
     if (req.path == "/_admin/users") {
         if (!is_admin(req, config)) {
@@ -277,6 +697,21 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
         return true;
     }
 
+    // ----- 管理级：运行指标（仅管理员） -----
+    if (req.path == "/_admin/stats") {
+        if (!is_admin(req, config)) {
+            write_error_response(out, pool, 403, "AccessDenied", "Admin only");
+            return true;
+        }
+        if (req.method != "GET") {
+            write_error_response(out, pool, 400, "BadRequest", "Use GET for stats");
+            return true;
+        }
+        std::string body = "{\"code\":1,\"stats\":" + metrics::to_json() + "}";
+        write_success_response(out, pool, body.data(), body.size());
+        return true;
+    }
+
     std::string bucket_name, object_key;
     PathAction action = parse_action_path(req.path, bucket_name, object_key);
     std::string request_owner_id = req.get_query_param("AWSAccessKeyId");
@@ -302,28 +737,73 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
             write_list_buckets_json(out, pool, buckets);
             return true;
         }
-        const meta::Bucket* b = store.get_bucket_by_name_and_owner(bucket_name, request_owner_id);
-        if (!b) {
+        meta::Bucket b;
+        if (!store.get_bucket_by_name_and_owner(bucket_name, request_owner_id, b)) {
             write_error_response(out, pool, 404, "NoSuchBucket", "Bucket not found");
             return true;
         }
-        std::vector<meta::Object> objs = store.list_objects(b->id);
-        write_list_json_from_meta(out, pool, bucket_name, objs);
+        std::string prefix = req.get_query_param("prefix");
+        std::string delimiter = req.get_query_param("delimiter");
+        std::string start_after = req.get_query_param("start-after");
+        std::string token = req.get_query_param("continuation-token");
+        std::string max_keys_param = req.get_query_param("max-keys");
+        if (!prefix.empty() || !delimiter.empty() || !start_after.empty() || !token.empty() ||
+            !max_keys_param.empty()) {
+            // 带任一分页参数时按页返回；都不带时保持原来的整桶列表
+            size_t max_keys = kListPageMaxKeys;
+            if (!max_keys_param.empty()) {
+                if (max_keys_param.size() > 9 || max_keys_param.find_first_not_of("0123456789") != std::string::npos) {
+                    write_error_response(out, pool, 400, "InvalidArgument", "max-keys must be a non-negative integer");
+                    return true;
+                }
+                max_keys = std::min<size_t>(std::strtoul(max_keys_param.c_str(), nullptr, 10), kListPageMaxKeys);
+            }
+            if (!token.empty()) {
+                // continuation-token 优先于 start-after
+                if (!decode_continuation_token(token, start_after)) {
+                    write_error_response(out, pool, 400, "InvalidArgument", "Invalid continuation-token");
+                    return true;
+                }
+            }
+            meta::ListPage page;
+            store.list_objects_page(b.id, prefix, delimiter, start_after, max_keys, page);
+            m_list_pages.add(1);
+            write_list_page_json(out, pool, bucket_name, prefix, delimiter, max_keys, page);
+            return true;
+        }
+        // 先取一页：不超过 kListStreamMin 个对象时整体返回，否则以 chunked 流式返回，其余各页由 ListBody 边发边取
+        meta::ListPage first;
+        store.list_objects_page(b.id, "", "", "", kListStreamMin, first);
+        if (!first.truncated) {
+            write_list_json_from_meta(out, pool, bucket_name, first.objects);
+            return true;
+        }
+        // HTTP/1.0 客户端不认识 chunked，仍整体返回
+        if (req.version == "HTTP/1.0") {
+            write_list_json_from_meta(out, pool, bucket_name, store.list_objects(b.id));
+            return true;
+        }
+        if (!write_chunked_response_head(out, pool, 200, "application/json")) return false;
+        body.reset(new ListBody(pool, store, b.id, bucket_name, std::move(first)));
         return true;
     }
     // ----- getObject -----
+    // HEAD 与 GET 同一路由：响应头相同（Content-Length 等全部来自 meta），HEAD 不打开对象文件，
+    // 响应体由 Session 统一去掉
     if (action == PathAction::GetObject) {
-        if (req.method != "GET") {
-            write_error_response(out, pool, 400, "BadRequest", "Use GET for getObject");
+        bool head = req.method == "HEAD";
+        if (req.method != "GET" && !head) {
+            write_error_response(out, pool, 400, "BadRequest", "Use GET or HEAD for getObject");
             return true;
         }
-        const meta::Bucket* b = store.get_bucket_by_name_and_owner(bucket_name, request_owner_id);
-        if (!b) {
+        if (head) m_head_requests.add(1);
+        meta::Bucket b;
+        if (!store.get_bucket_by_name_and_owner(bucket_name, request_owner_id, b)) {
             write_error_response(out, pool, 404, "NoSuchBucket", "Bucket not found");
             return true;
         }
         meta::Object obj;
-        if (!store.get_object(b->id, object_key, obj)) {
+        if (!store.get_object(b.id, object_key, obj)) {
             write_error_response(out, pool, 404, "NoSuchKey", "Object not found");
             return true;
         }
@@ -331,14 +811,63 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
             write_error_response(out, pool, 403, "Forbidden", "Invalid object path");
             return true;
         }
-        size_t fsize = static_cast<size_t>(obj.size);
-        std::vector<char> buf(fsize);
-        ssize_t n = uring::read_file(obj.storage_path, buf.data(), fsize);
-        if (n < 0 || static_cast<size_t>(n) != fsize) {
+        uint64_t fsize = static_cast<uint64_t>(obj.size);
+        // 校验器：客户端据此发 If-Range，保证分段续传拼出的是同一版本
+        std::string last_modified = http_date(obj.last_modified);
+        std::string headers = "Accept-Ranges: bytes\r\n";
+        if (!last_modified.empty()) headers += "Last-Modified: " + last_modified + "\r\n";
+        if (!obj.etag.empty()) headers += "ETag: \"" + obj.etag + "\"\r\n";
+        if (is_not_modified(req, obj)) {
+            m_not_modified.add(1);
+            return write_not_modified(out, pool, headers.c_str());
+        }
+
+        std::vector<http::ByteRange> ranges;
+        http::RangeResult rr = http::RangeResult::None;
+        std::string_view range_header = req.header("Range");
+        if (!range_header.empty() && if_range_matches(req.header("If-Range"), obj, last_modified))
+            rr = http::parse_range(range_header, fsize, ranges);
+        if (rr == http::RangeResult::Unsatisfiable) {
+            static const char kBody[] = "{\"code\":0,\"Code\":\"InvalidRange\",\"Message\":\"Requested range not satisfiable\"}";
+            headers += "Content-Range: bytes */" + std::to_string(fsize) + "\r\n";
+            return write_response(out, pool, 416, nullptr, kBody, sizeof(kBody) - 1, "application/json", headers.c_str());
+        }
+        if (rr == http::RangeResult::Satisfiable) m_range_requests.add(1);
+
+        if (rr == http::RangeResult::Satisfiable && ranges.size() > 1) {
+            std::unique_ptr<MultiRangeBody> parts(new MultiRangeBody(pool, config.download_window, std::move(ranges), fsize));
+            if (!head && !parts->open(obj.storage_path)) {
+                write_error_response(out, pool, 503, "InternalError", "Read failed");
+                return true;
+            }
+            std::string ctype = std::string("multipart/byteranges; boundary=") + parts->boundary();
+            if (!write_response(out, pool, 206, nullptr, nullptr, parts->content_length(), ctype.c_str(), headers.c_str()))
+                return false;
+            if (!head) body = std::move(parts);
+            return true;
+        }
+
+        // 整个对象或单个区间：FileBody 只读 [offset, offset+length)，4KB 的区间只产生 4KB 的磁盘读
+        uint64_t offset = 0;
+        uint64_t length = fsize;
+        int status = 200;
+        if (rr == http::RangeResult::Satisfiable) {
+            offset = ranges[0].first;
+            length = ranges[0].length;
+            status = 206;
+            headers += "Content-Range: bytes " + std::to_string(offset) + "-" + std::to_string(offset + length - 1) +
+                       "/" + std::to_string(fsize) + "\r\n";
+        }
+        if (head) return write_response(out, pool, status, nullptr, nullptr, length, "application/octet-stream", headers.c_str());
+        std::unique_ptr<FileBody> file(new FileBody(pool, config.download_window));
+        if (length > 0 && !file->open(obj.storage_path, offset, length)) {
             write_error_response(out, pool, 503, "InternalError", "Read failed");
             return true;
         }
-        write_response(out, pool, 200, "OK", buf.data(), fsize, "application/octet-stream");
+        // 只写响应头，body 由连接层从 FileBody 分段拉取：预读与发送重叠，内存占用与对象大小无关
+        if (!write_response(out, pool, status, nullptr, nullptr, length, "application/octet-stream", headers.c_str()))
+            return false;
+        if (length > 0) body = std::move(file);
         return true;
     }
     // ----- deleteBucket -----
@@ -347,23 +876,22 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
             write_error_response(out, pool, 400, "BadRequest", "Use DELETE for deleteBucket");
             return true;
         }
-        const meta::Bucket* b = store.get_bucket_by_name_and_owner(bucket_name, request_owner_id);
-        if (!b) {
+        meta::Bucket b;
+        if (!store.get_bucket_by_name_and_owner(bucket_name, request_owner_id, b)) {
             write_error_response(out, pool, 404, "NoSuchBucket", "Bucket not found");
             return true;
         }
-        std::vector<meta::Object> objs = store.list_objects(b->id);
-        if (!objs.empty()) {
+        if (store.has_objects(b.id)) {
             write_error_response(out, pool, 409, "BucketNotEmpty", "The bucket you tried to delete is not empty");
             return true;
         }
-        store.delete_bucket(b->id);
+        store.delete_bucket(b.id);
         if (!store.save()) {
             std::cerr << "[S3] Meta save failed: " << store.last_save_error() << std::endl;
             write_error_response(out, pool, 503, "InternalError", "Meta save failed");
             return true;
         }
-        std::string dir = bucket_dir_path(config, b->owner_id, bucket_name);
+        std::string dir = bucket_dir_path(config, b.owner_id, bucket_name);
         rmdir(dir.c_str());
         write_success_response(out, pool);
         return true;
@@ -374,13 +902,13 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
             write_error_response(out, pool, 400, "BadRequest", "Use DELETE for deleteObject");
             return true;
         }
-        const meta::Bucket* b = store.get_bucket_by_name_and_owner(bucket_name, request_owner_id);
-        if (!b) {
+        meta::Bucket b;
+        if (!store.get_bucket_by_name_and_owner(bucket_name, request_owner_id, b)) {
             write_error_response(out, pool, 404, "NoSuchBucket", "Bucket not found");
             return true;
         }
         meta::Object obj;
-        if (!store.get_object(b->id, object_key, obj)) {
+        if (!store.get_object(b.id, object_key, obj)) {
             write_error_response(out, pool, 404, "NoSuchKey", "Object not found");
             return true;
         }
@@ -392,7 +920,7 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
             write_error_response(out, pool, 503, "InternalError", "Delete failed");
             return true;
         }
-        store.delete_object(b->id, object_key);
+        store.delete_object(b.id, object_key);
         if (!store.save()) {
             std::cerr << "[S3] Meta save failed: " << store.last_save_error() << std::endl;
             write_error_response(out, pool, 503, "InternalError", "Meta save failed");
@@ -401,6 +929,84 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
         write_success_response(out, pool);
         return true;
     }
+    // ----- deleteObjects：批量删除 -----
+    // 一次加锁查出全部对象，经 io_uring 并发 unlink，再一次加锁删 meta、只持久化一次
+    if (action == PathAction::DeleteObjects) {
+        if (req.method != "POST") {
+            write_error_response(out, pool, 400, "BadRequest", "Use POST for deleteObjects");
+            return true;
+        }
+        meta::Bucket b;
+        if (!store.get_bucket_by_name_and_owner(bucket_name, request_owner_id, b)) {
+            write_error_response(out, pool, 404, "NoSuchBucket", "Bucket not found");
+            return true;
+        }
+        int64_t bucket_id = b.id;
+        std::string list;
+        if (body_msg && body_msg->total_length() > 0) {
+            list.resize(body_msg->total_length());
+            body_msg->copy_out(&list[0], static_cast<uint32_t>(list.size()));
+        }
+        // body 每行一个 key，忽略空行与行尾 \r；重复的 key 只处理一次
+        std::vector<std::string> keys;
+        std::unordered_set<std::string> seen;
+        for (size_t pos = 0; pos < list.size();) {
+            size_t nl = list.find('\n', pos);
+            if (nl == std::string::npos) nl = list.size();
+            std::string key = list.substr(pos, nl - pos);
+            pos = nl + 1;
+            if (!key.empty() && key.back() == '\r') key.pop_back();
+            if (key.empty() || !seen.insert(key).second) continue;
+            keys.push_back(std::move(key));
+        }
+        if (keys.empty() || keys.size() > kMaxBulkDeleteKeys) {
+            write_error_response(out, pool, 400, "BadRequest", "Body must list 1..10000 keys, one per line");
+            return true;
+        }
+        std::vector<const char*> result(keys.size(), "Deleted");
+        std::vector<meta::Object> objs;
+        store.get_objects(bucket_id, keys, objs);
+        std::vector<std::string> paths;
+        std::vector<size_t> path_key;  // paths[i] 对应的 keys 下标
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!is_object_key_safe(keys[i])) result[i] = "InvalidKey";
+            else if (objs[i].id == 0) result[i] = "NoSuchKey";
+            else if (!is_storage_path_safe(objs[i].storage_path, config.data_root)) result[i] = "Forbidden";
+            else {
+                paths.push_back(objs[i].storage_path);
+                path_key.push_back(i);
+            }
+        }
+        std::vector<int> unlinked;
+        uring::unlink_files(paths, unlinked);
+        std::vector<std::string> doomed;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (unlinked[i] == 0 || unlinked[i] == -ENOENT) doomed.push_back(keys[path_key[i]]);
+            else result[path_key[i]] = "InternalError";
+        }
+        // 查询与删除之间被并发 DELETE 删掉的 key，delete_objects 不计入，但文件与 key 都已不在，仍按 Deleted 计
+        size_t removed = doomed.empty() ? 0 : store.delete_objects(bucket_id, doomed);
+        size_t deleted = doomed.size();
+        if (removed > 0 && !store.save()) {
+            std::cerr << "[S3] Meta save failed: " << store.last_save_error() << std::endl;
+            write_error_response(out, pool, 503, "InternalError", "Meta save failed");
+            return true;
+        }
+        m_bulk_deleted.add(static_cast<int64_t>(deleted));
+        std::string json = "{\"code\":1,\"deleted\":" + std::to_string(deleted) +
+                           ",\"errors\":" + std::to_string(keys.size() - deleted) + ",\"results\":[";
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (i) json += ",";
+            json += "{\"Key\":\"";
+            json_escape_append(json, keys[i]);
+            json += "\",\"Status\":\"";
+            json += result[i];
+            json += "\"}";
+        }
+        json += "]}";
+        write_success_response(out, pool, json.data(), json.size());
+        return true;
+    }
     // ----- createBucket -----
     if (action == PathAction::CreateBucket) {
         if (req.method != "PUT") {
@@ -431,61 +1037,162 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
         write_success_response(out, pool);
         return true;
     }
-    // ----- createObject -----
-    if (action == PathAction::CreateObject) {
-        if (req.method != "PUT") {
-            write_error_response(out, pool, 400, "BadRequest", "Use PUT for createObject");
+    // ----- 分片上传：initiate / complete / abort / listParts（uploadPart 走上面的流式写盘） -----
+    if (action == PathAction::InitiateMultipart || action == PathAction::CompleteMultipart ||
+        action == PathAction::AbortMultipart || action == PathAction::ListParts) {
+        const char* method = action == PathAction::AbortMultipart ? "DELETE"
+                           : action == PathAction::ListParts ? "GET" : "PUT";
+        if (req.method != method) {
+            write_error_response(out, pool, 400, "BadRequest", "Unsupported method for multipart upload");
+            return true;
+        }
+        if (object_key.empty()) {
+            write_error_response(out, pool, 400, "BadRequest", "Invalid object key");
             return true;
         }
-        const meta::Bucket* b = store.get_bucket_by_name_and_owner(bucket_name, request_owner_id);
-        if (!b) {
+        meta::Bucket b;
+        if (!store.get_bucket_by_name_and_owner(bucket_name, request_owner_id, b)) {
             write_error_response(out, pool, 404, "NoSuchBucket", "Bucket not found");
             return true;
         }
+        int64_t bucket_id = b.id;
+        std::string owner_id = b.owner_id;
         meta::Object existing;
-        if (store.get_object(b->id, object_key, existing)) {
-            write_error_response(out, pool, 409, "ObjectAlreadyExists", "Object already exists");
+        if (action == PathAction::InitiateMultipart) {
+            if (store.get_object(bucket_id, object_key, existing)) {
+                write_error_response(out, pool, 409, "ObjectAlreadyExists", "Object already exists");
+                return true;
+            }
+            std::string upload_id;
+            if (!multipart_create(config.data_root, bucket_id, object_key, upload_id, config.durability == "full")) {
+                write_error_response(out, pool, 503, "InternalError", "Create upload failed");
+                return true;
+            }
+            std::string json = "{\"code\":1,\"upload_id\":\"" + upload_id + "\"}";
+            write_success_response(out, pool, json.data(), json.size());
             return true;
         }
-        std::string storage_path = object_storage_path(config, b->owner_id, bucket_name, object_key);
-        std::string dir = storage_path;
-        size_t slash = dir.rfind('/');
-        if (slash != std::string::npos) {
-            dir.resize(slash);
-            for (size_t i = 1; i < dir.size(); ++i) {
-                if (dir[i] == '/') {
-                    std::string sub = dir.substr(0, i);
-                    mkdir(sub.c_str(), 0755);
-                }
+        std::string upload_id = req.get_query_param("uploadId");
+        MultipartInfo info;
+        if (!multipart_lookup(config.data_root, upload_id, info) ||
+            info.bucket_id != bucket_id || info.key != object_key) {
+            write_error_response(out, pool, 404, "NoSuchUpload", "Upload not found");
+            return true;
+        }
+        if (action == PathAction::AbortMultipart) {
+            multipart_remove(config.data_root, upload_id);
+            write_success_response(out, pool);
+            return true;
+        }
+        std::vector<MultipartPart> parts;
+        if (!multipart_list_parts(config.data_root, upload_id, parts)) {
+            write_error_response(out, pool, 404, "NoSuchUpload", "Upload not found");
+            return true;
+        }
+        if (action == PathAction::ListParts) {
+            std::string json = "{\"code\":1,\"parts\":[";
+            for (size_t i = 0; i < parts.size(); ++i) {
+                if (i) json += ",";
+                json += "{\"part_number\":" + std::to_string(parts[i].number) +
+                        ",\"size\":" + std::to_string(static_cast<unsigned long long>(parts[i].size)) + "}";
+            }
+            json += "]}";
+            write_success_response(out, pool, json.data(), json.size());
+            return true;
+        }
+        // complete：body 为逗号分隔、严格递增的分片号，省略时使用已上传的全部分片
+        if (body_msg && body_msg->total_length() > 0) {
+            std::string list(body_msg->total_length(), '\0');
+            body_msg->copy_out(&list[0], static_cast<uint32_t>(list.size()));
+            std::vector<MultipartPart> chosen;
+            size_t next = 0;
+            uint32_t prev = 0;
+            bool ok = true;
+            for (size_t i = 0; ok && i <= list.size(); ++i) {
+                if (i < list.size() && list[i] != ',') continue;
+                std::string num = list.substr(next, i - next);
+                while (!num.empty() && (num.back() == ' ' || num.back() == '\n' || num.back() == '\r')) num.pop_back();
+                while (!num.empty() && num[0] == ' ') num.erase(0, 1);
+                next = i + 1;
+                uint32_t n = num.empty() || num.size() > 5 || num.find_first_not_of("0123456789") != std::string::npos
+                                 ? 0 : static_cast<uint32_t>(std::strtoul(num.c_str(), nullptr, 10));
+                if (n <= prev) { ok = false; break; }
+                prev = n;
+                auto it = std::lower_bound(parts.begin(), parts.end(), n,
+                    [](const MultipartPart& p, uint32_t v) { return p.number < v; });
+                if (it == parts.end() || it->number != n) { ok = false; break; }
+                chosen.push_back(*it);
             }
-            mkdir(dir.c_str(), 0755);
-        }
-        if (!body_msg || body_msg->total_length() == 0) {
-            write_error_response(out, pool, 400, "BadRequest", "Missing or empty body; file content required");
-            return true;
-        }
-        size_t need = body_msg->total_length();
-        time_t now_t = time(nullptr);
-        struct tm* tm = gmtime(&now_t);
-        char mtime_buf[32];
-        if (tm) strftime(mtime_buf, sizeof(mtime_buf), "%Y-%m-%dT%H:%M:%SZ", tm);
-        else mtime_buf[0] = '\0';
-        std::string last_modified(mtime_buf);
-        std::vector<char> buf(need);
-        body_msg->copy_out(buf.data(), static_cast<uint32_t>(need));
-        ssize_t w = uring::write_file(storage_path, buf.data(), need);
-        if (w < 0 || static_cast<size_t>(w) != need) {
+            if (!ok) {
+                write_error_response(out, pool, 400, "InvalidPart", "Part list must be ascending uploaded part numbers");
+                return true;
+            }
+            parts.swap(chosen);
+        }
+        if (parts.empty()) {
+            write_error_response(out, pool, 400, "InvalidPart", "No parts uploaded");
+            return true;
+        }
+        // 先占住 key，拼接期间同名的 PUT 或另一个 complete 回 409；put_object 前失败时解除
+        if (!store.reserve_object(bucket_id, object_key)) {
+            write_error_response(out, pool, 409, "ObjectAlreadyExists", "Object already exists");
+            return true;
+        }
+        // 在内核中把分片拼到临时文件（不经用户态缓冲），再 rename 成正式对象
+        std::string storage_path = object_storage_path(config, owner_id, bucket_name, object_key);
+        std::vector<std::string> new_dirs;
+        make_parent_dirs(storage_path, &new_dirs);
+        std::string tmp_path = new_upload_tmp_path(config);
+        uint64_t total = 0;
+        if (!multipart_assemble(config.data_root, upload_id, parts, tmp_path, total)) {
+            std::cerr << "[S3] assemble multipart upload failed: " << upload_id << " errno=" << errno << std::endl;
+            store.release_object(bucket_id, object_key);
+            write_error_response(out, pool, 503, "InternalError", "Assemble failed");
+            return true;
+        }
+        m_multipart_assembled.add(total);
+        if (rename(tmp_path.c_str(), storage_path.c_str()) != 0) {
+            std::cerr << "[S3] rename upload failed: " << storage_path << " errno=" << errno << std::endl;
+            unlink(tmp_path.c_str());
+            store.release_object(bucket_id, object_key);
+            write_error_response(out, pool, 503, "InternalError", "Write failed");
+            return true;
+        }
+        if (!sync_new_file(config, storage_path, new_dirs)) {
+            std::cerr << "[S3] sync upload failed: " << storage_path << " errno=" << errno << std::endl;
             unlink(storage_path.c_str());
+            store.release_object(bucket_id, object_key);
             write_error_response(out, pool, 503, "InternalError", "Write failed");
             return true;
         }
-        store.put_object(b->id, object_key, static_cast<int64_t>(need), last_modified, "", storage_path, "private");
+        std::vector<std::string> part_etags;
+        for (const MultipartPart& p : parts) {
+            part_etags.push_back(multipart_read_part_etag(config.data_root, upload_id, p.number));
+        }
+        std::string etag = multipart_etag(part_etags);
+        if (etag.empty()) etag = version_etag(static_cast<int64_t>(total));
+        store.put_object(bucket_id, object_key, static_cast<int64_t>(total), now_iso8601(), etag, storage_path, "private");
         if (!store.save()) {
             std::cerr << "[S3] Meta save failed: " << store.last_save_error() << std::endl;
             write_error_response(out, pool, 503, "InternalError", "Meta save failed");
             return true;
         }
-        write_success_response(out, pool);
+        multipart_remove(config.data_root, upload_id);
+        std::string json = "{\"code\":1,\"size\":" + std::to_string(static_cast<unsigned long long>(total)) +
+                           ",\"parts\":" + std::to_string(parts.size()) + ",\"etag\":\"" + etag + "\"}";
+        write_success_response(out, pool, json.data(), json.size());
+        return true;
+    }
+    // ----- createObject / uploadPart -----
+    // 带 body 的 PUT 由连接层走 ObjectUpload 流式写盘，这里只会遇到缺 body 等需直接回错误的情况
+    if (action == PathAction::CreateObject || action == PathAction::UploadPart) {
+        ObjectUpload upload(config, store, pool);
+        if (!upload.begin(req, out)) return true;
+        if (body_msg && !upload.append(*body_msg)) {
+            write_error_response(out, pool, 503, "InternalError", "Write failed");
+            return true;
+        }
+        upload.finish(out);
         return true;
     }
 
@@ -493,4 +1200,238 @@ bool handle_request(const http::HttpRequest& req, const s3config::Config& config
     return true;
 }
 
+bool accept_request_body(const http::HttpRequest& req, const s3config::Config& config,
+    meta::MetaStore& store, x_msg_t& out, x_buf_pool_t& pool) {
+    static const char kAdminPrefix[] = "/_admin/";
+    if (req.path.compare(0, sizeof(kAdminPrefix) - 1, kAdminPrefix) == 0) {
+        if (is_admin(req, config)) return true;
+        write_error_response(out, pool, 403, "AccessDenied", "Admin only");
+        return false;
+    }
+    std::string bucket_name, object_key;
+    PathAction action = parse_action_path(req.path, bucket_name, object_key);
+    if (action == PathAction::None) {
+        write_error_response(out, pool, 400, "BadRequest", "Unsupported method or path");
+        return false;
+    }
+    if (bucket_name.empty() || action == PathAction::CreateBucket) return true;
+    if (!is_bucket_name_safe(bucket_name)) {
+        write_error_response(out, pool, 400, "BadRequest", "Invalid bucket name");
+        return false;
+    }
+    std::string owner_id = req.get_query_param("AWSAccessKeyId");
+    if (owner_id.empty()) owner_id = config.access_key;
+    meta::Bucket b;
+    if (!store.get_bucket_by_name_and_owner(bucket_name, owner_id, b)) {
+        write_error_response(out, pool, 404, "NoSuchBucket", "Bucket not found");
+        return false;
+    }
+    if (action == PathAction::CompleteMultipart) {
+        MultipartInfo info;
+        if (!multipart_lookup(config.data_root, req.get_query_param("uploadId"), info) ||
+            info.bucket_id != b.id || info.key != object_key) {
+            write_error_response(out, pool, 404, "NoSuchUpload", "Upload not found");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool is_streaming_upload(const http::HttpRequest& req) {
+    static const char kPrefix[] = "/createObject/";
+    static const char kPartPrefix[] = "/uploadPart/";
+    return req.method == "PUT" && (req.content_length > 0 || req.is_chunked()) &&
+           (req.path.compare(0, sizeof(kPrefix) - 1, kPrefix) == 0 ||
+            req.path.compare(0, sizeof(kPartPrefix) - 1, kPartPrefix) == 0);
+}
+
+ObjectUpload::ObjectUpload(const s3config::Config& config, meta::MetaStore& store, x_buf_pool_t& pool)
+    : config_(config), store_(store), pool_(pool) {}
+
+ObjectUpload::~ObjectUpload() {
+    discard();
+}
+
+// 关闭并删除未完成的临时文件
+void ObjectUpload::discard() {
+    if (writer_) {
+        writer_->finish();
+        writer_.reset();
+        m_upload_active.sub();
+    }
+    if (!tmp_path_.empty()) {
+        unlink(tmp_path_.c_str());
+        tmp_path_.clear();
+    }
+    if (reserved_) {
+        store_.release_object(bucket_id_, object_key_);
+        reserved_ = false;
+    }
+}
+
+bool ObjectUpload::begin(const http::HttpRequest& req, x_msg_t& out) {
+    if (req.method != "PUT") {
+        write_error_response(out, pool_, 400, "BadRequest", "Use PUT for createObject/uploadPart");
+        return false;
+    }
+    std::string bucket_name;
+    PathAction action = parse_action_path(req.path, bucket_name, object_key_);
+    if ((action != PathAction::CreateObject && action != PathAction::UploadPart) ||
+        !is_bucket_name_safe(bucket_name) || object_key_.empty() || !is_object_key_safe(object_key_)) {
+        write_error_response(out, pool_, 400, "BadRequest", "Invalid bucket name or object key");
+        return false;
+    }
+    std::string owner_id = req.get_query_param("AWSAccessKeyId");
+    if (owner_id.empty()) owner_id = config_.access_key;
+    meta::Bucket b;
+    if (!store_.get_bucket_by_name_and_owner(bucket_name, owner_id, b)) {
+        write_error_response(out, pool_, 404, "NoSuchBucket", "Bucket not found");
+        return false;
+    }
+    bucket_id_ = b.id;
+    if (action == PathAction::UploadPart) {
+        // 分片写到该上传的暂存区，不检查对象是否已存在（complete 时再检查）
+        std::string part = req.get_query_param("partNumber");
+        unsigned long n = part.empty() || part.size() > 5 || part.find_first_not_of("0123456789") != std::string::npos
+                              ? 0 : std::strtoul(part.c_str(), nullptr, 10);
+        if (n == 0 || n > kMaxPartNumber) {
+            write_error_response(out, pool_, 400, "InvalidPartNumber", "partNumber must be 1..10000");
+            return false;
+        }
+        upload_id_ = req.get_query_param("uploadId");
+        MultipartInfo info;
+        if (!multipart_lookup(config_.data_root, upload_id_, info) ||
+            info.bucket_id != bucket_id_ || info.key != object_key_) {
+            write_error_response(out, pool_, 404, "NoSuchUpload", "Upload not found");
+            return false;
+        }
+        part_number_ = static_cast<uint32_t>(n);
+    } else {
+        // 对象不可覆盖：先占住 key，同名的并发上传在这里就回 409，不会 rename 到同一 storage_path
+        if (!store_.reserve_object(bucket_id_, object_key_)) {
+            write_error_response(out, pool_, 409, "ObjectAlreadyExists", "Object already exists");
+            return false;
+        }
+        reserved_ = true;
+    }
+    if (!req.is_chunked() && req.content_length <= 0) {
+        write_error_response(out, pool_, 400, "BadRequest", "Missing or empty body; file content required");
+        return false;
+    }
+    expected_ = req.is_chunked() ? -1 : req.content_length;
+    if (part_number_ != 0) {
+        storage_path_ = multipart_part_path(config_.data_root, upload_id_, part_number_);
+    } else {
+        storage_path_ = object_storage_path(config_, b.owner_id, bucket_name, object_key_);
+        make_parent_dirs(storage_path_, &new_dirs_);
+    }
+    if (!req.content_md5.empty()) {
+        unsigned char digest[kMd5Size];
+        if (!decode_content_md5(req.content_md5, digest)) {
+            write_error_response(out, pool_, 400, "InvalidDigest", "Content-MD5 is not a base64 MD5");
+            return false;
+        }
+        content_md5_.assign(reinterpret_cast<const char*>(digest), kMd5Size);
+    }
+    if (config_.etag_hash == "md5" || !content_md5_.empty()) md5_.reset(new Md5Stream());
+    tmp_path_ = new_upload_tmp_path(config_);
+    writer_.reset(new uring::FileWriter(config_.upload_window));
+    m_upload_active.add();
+    if (!writer_->open(tmp_path_)) {
+        std::cerr << "[S3] open upload file failed: " << tmp_path_ << " errno=" << errno << std::endl;
+        discard();
+        write_error_response(out, pool_, 503, "InternalError", "Write failed");
+        return false;
+    }
+    return true;
+}
+
+bool ObjectUpload::append(const x_msg_t& data) {
+    if (!writer_ || !writer_->append(data)) return false;
+    if (md5_) md5_->update(data);
+    m_upload_bytes.add(data.total_length());
+    return true;
+}
+
+void ObjectUpload::finish(x_msg_t& out) {
+    if (!writer_) {
+        write_error_response(out, pool_, 503, "InternalError", "Write failed");
+        return;
+    }
+    bool ok = writer_->finish();
+    int64_t written = static_cast<int64_t>(writer_->size());
+    m_upload_inflight_max.update_max(writer_->max_inflight());
+    writer_.reset();
+    m_upload_active.sub();
+    if (!ok || (expected_ >= 0 && written != expected_)) {
+        discard();
+        write_error_response(out, pool_, 503, "InternalError", "Write failed");
+        return;
+    }
+    if (written == 0) {
+        // chunked body 解出来为空
+        discard();
+        write_error_response(out, pool_, 400, "BadRequest", "Missing or empty body; file content required");
+        return;
+    }
+    std::string etag;
+    if (md5_) {
+        unsigned char digest[kMd5Size];
+        md5_->final(digest);
+        md5_.reset();
+        if (!content_md5_.empty() && content_md5_.compare(0, kMd5Size, reinterpret_cast<const char*>(digest), kMd5Size) != 0) {
+            discard();
+            write_error_response(out, pool_, 400, "BadDigest", "Content-MD5 does not match the body");
+            return;
+        }
+        etag = hex_digest(digest, kMd5Size);
+    }
+    if (part_number_ != 0) {
+        // 分片的 MD5 供 complete 计算整体 ETag；没有 MD5 时删掉同号旧分片留下的
+        multipart_write_part_etag(config_.data_root, upload_id_, part_number_, etag, config_.durability == "full");
+        // 分片：原子替换同号的旧分片；上传在写盘期间被 abort 时暂存目录已不存在
+        if (rename(tmp_path_.c_str(), storage_path_.c_str()) != 0) {
+            discard();
+            write_error_response(out, pool_, 404, "NoSuchUpload", "Upload not found");
+            return;
+        }
+        tmp_path_.clear();
+        if (!sync_new_file(config_, storage_path_, new_dirs_)) {
+            std::cerr << "[S3] sync part failed: " << storage_path_ << " errno=" << errno << std::endl;
+            write_error_response(out, pool_, 503, "InternalError", "Write failed");
+            return;
+        }
+        std::string body = "{\"code\":1,\"part_number\":" + std::to_string(part_number_) +
+                           ",\"size\":" + std::to_string(static_cast<long long>(written)) +
+                           ",\"etag\":\"" + etag + "\"}";
+        write_success_response(out, pool_, body.data(), body.size());
+        return;
+    }
+    if (rename(tmp_path_.c_str(), storage_path_.c_str()) != 0) {
+        std::cerr << "[S3] rename upload failed: " << storage_path_ << " errno=" << errno << std::endl;
+        discard();
+        write_error_response(out, pool_, 503, "InternalError", "Write failed");
+        return;
+    }
+    tmp_path_.clear();
+    if (!sync_new_file(config_, storage_path_, new_dirs_)) {
+        std::cerr << "[S3] sync upload failed: " << storage_path_ << " errno=" << errno << std::endl;
+        unlink(storage_path_.c_str());
+        discard();
+        write_error_response(out, pool_, 503, "InternalError", "Write failed");
+        return;
+    }
+    if (etag.empty()) etag = version_etag(written);
+    store_.put_object(bucket_id_, object_key_, written, now_iso8601(), etag, storage_path_, "private");
+    reserved_ = false;
+    if (!store_.save()) {
+        std::cerr << "[S3] Meta save failed: " << store_.last_save_error() << std::endl;
+        write_error_response(out, pool_, 503, "InternalError", "Meta save failed");
+        return;
+    }
+    std::string body = "{\"code\":1,\"etag\":\"" + etag + "\"}";
+    std::string header = "ETag: \"" + etag + "\"\r\n";
+    write_response(out, pool_, 200, "OK", body.data(), body.size(), "application/json", header.c_str());
+}
+
 }
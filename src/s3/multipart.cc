@@ -0,0 +1,199 @@
+#include "s3/multipart.h"
+#include "io_uring/file_io.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace s3 {
+
+static const char kInfoFile[] = "info";
+static const char kPartPrefix[] = "part-";
+
+static std::string multipart_root(const std::string& data_root) {
+    std::string p = data_root;
+    if (!p.empty() && p.back() != '/') p += '/';
+    p += ".multipart";
+    return p;
+}
+
+// upload_id 只允许 32 位小写十六进制，拼进路径前先校验，防止路径穿越
+static bool is_upload_id_valid(const std::string& id) {
+    if (id.size() != 32) return false;
+    for (char c : id) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+std::string multipart_dir(const std::string& data_root, const std::string& upload_id) {
+    return multipart_root(data_root) + "/" + upload_id;
+}
+
+std::string multipart_part_path(const std::string& data_root, const std::string& upload_id, uint32_t part) {
+    return multipart_dir(data_root, upload_id) + "/" + kPartPrefix + std::to_string(part);
+}
+
+bool multipart_write_part_etag(const std::string& data_root, const std::string& upload_id, uint32_t part,
+                               const std::string& etag, bool sync) {
+    std::string path = multipart_part_path(data_root, upload_id, part) + ".etag";
+    if (etag.empty()) {
+        unlink(path.c_str());
+        return true;
+    }
+    return uring::write_file(path, etag.data(), etag.size(), sync) == static_cast<ssize_t>(etag.size());
+}
+
+std::string multipart_read_part_etag(const std::string& data_root, const std::string& upload_id, uint32_t part) {
+    char buf[64];
+    ssize_t n = uring::read_file(multipart_part_path(data_root, upload_id, part) + ".etag", buf, sizeof(buf));
+    if (n <= 0) return {};
+    return std::string(buf, static_cast<size_t>(n));
+}
+
+bool multipart_create(const std::string& data_root, int64_t bucket_id, const std::string& key, std::string& upload_id,
+                      bool sync) {
+    std::string root = multipart_root(data_root);
+    mkdir(root.c_str(), 0755);
+    static thread_local std::mt19937_64 rng(std::random_device{}());
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        char id[33];
+        std::snprintf(id, sizeof(id), "%016llx%016llx", static_cast<unsigned long long>(rng()),
+                      static_cast<unsigned long long>(rng()));
+        std::string dir = root + "/" + id;
+        if (mkdir(dir.c_str(), 0755) != 0) {
+            if (errno == EEXIST) continue;
+            return false;
+        }
+        std::string info = std::to_string(static_cast<long long>(bucket_id)) + "\t" + key + "\n";
+        std::string info_path = dir + "/" + kInfoFile;
+        if (uring::write_file(info_path, info.data(), info.size(), sync) != static_cast<ssize_t>(info.size()) ||
+            (sync && !uring::sync_paths({dir, root, data_root}, false))) {
+            unlink(info_path.c_str());
+            rmdir(dir.c_str());
+            return false;
+        }
+        upload_id = id;
+        return true;
+    }
+    return false;
+}
+
+bool multipart_lookup(const std::string& data_root, const std::string& upload_id, MultipartInfo& info) {
+    if (!is_upload_id_valid(upload_id)) return false;
+    std::string path = multipart_dir(data_root, upload_id) + "/" + kInfoFile;
+    char buf[4096];
+    ssize_t n = uring::read_file(path, buf, sizeof(buf));
+    if (n <= 0) return false;
+    std::string s(buf, static_cast<size_t>(n));
+    size_t tab = s.find('\t');
+    if (tab == std::string::npos || s.back() != '\n') return false;
+    info.bucket_id = std::strtoll(s.substr(0, tab).c_str(), nullptr, 10);
+    info.key = s.substr(tab + 1, s.size() - tab - 2);
+    return true;
+}
+
+bool multipart_list_parts(const std::string& data_root, const std::string& upload_id, std::vector<MultipartPart>& parts) {
+    parts.clear();
+    std::string dir = multipart_dir(data_root, upload_id);
+    DIR* d = opendir(dir.c_str());
+    if (!d) return false;
+    const size_t prefix_len = sizeof(kPartPrefix) - 1;
+    while (struct dirent* e = readdir(d)) {
+        std::string name = e->d_name;
+        if (name.compare(0, prefix_len, kPartPrefix) != 0) continue;
+        std::string num = name.substr(prefix_len);
+        if (num.empty() || num.size() > 5 || num.find_first_not_of("0123456789") != std::string::npos) continue;
+        uint32_t n = static_cast<uint32_t>(std::strtoul(num.c_str(), nullptr, 10));
+        if (n == 0 || n > kMaxPartNumber) continue;
+        struct stat st;
+        if (stat((dir + "/" + name).c_str(), &st) != 0) continue;
+        parts.push_back(MultipartPart{n, static_cast<uint64_t>(st.st_size)});
+    }
+    closedir(d);
+    std::sort(parts.begin(), parts.end(),
+              [](const MultipartPart& a, const MultipartPart& b) { return a.number < b.number; });
+    return true;
+}
+
+// 把 in 的 len 字节复制到 out 的 *out_off 处：优先 copy_file_range，跨文件系统等不支持时退回 sendfile（仍在内核中）
+static bool copy_range(int in, int out, uint64_t len, loff_t* out_off) {
+    loff_t in_off = 0;
+    bool use_cfr = true;
+    while (len > 0) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(len, 1u << 30));
+        ssize_t n;
+        if (use_cfr) {
+            n = copy_file_range(in, &in_off, out, out_off, chunk, 0);
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL)) {
+                use_cfr = false;
+                continue;
+            }
+        } else {
+            if (lseek(out, *out_off, SEEK_SET) < 0) return false;
+            off_t off = static_cast<off_t>(in_off);
+            n = sendfile(out, in, &off, chunk);
+            if (n > 0) {
+                in_off = off;
+                *out_off += n;
+            }
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return false;  // 分片比 stat 时短
+        len -= static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool multipart_assemble(const std::string& data_root, const std::string& upload_id,
+                        const std::vector<MultipartPart>& parts, const std::string& dst, uint64_t& total) {
+    int out = ::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) return false;
+    loff_t off = 0;
+    bool ok = true;
+    for (const MultipartPart& p : parts) {
+        int in = ::open(multipart_part_path(data_root, upload_id, p.number).c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            ok = false;
+            break;
+        }
+        ok = copy_range(in, out, p.size, &off);
+        ::close(in);
+        if (!ok) break;
+    }
+    if (::close(out) != 0) ok = false;
+    if (!ok) {
+        unlink(dst.c_str());
+        return false;
+    }
+    total = static_cast<uint64_t>(off);
+    return true;
+}
+
+void multipart_remove(const std::string& data_root, const std::string& upload_id) {
+    if (!is_upload_id_valid(upload_id)) return;
+    std::string dir = multipart_dir(data_root, upload_id);
+    DIR* d = opendir(dir.c_str());
+    if (d) {
+        while (struct dirent* e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name == "." || name == "..") continue;
+            unlink((dir + "/" + name).c_str());
+        }
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+}
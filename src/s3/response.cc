@@ -9,32 +9,61 @@ static const char* status_phrase(int code) {
     switch (code) {
         case 200: return "OK";
         case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
         case 403: return "Forbidden";
         case 404: return "Not Found";
         case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 416: return "Range Not Satisfiable";
+        case 501: return "Not Implemented";
         case 503: return "Service Unavailable";
         default:  return "Unknown";
     }
 }
 
-void write_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
-    const char* phrase, const char* body, size_t body_len,
-    const char* content_type) {
+// 状态行 + length_line（Content-Length 或 Transfer-Encoding，304 时为空）+ Content-Type + extra_headers + 空行
+static bool write_head(x_msg_t& out, x_buf_pool_t& pool, int status_code, const char* phrase,
+    const char* length_line, const char* content_type, const char* extra_headers) {
     out.clear();
+    bool ok = true;
     char line[256];
     int n = std::snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", status_code, phrase ? phrase : status_phrase(status_code));
-    if (n > 0 && n < (int)sizeof(line)) out.copy_in(pool, line, static_cast<uint32_t>(n));
-    n = std::snprintf(line, sizeof(line), "Content-Length: %zu\r\n", body_len);
-    if (n > 0 && n < (int)sizeof(line)) out.copy_in(pool, line, static_cast<uint32_t>(n));
-    if (content_type && content_type[0]) {
+    if (n > 0 && n < (int)sizeof(line)) ok = out.copy_in(pool, line, static_cast<uint32_t>(n));
+    if (ok && length_line[0]) ok = out.copy_in(pool, length_line, static_cast<uint32_t>(std::strlen(length_line)));
+    if (ok && content_type && content_type[0]) {
         n = std::snprintf(line, sizeof(line), "Content-Type: %s\r\n", content_type);
-        if (n > 0 && n < (int)sizeof(line)) out.copy_in(pool, line, static_cast<uint32_t>(n));
+        if (n > 0 && n < (int)sizeof(line)) ok = out.copy_in(pool, line, static_cast<uint32_t>(n));
     }
-    out.copy_in(pool, "\r\n", 2);
-    if (body && body_len > 0) out.copy_in(pool, body, static_cast<uint32_t>(body_len));
+    if (ok && extra_headers && extra_headers[0])
+        ok = out.copy_in(pool, extra_headers, static_cast<uint32_t>(std::strlen(extra_headers)));
+    if (ok) ok = out.copy_in(pool, "\r\n", 2);
+    if (!ok) out.clear();
+    return ok;
+}
+
+bool write_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
+    const char* phrase, const char* body, size_t body_len,
+    const char* content_type, const char* extra_headers) {
+    char length_line[64];
+    std::snprintf(length_line, sizeof(length_line), "Content-Length: %zu\r\n", body_len);
+    bool ok = write_head(out, pool, status_code, phrase, length_line, content_type, extra_headers);
+    if (ok && body && body_len > 0) ok = out.copy_in(pool, body, static_cast<uint32_t>(body_len));
+    if (!ok) out.clear();
+    return ok;
+}
+
+bool write_chunked_response_head(x_msg_t& out, x_buf_pool_t& pool, int status_code,
+    const char* content_type, const char* extra_headers) {
+    return write_head(out, pool, status_code, nullptr, "Transfer-Encoding: chunked\r\n", content_type, extra_headers);
+}
+
+bool write_not_modified(x_msg_t& out, x_buf_pool_t& pool, const char* extra_headers) {
+    return write_head(out, pool, 304, nullptr, "", nullptr, extra_headers);
 }
 
-void write_error_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
+bool write_error_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
     const char* code, const char* message) {
     const char* c = code ? code : "Error";
     const char* m = message ? message : "";
@@ -50,7 +79,7 @@ void write_error_response(x_msg_t& out, x_buf_pool_t& pool, int status_code,
     msg_esc[j] = '\0';
     int n = std::snprintf(body, sizeof(body), "{\"code\":0,\"Code\":\"%s\",\"Message\":\"%s\"}", c, msg_esc);
     if (n <= 0 || n >= (int)sizeof(body)) n = static_cast<int>(std::strlen(body));
-    write_response(out, pool, status_code, status_phrase(status_code), body, static_cast<size_t>(n), "application/json");
+    return write_response(out, pool, status_code, status_phrase(status_code), body, static_cast<size_t>(n), "application/json");
 }
 
 void write_success_response(x_msg_t& out, x_buf_pool_t& pool, const char* json_body, size_t json_len) {
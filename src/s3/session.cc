@@ -0,0 +1,344 @@
+#include "s3/session.h"
+#include "s3/auth.h"
+#include "s3/handler.h"
+#include "s3/response.h"
+#include "http/http_parser.h"
+#include "config/config.h"
+#include "meta/meta.h"
+#include "metrics/metrics.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace s3 {
+
+static const uint32_t kMaxHeader = 65536;
+// 限制 body 大小，防止 Content-Length 导致 OOM
+static const int64_t kMaxContentLength = 1024 * 1024 * 1024;  // 1024MB
+// 流式上传不在内存中累积 body，上限按 S3 单次 PUT 的 5GB
+static const int64_t kMaxUploadLength = 5LL * 1024 * 1024 * 1024;
+// 流式响应体每次交给驱动方发送的上限
+static const uint32_t kBodySendBytes = 256 * 1024;
+
+static metrics::Counter& m_zero_copy_bytes = metrics::counter("download.zero_copy_bytes");
+static metrics::Counter& m_continue_sent = metrics::counter("request.continue_sent");
+static metrics::Counter& m_rejected_requests = metrics::counter("request.rejected_before_body");
+static metrics::Counter& m_rejected_body_bytes = metrics::counter("request.rejected_body_bytes");
+
+Session::Session(const s3config::Config& config, meta::MetaStore& store, x_buf_pool_t& pool)
+    : config_(config), store_(store), pool_(pool) {}
+
+net::IoAction Session::on_input() {
+    if (header_len_ == 0) {
+        header_len_ = scanner_.scan(in_, kMaxHeader);
+        if (header_len_ == 0) {
+            if (in_.total_length() < kMaxHeader) return net::IoAction::Recv;
+            return fail(400, "BadRequest", "Request header too large");
+        }
+        if (!http::parse_request(in_, header_len_, req_))
+            return fail(400, "BadRequest", "Invalid request");
+        // 显示 HTTP 请求（请求行 + 主要头）
+        {
+            std::cout << ">>> " << req_.method << " " << req_.path;
+            if (!req_.query.empty()) std::cout << "?" << req_.query;
+            if (!req_.host.empty()) std::cout << " Host: " << req_.host;
+            if (req_.content_length >= 0) std::cout << " Content-Length: " << req_.content_length;
+            std::cout << std::endl;
+        }
+        // 无 Content-Length 时视为无 body（如 GET）；chunked 时忽略 Content-Length，body 长度解码完才知道
+        chunked_ = req_.is_chunked();
+        if (!req_.transfer_encoding.empty() && !chunked_)
+            return fail(501, "NotImplemented", "Unsupported Transfer-Encoding");
+        content_length_ = !chunked_ && req_.content_length > 0 ? req_.content_length : 0;
+        chunk_offset_ = header_len_;
+        bool streaming = is_streaming_upload(req_);
+        if (content_length_ > (streaming ? kMaxUploadLength : kMaxContentLength))
+            return fail(413, "EntityTooLarge", "Content-Length exceeds limit");
+        ++requests_;
+        keep_alive_ = req_.wants_keep_alive() && config_.keepalive_timeout_ms > 0 &&
+                      requests_ < config_.keepalive_max_requests;
+        // 同时带 Transfer-Encoding 与 Content-Length 的请求边界有歧义，处理完即关闭
+        if (chunked_ && req_.content_length >= 0) keep_alive_ = false;
+        // 有 body 的请求先验签并做不依赖 body 的检查，不通过时直接回错误、不收 body
+        if (content_length_ > 0 || chunked_) {
+            if (!verify_query_signature(req_, config_, store_)) {
+                write_error_response(out_, pool_, 403, "AccessDenied", "Signature does not match");
+                return reject_body();
+            }
+            verified_ = true;
+            if (streaming) return start_work(Step::BeginUpload);  // 建目录、打开临时文件
+            if (!accept_request_body(req_, config_, store_, out_, pool_)) return reject_body();
+            if (req_.expects_continue()) return send_continue();
+        }
+    }
+    return continue_input();
+}
+
+net::IoAction Session::continue_input() {
+    if (streaming_) return stream_body();
+    if (chunked_) {
+        // body 解码到 chunk_body_（视图），收完后本请求在 in_ 中占 header_len_ + content_length_ 字节
+        http::ChunkedDecoder::Status st = decoder_.decode(in_, chunk_offset_, chunk_body_);
+        if (st == http::ChunkedDecoder::Status::Error) return fail(400, "BadRequest", "Invalid chunked body");
+        if (static_cast<int64_t>(decoder_.body_size()) > kMaxContentLength)
+            return fail(413, "EntityTooLarge", "Body exceeds limit");
+        if (st == http::ChunkedDecoder::Status::NeedMore) return net::IoAction::Recv;
+        content_length_ = chunk_offset_ - header_len_;
+    } else if (static_cast<int64_t>(in_.total_length()) < static_cast<int64_t>(header_len_) + content_length_) {
+        return net::IoAction::Recv;
+    }
+    return start_work(Step::Process);
+}
+
+net::IoAction Session::work() {
+    Step step = step_;
+    step_ = Step::None;
+    switch (step) {
+    case Step::BeginUpload: return begin_upload();
+    case Step::WriteBody: return write_body();
+    case Step::WriteChunked: return write_chunked_body();
+    case Step::Process:
+        process();
+        return respond();
+    case Step::NextBody: return next_body();
+    case Step::None: break;
+    }
+    return net::IoAction::Close;
+}
+
+net::IoAction Session::start_work(Step step) {
+    step_ = step;
+    return net::IoAction::Work;
+}
+
+net::IoAction Session::on_sent() {
+    if (interim_) {
+        // 100 Continue 已发出，继续收 body（客户端可能在此之前已经开始发送）
+        interim_ = false;
+        out_.clear();
+        return on_input();
+    }
+    if (sending_file_) {
+        m_zero_copy_bytes.add(static_cast<int64_t>(file_.length));
+        sending_file_ = false;
+        file_ = net::FileSegment();
+        body_.reset();
+    }
+    if (body_) return start_work(Step::NextBody);  // 取下一段可能要等预读
+    return next_request();
+}
+
+net::IoAction Session::next_body() {
+    out_.clear();
+    int64_t n = body_->next(out_, kBodySendBytes);
+    if (n > 0) return net::IoAction::Send;
+    body_.reset();
+    if (n < 0) return net::IoAction::Close;  // 头已发出，只能断开让客户端发现 body 不完整
+    return next_request();
+}
+
+net::IoAction Session::next_request() {
+    if (!keep_alive_) return net::IoAction::Close;
+    // 出队已处理的请求，保留其后已收到的流水线数据（流式上传的头与 body 在接收过程中已出队）
+    if (!streaming_) in_.consume(header_len_ + static_cast<uint32_t>(content_length_));
+    out_.clear();
+    scanner_.reset();
+    header_len_ = 0;
+    content_length_ = 0;
+    streaming_ = false;
+    verified_ = false;
+    chunked_ = false;
+    chunk_offset_ = 0;
+    chunk_body_.clear();
+    chunk_error_ = 0;
+    chunk_done_ = false;
+    decoder_.reset();
+    if (in_.total_length() > 0) return on_input();
+    return net::IoAction::Recv;
+}
+
+net::IoAction Session::respond() {
+    static const char kClose[] = "Connection: close\r\n";
+    static const char kKeepAlive[] = "Connection: keep-alive\r\n";
+    // 连错误响应都写不出（池耗尽）：直接断开，不发半个响应
+    if (out_.total_length() == 0) return net::IoAction::Close;
+    // HEAD：与 GET 相同的响应头，去掉 body（含错误响应的 body）
+    if (req_.method == "HEAD") {
+        body_.reset();
+        sending_file_ = false;
+        strip_body();
+    }
+    // HTTP/1.1 默认保持连接，只有关闭时才需声明；HTTP/1.0 需显式 keep-alive
+    const char* line = nullptr;
+    if (!keep_alive_) line = kClose;
+    else if (req_.version == "HTTP/1.0") line = kKeepAlive;
+    if (line) {
+        char status[128];
+        uint32_t n = out_.copy_out(status, sizeof(status));
+        const void* eol = memmem(status, n, "\r\n", 2);
+        uint32_t pos = eol ? static_cast<uint32_t>(static_cast<const char*>(eol) - status) + 2 : 0;
+        if (pos == 0 || !out_.insert(pool_, pos, line, static_cast<uint32_t>(strlen(line))))
+            keep_alive_ = false;  // 插不进去时至少保证按关闭处理，客户端以 EOF 判定结束
+    }
+    return sending_file_ ? net::IoAction::SendFile : net::IoAction::Send;
+}
+
+net::IoAction Session::begin_upload() {
+    upload_.reset(new ObjectUpload(config_, store_, pool_));
+    if (!upload_->begin(req_, out_)) {
+        upload_.reset();
+        return reject_body();
+    }
+    start_upload();
+    if (req_.expects_continue()) return send_continue();
+    return continue_input();
+}
+
+void Session::start_upload() {
+    in_.consume(header_len_);
+    streaming_ = true;
+    body_left_ = content_length_;
+}
+
+net::IoAction Session::send_continue() {
+    static const char kContinue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    out_.clear();
+    if (!out_.copy_in(pool_, kContinue, sizeof(kContinue) - 1)) {
+        // 发不出 100 也不影响正确性：客户端等待超时后会直接发 body
+        out_.clear();
+        return on_input();
+    }
+    m_continue_sent.add();
+    interim_ = true;
+    return net::IoAction::Send;
+}
+
+net::IoAction Session::stream_body() {
+    if (chunked_) return stream_chunked_body();
+    uint32_t avail = static_cast<uint32_t>(std::min<int64_t>(in_.total_length(), body_left_));
+    // 攒够一个 buffer 再提交写，避免大量小写；最后一段不足也照写
+    if (avail < body_left_ && avail < config_.buffer_payload_size) return net::IoAction::Recv;
+    return start_work(Step::WriteBody);
+}
+
+net::IoAction Session::write_body() {
+    uint32_t avail = static_cast<uint32_t>(std::min<int64_t>(in_.total_length(), body_left_));
+    if (avail > 0) {
+        x_msg_t piece;
+        piece.append_view(in_, 0, avail);
+        in_.consume(avail);
+        body_left_ -= avail;
+        if (!upload_->append(piece)) {
+            upload_.reset();
+            if (body_left_ > 0) keep_alive_ = false;  // 剩余 body 未读，无法继续复用连接
+            write_error_response(out_, pool_, 503, "InternalError", "Write failed");
+            return respond();
+        }
+    }
+    if (body_left_ > 0) return net::IoAction::Recv;
+    upload_->finish(out_);
+    upload_.reset();
+    return respond();
+}
+
+net::IoAction Session::stream_chunked_body() {
+    uint32_t offset = 0;
+    http::ChunkedDecoder::Status st = decoder_.decode(in_, offset, chunk_body_);
+    in_.consume(offset);
+    if (st == http::ChunkedDecoder::Status::Error)
+        chunk_error_ = 400;
+    else if (static_cast<int64_t>(decoder_.body_size()) > kMaxUploadLength)
+        chunk_error_ = 413;
+    chunk_done_ = st == http::ChunkedDecoder::Status::Done;
+    // 与定长 body 一样攒够一个 buffer 再提交写
+    if (chunk_error_ == 0 && !chunk_done_ && chunk_body_.total_length() < config_.buffer_payload_size)
+        return net::IoAction::Recv;
+    return start_work(Step::WriteChunked);
+}
+
+net::IoAction Session::write_chunked_body() {
+    int status = chunk_error_;
+    if (status == 0 && chunk_body_.total_length() > 0) {
+        if (!upload_->append(chunk_body_)) status = 503;
+        chunk_body_.clear();
+    }
+    if (status != 0) {
+        const char* error = status == 503 ? "Write failed" : status == 413 ? "Body exceeds limit" : "Invalid chunked body";
+        upload_.reset();
+        if (!chunk_done_) keep_alive_ = false;  // 剩余 body 未读，无法继续复用连接
+        write_error_response(out_, pool_, status, status == 503 ? "InternalError" : "BadRequest", error);
+        return respond();
+    }
+    if (!chunk_done_) return net::IoAction::Recv;
+    upload_->finish(out_);
+    upload_.reset();
+    return respond();
+}
+
+net::IoAction Session::reject_body() {
+    // 已经到达的 body 字节白收了（客户端没等 100 Continue 就发送时）
+    int64_t arrived = static_cast<int64_t>(in_.total_length()) - header_len_;
+    if (!chunked_) arrived = std::min(arrived, content_length_);
+    m_rejected_requests.add();
+    if (arrived > 0) m_rejected_body_bytes.add(arrived);
+    // body 已全部在缓冲里时照常出队并保持连接，否则回完错误即关闭（chunked body 的边界未知，一律关闭）
+    if (chunked_ ||
+        static_cast<int64_t>(in_.total_length()) < static_cast<int64_t>(header_len_) + content_length_)
+        keep_alive_ = false;
+    return respond();
+}
+
+void Session::strip_body() {
+    // 响应头长度不设上限：按 segment 增量扫描整个 out_ 找 \r\n\r\n
+    http::HeaderScanner scanner;
+    uint32_t len = scanner.scan(out_, out_.total_length());
+    if (len == 0) {
+        // 找不到头部结尾时无法去掉 body，发出后不能再在该连接上继续下一个请求
+        keep_alive_ = false;
+        return;
+    }
+    if (len == out_.total_length()) return;
+    x_msg_t header;
+    header.append_view(out_, 0, len);
+    out_.clear();
+    out_.append_view(header, 0, len);
+}
+
+net::IoAction Session::fail(int status, const char* code, const char* message) {
+    keep_alive_ = false;
+    write_error_response(out_, pool_, status, code, message);
+    return respond();
+}
+
+void Session::process() {
+    if (!verified_ && !verify_query_signature(req_, config_, store_)) {
+        write_error_response(out_, pool_, 403, "AccessDenied", "Signature does not match");
+        return;
+    }
+    x_msg_t body_msg;
+    const x_msg_t* body_ptr = nullptr;
+    if (chunked_) {
+        if (chunk_body_.total_length() > 0) body_ptr = &chunk_body_;
+    } else if (content_length_ > 0) {
+        // body 以视图方式引用 in_ 中的 unit，不拷贝
+        body_msg.append_view(in_, header_len_, static_cast<uint32_t>(content_length_));
+        body_ptr = &body_msg;
+    }
+    if (!handle_request(req_, config_, store_, out_, pool_, body_ptr, body_)) {
+        body_.reset();
+        write_error_response(out_, pool_, 503, "ServiceUnavailable", "Buffer pool exhausted");
+        return;
+    }
+    // 原样的文件内容走零拷贝：响应头发完后由驱动方 sendfile/splice
+    if (body_ && config_.zero_copy && body_->file_range(file_.fd, file_.offset, file_.length)) {
+        sending_file_ = true;
+        return;
+    }
+    // 流式 body 的第一段随响应头一起发送；此时头还没发出，取不到数据仍可改回错误响应
+    if (body_ && body_->next(out_, kBodySendBytes) <= 0) {
+        body_.reset();
+        write_error_response(out_, pool_, 503, "InternalError", "Read failed");
+    }
+}
+
+}
@@ -1,13 +1,13 @@
 #include "config/config.h"
 #include "msg/msg_buffer4.h"
-#include "http/http_parser.h"
-#include "http/http_request.h"
 #include "net/listener.h"
 #include "net/connection.h"
+#include "net/reactor.h"
+#include "net/worker_pool.h"
 #include "meta/meta.h"
-#include "s3/auth.h"
-#include "s3/handler.h"
-#include "s3/response.h"
+#include "io_uring/file_io.h"
+#include "s3/session.h"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <csignal>
@@ -16,6 +16,7 @@
 #include <vector>
 #include <memory>
 #include <unistd.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <cerrno>
 #include <cstring>
@@ -51,56 +52,12 @@ static void signal_handler(int) {
     g_shutdown_requested.store(true, std::memory_order_relaxed);
 }
 
-static void handle_client(int fd, x_buf_pool_t& pool, const s3config::Config& config, meta::MetaStore& store) {
-    x_msg_t req_msg;
-    int64_t content_length = -1;
-    int n = net::read_request(fd, req_msg, pool, content_length);
-    if (n <= 0) {
-        net::close_fd(fd);
-        return;
-    }
-    http::HttpRequest req;
-    if (!http::parse_request(req_msg, req)) {
-        x_msg_t resp_msg;
-        s3::write_error_response(resp_msg, pool, 400, "BadRequest", "Invalid request");
-        net::write_response(fd, resp_msg);
-        net::close_fd(fd);
-        return;  
-    }
-    // 显示 HTTP 请求（请求行 + 主要头）
-    {
-        std::string uri = req.path;
-        if (!req.query.empty()) uri += "?" + req.query;
-        std::cout << ">>> " << req.method << " " << uri;
-        if (!req.host.empty()) std::cout << " Host: " << req.host;
-        if (req.content_length >= 0) std::cout << " Content-Length: " << req.content_length;
-        std::cout << std::endl;
-    }
-    if (!s3::verify_query_signature(req, config, store)) {
-        x_msg_t resp_msg;
-        s3::write_error_response(resp_msg, pool, 403, "AccessDenied", "Signature does not match");
-        net::write_response(fd, resp_msg);
-        net::close_fd(fd);
-        return;
-    }
-    x_msg_t body_msg;
-    const x_msg_t* body_ptr = nullptr;
-    if (content_length > 0) {
-        std::vector<char> linear(req_msg.total_length());
-        req_msg.copy_out(linear.data(), req_msg.total_length());
-        const char* end = std::strstr(linear.data(), "\r\n\r\n");
-        uint32_t header_end = end ? static_cast<uint32_t>(end + 4 - linear.data()) : 0;
-        if (header_end < req_msg.total_length() && static_cast<int64_t>(req_msg.total_length() - header_end) >= content_length) {
-            body_msg.copy_in(pool, linear.data() + header_end, static_cast<uint32_t>(content_length));
-            body_ptr = &body_msg;
-        }
-    }
-    x_msg_t resp_msg;
-    if (!s3::handle_request(req, config, store, resp_msg, pool, body_ptr)) {
-        s3::write_error_response(resp_msg, pool, 503, "ServiceUnavailable", "Buffer pool exhausted");
-    }
-    net::write_response(fd, resp_msg);
-    net::close_fd(fd);
+static void handle_client(int fd, x_buf_pool_t& pool, const s3config::Config& config, meta::MetaStore& store,
+                          const net::WorkerPool& workers) {
+    s3::Session session(config, store, pool);
+    int request_timeout_ms = config.request_timeout_ms > 0 ? static_cast<int>(config.request_timeout_ms) : -1;
+    net::serve_connection(fd, session, pool, static_cast<int>(config.keepalive_timeout_ms), request_timeout_ms,
+                          [&workers]() { return workers.reclaim_idle(); });
 }
 
 int main() {
@@ -111,6 +68,9 @@ int main() {
         std::cerr << "cannot create data_root: " << config.data_root << std::endl;
         return 1;
     }
+    // 两种格式的快照都能读；下次 checkpoint 改写成配置的格式（如文本快照在首次 checkpoint 时转成二进制）
+    store.set_snapshot_format(config.meta_snapshot_format == "text" ? meta::SnapshotFormat::text
+                                                                    : meta::SnapshotFormat::binary);
     if (!store.load(config.data_root)) {
         std::cerr << "meta load failed: data_root=" << config.data_root << std::endl;
         return 1;
@@ -122,17 +82,36 @@ int main() {
         return 1;
     }
     if (!store.save()) {
-        std::cerr << "meta save failed (user.dat): " << store.last_save_error() << std::endl;
+        std::cerr << "meta save failed (journal): " << store.last_save_error() << std::endl;
         return 1;
     }
+    store.start_checkpointer(config.meta_checkpoint_bytes);
     x_buf_pool_t pool(config.buffer_payload_size, config.buffer_count);
-    int listen_fd = net::listen_tcp(config.listen_addr, config.listen_port);
-    if (listen_fd < 0) {
-        std::cerr << "listen failed on " << config.listen_addr << ":" << config.listen_port << std::endl;
-        return 1;
+    // listeners > 1 时开启 SO_REUSEPORT，同一端口多个监听 socket，由内核按四元组哈希把连接分到各 socket
+    net::ListenOptions listen_opts;
+    listen_opts.backlog = static_cast<int>(config.listen_backlog);
+    listen_opts.reuse_port = config.listeners > 1;
+    listen_opts.defer_accept_secs = static_cast<int>(config.tcp_defer_accept);
+    std::vector<int> listen_fds;
+    for (uint32_t i = 0; i < config.listeners; ++i) {
+        int fd = net::listen_tcp(config.listen_addr, config.listen_port, listen_opts);
+        if (fd < 0) {
+            std::cerr << "listen failed on " << config.listen_addr << ":" << config.listen_port << std::endl;
+            for (int l : listen_fds) close(l);
+            return 1;
+        }
+        listen_fds.push_back(fd);
     }
     std::cout << "S3 server listening on " << config.listen_addr << ":" << config.listen_port
-              << " data_root=" << config.data_root << std::endl;
+              << " data_root=" << config.data_root << " listeners=" << config.listeners
+              << " backlog=" << config.listen_backlog << (config.pin_cpus ? " pin_cpus=1" : "") << std::endl;
+    if (config.durability != "none") {
+        // 对象文件与（full 时）元数据日志的 fsync 经后台线程组提交
+        uring::start_group_commit(config.commit_window_us);
+        if (config.durability == "full")
+            store.set_journal_sync([](const std::vector<int>& fds) { return uring::sync_files(fds, true); });
+        std::cout << "durability=" << config.durability << " commit_window_us=" << config.commit_window_us << std::endl;
+    }
 
     struct sigaction sa {};
     sa.sa_handler = signal_handler;
@@ -141,19 +120,86 @@ int main() {
     sigaction(SIGINT, &sa, nullptr);
     sigaction(SIGTERM, &sa, nullptr);
 
-    while (!g_shutdown_requested.load()) {
-        int fd = net::accept_one(listen_fd);
-        if (fd < 0) {
-            if (g_shutdown_requested.load()) break;
-            continue;
+    if (config.io_mode == "uring") {
+        // io_uring 事件循环：第 i 个循环在 listen_fds[i % listeners] 上挂 multishot accept；
+        // 循环数取 max(event_loops, listeners)，保证每个 SO_REUSEPORT socket 都有循环在 accept，
+        // 否则内核哈希到无人 accept 的 socket 上的连接会一直滞留在 backlog 中
+        net::HandlerFactory factory = [&config, &store, &pool]() -> std::unique_ptr<net::ConnHandler> {
+            return std::unique_ptr<net::ConnHandler>(new s3::Session(config, store, pool));
+        };
+        const uint32_t event_loops = std::max<uint32_t>(config.event_loops, static_cast<uint32_t>(listen_fds.size()));
+        std::cout << "io_mode=uring event_loops=" << event_loops << " work_threads=" << config.work_threads
+                  << std::endl;
+        std::vector<std::thread> loops;
+        std::atomic<bool> loop_failed{false};
+        for (uint32_t i = 0; i < event_loops; ++i) {
+            int listen_fd = listen_fds[i % listen_fds.size()];
+            loops.emplace_back([&, i, listen_fd]() {
+                if (config.pin_cpus) net::pin_current_thread(static_cast<int>(i));
+                int request_timeout_ms = config.request_timeout_ms > 0 ? static_cast<int>(config.request_timeout_ms) : -1;
+                if (!net::run_event_loop(listen_fd, pool, factory, static_cast<int>(config.keepalive_timeout_ms),
+                                         request_timeout_ms, config.recv_buffers, config.work_threads,
+                                         g_shutdown_requested)) {
+                    loop_failed.store(true);
+                    g_shutdown_requested.store(true);
+                }
+            });
         }
-        std::thread(handle_client, fd, std::ref(pool), std::cref(config), std::ref(store)).detach();
+        for (std::thread& t : loops) t.join();
+        for (int fd : listen_fds) close(fd);
+        if (loop_failed.load()) {
+            std::cerr << "io_uring event loop failed to start" << std::endl;
+            uring::stop_group_commit();
+            return 1;
+        }
+        std::cout << "Shutting down: event loops stopped." << std::endl;
+    } else {
+        // 每个监听 socket 一组：accept 线程 + 固定工作线程池，线程数与队列按组均分；
+        // pin_cpus 时把在线核均分给各组（组数多于核数时每组一核、循环复用），accept 线程绑本组第一个核，
+        // 工作线程轮流分布在本组的核区间内，连接从 accept 到处理不跨组
+        const uint32_t groups = static_cast<uint32_t>(listen_fds.size());
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        const uint32_t ncpu = online > 0 ? static_cast<uint32_t>(online) : 1;
+        const uint32_t per_group = std::max<uint32_t>(1, ncpu / groups);
+        std::cout << "io_mode=thread worker_threads=" << config.worker_threads
+                  << " accept_queue_depth=" << config.accept_queue_depth << " groups=" << groups << std::endl;
+        std::vector<std::unique_ptr<net::WorkerPool>> pools;
+        pools.reserve(groups);
+        std::vector<std::thread> acceptors;
+        for (uint32_t g = 0; g < groups; ++g) {
+            int cpu = config.pin_cpus ? static_cast<int>((g * per_group) % ncpu) : -1;
+            uint32_t workers = (config.worker_threads + groups - 1 - g) / groups;
+            uint32_t depth = (config.accept_queue_depth + groups - 1 - g) / groups;
+            // 连接在 accept 线程启动后才会提交，此时 pools[g] 已就位（已 reserve，后续 emplace 不会搬移）
+            pools.emplace_back(new net::WorkerPool(workers, depth,
+                [&pool, &config, &store, &pools, g](int fd) { handle_client(fd, pool, config, store, *pools[g]); },
+                cpu, static_cast<int>(per_group)));
+            net::WorkerPool* workers_group = pools.back().get();
+            int listen_fd = listen_fds[g];
+            acceptors.emplace_back([workers_group, listen_fd, cpu]() {
+                if (cpu >= 0) net::pin_current_thread(cpu);
+                while (!g_shutdown_requested.load()) {
+                    int fd = net::accept_one(listen_fd);
+                    if (fd < 0) {
+                        if (g_shutdown_requested.load()) break;
+                        if (errno == EINVAL) break;  // 监听 socket 已被 shutdown
+                        continue;
+                    }
+                    if (!workers_group->submit(fd)) net::close_fd(fd);
+                }
+            });
+        }
+        // 信号只会打断某一个线程的 accept，主线程轮询标志后 shutdown 全部监听 socket 以唤醒其余 accept 线程
+        while (!g_shutdown_requested.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::cout << "Shutting down: stopping accept, waiting for in-flight requests..." << std::endl;
+        for (int fd : listen_fds) shutdown(fd, SHUT_RDWR);
+        for (std::thread& t : acceptors) t.join();
+        for (int fd : listen_fds) close(fd);
+        for (auto& p : pools) p->stop(std::chrono::seconds(5));
     }
-
-    std::cout << "Shutting down: stopping accept, waiting for in-flight requests..." << std::endl;
-    close(listen_fd);
-    listen_fd = -1;
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    uring::stop_group_commit();
+    store.stop_checkpointer();
     std::cout << "Server exited." << std::endl;
     return 0;
 }